@@ -0,0 +1,252 @@
+#include "VoterArray.hpp"
+#include "DataArray.hpp"
+#include "RandomEngine.hpp"
+#include "Timer.hpp"
+#include "getTimeStamp.hpp"
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <cstdlib>
+#include <memory>
+
+/**
+ *\file
+ *\brief Microbenchmarks of the key paths, printed as JSON for tracking regressions between releases.
+ *
+ * Usage: voterBenchmark [minimum seconds] [length...]
+ *
+ * Every benchmark runs its operation in batches, doubling the batch until one takes the minimum time,
+ * 0.2 seconds by default, then times five batches of that size and reports the median time per
+ * operation. The lattice benchmarks run on square lattices of the given lengths, 64 256 1024 and 4096 by
+ * default, and the DataArray ones on series of length squared samples so both cover the same range of
+ * sizes. Run through make bench, which writes the results to bench.json.
+ *
+ * A small lattice reaches consensus within the time of a batch, after which an update can no longer
+ * change anything, so the update and sweep benchmarks start a fresh lattice whenever theirs has frozen
+ * and every timed update is one the dynamics could make.
+ */
+namespace
+{
+	/// Keeps results alive so the compiler cannot drop the work that produced them.
+	volatile double sink;
+
+	/**
+	 *\struct Result
+	 *\brief Timing of one benchmark at one size.
+	 */
+	struct Result
+	{
+		/// Name of the operation.
+		std::string name;
+		/// Lattice length or series length.
+		long long size;
+		/// Number of operations in a timed batch.
+		long long operations;
+		/// Median time per operation in nanoseconds.
+		double nanoseconds;
+	};
+
+	/**
+	 *\brief Times an operation.
+	 *\param operation runs the operation the given number of times and returns the number of work items done.
+	 *\param minimumSeconds minimum time of a timed batch.
+	 *\param operations set to the number of work items in a timed batch.
+	 *\return median time per work item in nanoseconds.
+	 */
+	double measure(const std::function<long long(long long)> &operation, double minimumSeconds, long long &operations)
+	{
+		long long repeats = 1;
+		while(true)
+		{
+			Timer timer;
+			operations = operation(repeats);
+			if(timer.elapsed() >= minimumSeconds || repeats >= (1LL << 40))
+			{
+				break;
+			}
+			repeats *= 2;
+		}
+
+		std::vector<double> times;
+		for(int batch = 0; batch < 5; ++batch)
+		{
+			Timer timer;
+			operations = operation(repeats);
+			times.push_back(timer.elapsed() * 1e9 / operations);
+		}
+		std::sort(times.begin(), times.end());
+		return times[times.size() / 2];
+	}
+
+	/**
+	 *\brief Escapes a string for a JSON string literal.
+	 */
+	std::string escape(const std::string &text)
+	{
+		std::string escaped;
+		for(char ch : text)
+		{
+			if(ch == '"' || ch == '\\')
+			{
+				escaped += '\\';
+			}
+			escaped += ch;
+		}
+		return escaped;
+	}
+}
+
+int main(int argc, char const *argv[])
+{
+	double minimumSeconds = argc > 1 ? std::atof(argv[1]) : 0.2;
+	std::vector<int> lengths;
+	for(int arg = 2; arg < argc; ++arg)
+	{
+		lengths.push_back(std::atoi(argv[arg]));
+	}
+	if(lengths.empty())
+	{
+		lengths = {64, 256, 1024, 4096};
+	}
+	if(minimumSeconds <= 0 || *std::min_element(lengths.begin(), lengths.end()) < 2)
+	{
+		std::cerr << "Usage: " << argv[0] << " [minimum seconds] [length...]\n";
+		return 1;
+	}
+
+	std::vector<Result> results;
+	auto run = [&](const std::string &name, long long size, const std::function<long long(long long)> &operation)
+	{
+		Result result{name, size, 0, 0};
+		result.nanoseconds = measure(operation, minimumSeconds, result.operations);
+		results.push_back(result);
+		std::cerr << name << ' ' << size << ' ' << result.nanoseconds << " ns\n";
+	};
+
+	for(int length : lengths)
+	{
+		long long siteCount = static_cast<long long>(length) * length;
+		RandomEngine generator(12345);
+		std::unique_ptr<VoterArray> latticePointer(new VoterArray(generator, length, length, 0.0));
+
+		// The lattice, replaced by a fresh one if it has frozen.
+		auto live = [&]() -> VoterArray&
+		{
+			if(latticePointer->frozen())
+			{
+				latticePointer.reset(new VoterArray(generator, length, length, 0.0));
+			}
+			return *latticePointer;
+		};
+
+		// Construction, per site.
+		run("constructor", length, [&](long long repeats)
+		{
+			for(long long repeat = 0; repeat < repeats; ++repeat)
+			{
+				VoterArray fresh(generator, length, length, 0.0);
+				sink = fresh.orderParameter();
+			}
+			return repeats * siteCount;
+		});
+
+		// Single random sequential updates, per update.
+		run("update", length, [&](long long repeats)
+		{
+			for(long long repeat = 0; repeat < repeats; ++repeat)
+			{
+				live().update(generator);
+			}
+			return repeats;
+		});
+
+		// Whole sweeps, per update.
+		run("sweep", length, [&](long long repeats)
+		{
+			for(long long repeat = 0; repeat < repeats; ++repeat)
+			{
+				live().sweep(generator);
+			}
+			return repeats * siteCount;
+		});
+
+		// The running order parameter, per call.
+		run("orderParameter", length, [&](long long repeats)
+		{
+			double sum = 0;
+			for(long long repeat = 0; repeat < repeats; ++repeat)
+			{
+				sum += live().orderParameter();
+			}
+			sink = sum;
+			return repeats;
+		});
+
+		// Text output of the lattice, per site.
+		run("operator<<", length, [&](long long repeats)
+		{
+			for(long long repeat = 0; repeat < repeats; ++repeat)
+			{
+				std::ostringstream out;
+				out << live();
+				sink = static_cast<double>(out.tellp());
+			}
+			return repeats * siteCount;
+		});
+
+		// An order parameter series as long as the lattice has sites.
+		DataArray series(siteCount);
+		double value = 0;
+		for(long long sample = 0; sample < siteCount; ++sample)
+		{
+			value = 0.9 * value + generator.uniform() - 0.5;
+			series.push_back(value);
+		}
+
+		// Error of the mean, per sample.
+		run("DataArray::error", siteCount, [&](long long repeats)
+		{
+			for(long long repeat = 0; repeat < repeats; ++repeat)
+			{
+				sink = series.error();
+			}
+			return repeats * siteCount;
+		});
+
+		// The full autocorrelation function, per sample.
+		run("DataArray::autoCorrelation", siteCount, [&](long long repeats)
+		{
+			for(long long repeat = 0; repeat < repeats; ++repeat)
+			{
+				sink = series.autoCorrelation().back();
+			}
+			return repeats * siteCount;
+		});
+	}
+
+	// One object per measurement, with enough about the build to compare like with like.
+	std::cout << "{\n";
+	std::cout << "  \"date\": \"" << escape(getTimeStamp()) << "\",\n";
+	std::cout << "  \"compiler\": \"" << escape(__VERSION__) << "\",\n";
+#ifdef NDEBUG
+	std::cout << "  \"assertions\": false,\n";
+#else
+	std::cout << "  \"assertions\": true,\n";
+#endif
+	std::cout << "  \"minimumSeconds\": " << minimumSeconds << ",\n";
+	std::cout << "  \"results\": [\n";
+	for(std::size_t i = 0; i < results.size(); ++i)
+	{
+		const Result &result = results[i];
+		std::cout << "    {\"name\": \"" << escape(result.name) << "\", \"size\": " << result.size
+		          << ", \"operations\": " << result.operations << ", \"nanosecondsPerOperation\": " << result.nanoseconds
+		          << ", \"operationsPerSecond\": " << 1e9 / result.nanoseconds << '}' << (i + 1 < results.size() ? "," : "") << '\n';
+	}
+	std::cout << "  ]\n";
+	std::cout << "}\n";
+
+	return 0;
+}
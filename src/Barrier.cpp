@@ -0,0 +1,24 @@
+#include "Barrier.hpp"
+
+Barrier::Barrier(int threadCount) : m_threadCount{threadCount}, m_waiting{threadCount}, m_generation{0}
+{
+
+}
+
+void Barrier::wait()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	unsigned long generation = m_generation;
+
+	// The last thread to arrive opens the barrier for everyone else.
+	if(--m_waiting == 0)
+	{
+		++m_generation;
+		m_waiting = m_threadCount;
+		m_condition.notify_all();
+		return;
+	}
+
+	m_condition.wait(lock, [this, generation]{ return generation != m_generation; });
+}
@@ -0,0 +1,46 @@
+#ifndef Barrier_hpp
+#define Barrier_hpp
+
+#include <mutex>
+#include <condition_variable>
+
+/**
+ *\file
+ *\class Barrier
+ *\brief Reusable synchronisation point for a fixed number of threads.
+ *
+ * Every thread calling wait() blocks until the given number of threads have called it, then all
+ * of them are released and the barrier can be used again.
+ */
+class Barrier
+{
+private:
+	/// Number of threads that have to arrive before the barrier opens.
+	int m_threadCount;
+
+	/// Number of threads still to arrive in the current generation.
+	int m_waiting;
+
+	/// Incremented every time the barrier opens so waiting threads can tell it has.
+	unsigned long m_generation;
+
+	/// Guards the counters.
+	std::mutex m_mutex;
+
+	/// Used to release the waiting threads.
+	std::condition_variable m_condition;
+
+public:
+	/**
+	 *\brief Constructor.
+	 *\param threadCount number of threads that synchronise on this barrier.
+	 */
+	explicit Barrier(int threadCount);
+
+	/**
+	 *\brief Blocks until all threads have arrived.
+	 */
+	void wait();
+};
+
+#endif /* Barrier_hpp */
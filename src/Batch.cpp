@@ -0,0 +1,388 @@
+#include "Batch.hpp"
+#include "FixedVoterArray.hpp"
+#include "RejectionFreeEngine.hpp"
+#include "RunningStatistics.hpp"
+#include "placeStubborn.hpp"
+#include "Timer.hpp"
+#include <boost/filesystem.hpp>
+#include <sstream>
+#include <algorithm> // For std::stable_sort.
+#include <stdexcept>
+#include <cmath>
+#include <iomanip> // For std::setprecision.
+
+namespace
+{
+	/**
+	 *\brief Reads the values after a key, throwing unless there is at least one and all of them parse.
+	 */
+	template<class T>
+	std::vector<T> readValues(std::istream &in, const std::string &key)
+	{
+		std::vector<T> values;
+		T value;
+		while(in >> value)
+		{
+			values.push_back(value);
+		}
+		if(values.empty() || !in.eof())
+		{
+			throw std::runtime_error("bad value for " + key + " in the grid");
+		}
+		return values;
+	}
+
+	/**
+	 *\brief Reads the single value after a key.
+	 */
+	template<class T>
+	T readValue(std::istream &in, const std::string &key)
+	{
+		std::vector<T> values = readValues<T>(in, key);
+		if(values.size() != 1)
+		{
+			throw std::runtime_error(key + " takes a single value in the grid");
+		}
+		return values[0];
+	}
+}
+
+Batch::Batch(const std::string &specFile, unsigned long long seed) : m_replicaCount{1}, m_discard{-1}
+{
+	std::ifstream in(specFile);
+	if(!in)
+	{
+		throw std::runtime_error("cannot open grid " + specFile);
+	}
+
+	VoterInputParameters parameters
+	{
+		50,
+		50,
+		0.0,
+		10000,
+		seed,
+		1,
+		1,
+		VoterArray::RowMajor,
+		"sequential",
+		0,
+		RandomStubborn,
+		"",
+		"",
+		"",
+		Graph::NoOrdering
+	};
+	std::vector<int> rows{50};
+	std::vector<int> cols;
+	std::vector<double> initialOrders{0.0};
+	std::vector<long long> stubbornNumbers{0};
+
+	std::string line;
+	while(std::getline(in, line))
+	{
+		line = line.substr(0, line.find('#'));
+		std::size_t equals = line.find('=');
+		if(line.find_first_not_of(" \t\r") == std::string::npos)
+		{
+			continue;
+		}
+		if(equals == std::string::npos)
+		{
+			throw std::runtime_error("expected key = values in the grid: " + line);
+		}
+
+		std::string key;
+		std::istringstream(line.substr(0, equals)) >> key;
+		std::istringstream values(line.substr(equals + 1));
+
+		if(key == "rows")                    rows = readValues<int>(values, key);
+		else if(key == "cols")               cols = readValues<int>(values, key);
+		else if(key == "initial-order")      initialOrders = readValues<double>(values, key);
+		else if(key == "stubborn-number")    stubbornNumbers = readValues<long long>(values, key);
+		else if(key == "sweeps")             parameters.sweeps = readValue<long long>(values, key);
+		else if(key == "discard")            m_discard = readValue<long long>(values, key);
+		else if(key == "replicas")           m_replicaCount = readValue<int>(values, key);
+		else if(key == "seed")               parameters.seed = readValue<unsigned long long>(values, key);
+		else if(key == "engine")             parameters.engine = readValue<std::string>(values, key);
+		else if(key == "layout")             parameters.layout = readValue<VoterArray::Layout>(values, key);
+		else if(key == "stubborn-placement") parameters.stubbornPlacement = readValue<StubbornPlacement>(values, key);
+		else if(key == "stubborn-mask")
+		{
+			parameters.stubbornMask = readValue<std::string>(values, key);
+			parameters.stubbornPlacement = MaskStubborn;
+		}
+		else
+		{
+			throw std::runtime_error("unknown key " + key + " in the grid");
+		}
+	}
+
+	if(parameters.sweeps < 1 || m_replicaCount < 1)
+	{
+		throw std::runtime_error("the grid needs at least one sweep and one replica");
+	}
+	if(parameters.engine != "sequential" && parameters.engine != "rejection-free" && parameters.engine != "synchronous")
+	{
+		throw std::runtime_error("unknown engine " + parameters.engine + " in the grid");
+	}
+	if(m_discard < 0 || m_discard >= parameters.sweeps)
+	{
+		m_discard = parameters.sweeps / 2;
+	}
+	parameters.replicaCount = m_replicaCount;
+
+	// One point per combination, square lattices unless the columns are given.
+	for(int rowCount : rows)
+	{
+		std::vector<int> colCounts = cols.empty() ? std::vector<int>{rowCount} : cols;
+		for(int colCount : colCounts)
+		{
+			for(double initialOrder : initialOrders)
+			{
+				for(long long stubbornNumber : stubbornNumbers)
+				{
+					if(rowCount < 1 || colCount < 1 ||
+					   (parameters.stubbornPlacement != MaskStubborn && (stubbornNumber < 0 || stubbornNumber > static_cast<long long>(rowCount) * colCount)))
+					{
+						throw std::runtime_error("grid point with a bad lattice size or number of stubborn voters");
+					}
+
+					// The jobs place their voters on the pool, so a mask that does not fit is caught here.
+					if(parameters.stubbornPlacement == MaskStubborn)
+					{
+						checkStubbornMask(parameters.stubbornMask, rowCount, colCount);
+					}
+
+					parameters.rowCount = rowCount;
+					parameters.colCount = colCount;
+					parameters.initialOrder = initialOrder;
+					parameters.stubbornNumber = stubbornNumber;
+					m_points.push_back(parameters);
+				}
+			}
+		}
+	}
+}
+
+const std::vector<VoterInputParameters>& Batch::getPoints() const
+{
+	return m_points;
+}
+
+std::size_t Batch::getJobCount() const
+{
+	return m_points.size() * m_replicaCount;
+}
+
+std::vector<bool> Batch::readFinished(const std::string &fileName, unsigned long long &seed) const
+{
+	std::vector<bool> finished(getJobCount(), false);
+
+	std::ifstream in(fileName, std::ios::in | std::ios::binary);
+	std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+	// Only lines with their newline are complete, a crash can leave a partial one at the end.
+	std::size_t begin = 0;
+	std::size_t end;
+	while((end = contents.find('\n', begin)) != std::string::npos)
+	{
+		std::istringstream line(contents.substr(begin, end - begin));
+		begin = end + 1;
+
+		std::string first;
+		if(!(line >> first))
+		{
+			continue;
+		}
+		if(first == "#")
+		{
+			std::string key;
+			if(line >> key && key == "seed")
+			{
+				line >> seed;
+			}
+			continue;
+		}
+
+		std::size_t point = std::stoul(first);
+		std::size_t replica;
+		int rowCount, colCount;
+		long long stubbornNumber, sweeps;
+		double initialOrder;
+		line >> replica >> rowCount >> colCount >> initialOrder >> stubbornNumber >> sweeps;
+
+		if(!line || point >= m_points.size() || replica >= static_cast<std::size_t>(m_replicaCount) ||
+		   rowCount != m_points[point].rowCount || colCount != m_points[point].colCount || sweeps != m_points[point].sweeps ||
+		   std::abs(initialOrder - m_points[point].initialOrder) > 1e-5 ||
+		   (m_points[point].stubbornPlacement != MaskStubborn && stubbornNumber != m_points[point].stubbornNumber))
+		{
+			throw std::runtime_error(fileName + " holds jobs of a different grid");
+		}
+		finished[point * m_replicaCount + replica] = true;
+	}
+
+	if(begin < contents.size())
+	{
+		boost::filesystem::resize_file(fileName, begin);
+	}
+
+	return finished;
+}
+
+std::size_t Batch::run(ThreadPool &pool, const std::string &fileName)
+{
+	// A restarted batch keeps the seed it started with.
+	unsigned long long seed = m_points[0].seed;
+	// A file left empty, say by a batch stopped before it began, still needs the header.
+	bool restart = boost::filesystem::exists(fileName) && boost::filesystem::file_size(fileName) > 0;
+	std::vector<bool> finished = restart ? readFinished(fileName, seed) : std::vector<bool>(getJobCount(), false);
+	for(auto &point : m_points)
+	{
+		point.seed = seed;
+	}
+
+	m_output.open(fileName, std::ios::out | std::ios::app);
+	if(!restart)
+	{
+		m_output << "# seed " << seed << '\n';
+		m_output << "# point replica rows cols initial-order stubborn-number sweeps final-order mean-order "
+		            "mean-order-error absolute-order square-order seconds consensus-time\n";
+		m_output.flush();
+	}
+
+	struct Job
+	{
+		int point;
+		int replica;
+		RandomEngine generator;
+	};
+
+	// The streams are handed out in job order whichever jobs are left to run.
+	std::vector<Job> jobs;
+	RandomEngine generator(seed);
+	for(int point = 0; point < static_cast<int>(m_points.size()); ++point)
+	{
+		for(int replica = 0; replica < m_replicaCount; ++replica)
+		{
+			if(!finished[point * m_replicaCount + replica])
+			{
+				jobs.push_back(Job{point, replica, generator});
+			}
+			generator.longJump();
+		}
+	}
+
+	// Largest lattices first.
+	std::stable_sort(jobs.begin(), jobs.end(), [this](const Job &a, const Job &b)
+	{
+		return static_cast<long long>(m_points[a.point].rowCount) * m_points[a.point].colCount * m_points[a.point].sweeps >
+		       static_cast<long long>(m_points[b.point].rowCount) * m_points[b.point].colCount * m_points[b.point].sweeps;
+	});
+
+	// An exception cannot leave a pool task, so the first is kept and the jobs still queued are dropped.
+	m_error = nullptr;
+	for(const auto &job : jobs)
+	{
+		pool.submit([this, job]
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				if(m_error)
+				{
+					return;
+				}
+			}
+
+			try
+			{
+				runJob(job.point, job.replica, job.generator);
+			}
+			catch(...)
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				if(!m_error)
+				{
+					m_error = std::current_exception();
+				}
+			}
+		});
+	}
+	pool.wait();
+
+	m_output.close();
+	if(m_error)
+	{
+		std::rethrow_exception(m_error);
+	}
+	return jobs.size();
+}
+
+void Batch::runJob(int point, int replica, RandomEngine generator)
+{
+	Timer timer;
+	const VoterInputParameters &parameters = m_points[point];
+
+	std::unique_ptr<VoterArray> latticePointer = makeVoterArray(generator, parameters.rowCount, parameters.colCount, parameters.initialOrder, parameters.layout);
+	VoterArray &lattice = *latticePointer;
+	placeStubborn(lattice, parameters.stubbornPlacement, parameters.stubbornNumber, parameters.stubbornMask, generator);
+
+	// Only summaries of the trace after the discarded sweeps are kept.
+	RunningStatistics orderParameter;
+	double absoluteSum = 0;
+	double squareSum = 0;
+
+	std::unique_ptr<RejectionFreeEngine> rejectionFree;
+	if(parameters.engine == "rejection-free")
+	{
+		rejectionFree.reset(new RejectionFreeEngine(lattice));
+	}
+
+	// Time the lattice froze, -1 until it does. A frozen lattice would stay as it is so its sweeps are
+	// not run, only their order parameter is added to the summaries.
+	double consensusTime = lattice.frozen() ? 0 : -1;
+	for(long long sweep = 0; sweep < parameters.sweeps; ++sweep)
+	{
+		if(consensusTime < 0)
+		{
+			// The time the lattice froze, to the update for the random sequential sweep.
+			double frozenAt = sweep + 1;
+			if(rejectionFree)
+			{
+				rejectionFree->advance(sweep + 1, generator);
+				frozenAt = rejectionFree->getTime();
+			}
+			else if(parameters.engine == "synchronous")
+			{
+				lattice.synchronousSweep(generator);
+			}
+			else
+			{
+				lattice.sweep(generator);
+				frozenAt = sweep + lattice.freezingFraction();
+			}
+
+			if(lattice.frozen())
+			{
+				consensusTime = frozenAt;
+			}
+		}
+
+		if(sweep >= m_discard)
+		{
+			double value = lattice.orderParameter();
+			orderParameter.push(value);
+			absoluteSum += std::abs(value);
+			squareSum += value * value;
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	std::streamsize precision = m_output.precision();
+	m_output << point << ' ' << replica << ' ' << parameters.rowCount << ' ' << parameters.colCount << ' '
+	         << parameters.initialOrder << ' ' << lattice.getStubbornCount() << ' ' << parameters.sweeps << ' '
+	         << lattice.orderParameter() << ' ' << orderParameter.mean() << ' ' << orderParameter.blockingError() << ' '
+	         << absoluteSum / orderParameter.getCount() << ' ' << squareSum / orderParameter.getCount() << ' '
+	         << timer.elapsed() << ' ' << std::setprecision(17) << consensusTime << std::setprecision(precision) << '\n';
+	m_output.flush();
+}
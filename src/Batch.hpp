@@ -0,0 +1,116 @@
+#ifndef Batch_hpp
+#define Batch_hpp
+
+#include <vector>
+#include <string>
+#include <mutex>
+#include <fstream>
+#include <cstddef>
+#include <exception>
+#include "VoterInputParameters.hpp"
+#include "ThreadPool.hpp"
+#include "RandomEngine.hpp"
+
+/**
+ *\file
+ *\class Batch
+ *\brief Runs every replica of every point of a parameter grid on one thread pool.
+ *
+ * The grid is read from a text file of "key = values" lines, # starting a comment:
+ *
+ *     rows = 32 64 128            # lists give one grid point per combination
+ *     cols = 32 64 128            # optional, square lattices if left out
+ *     initial-order = 0 0.5
+ *     stubborn-number = 0 16 256
+ *     sweeps = 10000              # the remaining keys take a single value
+ *     discard = 2000              # sweeps left out of the averages, half of them by default
+ *     replicas = 16
+ *     seed = 12345
+ *     engine = sequential         # or rejection-free or synchronous
+ *     layout = row-major
+ *     stubborn-placement = random
+ *     stubborn-mask = mask.txt
+ *
+ * Each (point, replica) pair is a job. Job j, counting the replicas of point 0 first, draws from the
+ * stream j long jumps after a generator seeded with the grid's seed, so its result does not depend on
+ * the number of threads or on the order the jobs run in. The jobs are submitted largest lattice first
+ * so the long ones do not make up the tail of the batch.
+ *
+ * Every finished job appends one line to the output file, indexed by point and replica. When the
+ * output file already exists the jobs it holds are skipped and the rest appended, so a batch that was
+ * stopped carries on where it left off.
+ */
+class Batch
+{
+private:
+	/// Parameters of each grid point.
+	std::vector<VoterInputParameters> m_points;
+
+	/// Number of replicas of each point.
+	int m_replicaCount;
+
+	/// Number of sweeps left out of the averages.
+	long long m_discard;
+
+	/// Output file the finished jobs are appended to.
+	std::ofstream m_output;
+
+	/// First exception thrown by a job, rethrown by run() once the pool is idle.
+	std::exception_ptr m_error;
+
+	/// Guards the output file and m_error.
+	std::mutex m_mutex;
+
+	/**
+	 *\brief Runs a single job and appends its line to the output file.
+	 *\param point index of the grid point.
+	 *\param replica index of the replica.
+	 *\param generator RandomEngine for the job.
+	 */
+	void runJob(int point, int replica, RandomEngine generator);
+
+	/**
+	 *\brief Reads the jobs already in the output file and cuts off a partly written last line.
+	 *\param fileName name of the output file.
+	 *\param seed seed recorded in the file, left as it is if the file has none.
+	 *\return flag for each job, true if it has finished.
+	 */
+	std::vector<bool> readFinished(const std::string &fileName, unsigned long long &seed) const;
+
+public:
+	/**
+	 *\brief Constructor that reads the grid.
+	 *\param specFile name of the grid file.
+	 *\param seed seed used if the grid does not give one.
+	 *
+	 * Throws std::runtime_error if the grid file cannot be read or holds an unknown key or a bad value,
+	 * including a stubborn mask that does not fit the lattice of every grid point.
+	 */
+	Batch(const std::string &specFile, unsigned long long seed);
+
+	/**
+	 *\brief Getter for the grid points.
+	 *\return parameters of each grid point.
+	 */
+	const std::vector<VoterInputParameters>& getPoints() const;
+
+	/**
+	 *\brief Getter for the number of jobs.
+	 *\return number of points times number of replicas.
+	 */
+	std::size_t getJobCount() const;
+
+	/**
+	 *\brief Runs every job that is not yet in the output file on the pool and waits for them.
+	 *
+	 * Throws std::runtime_error if the output file holds jobs of a different grid. A job that throws
+	 * stops the jobs not yet started and its exception is rethrown once the others have finished.
+	 *
+	 *\param pool ThreadPool reference to run the jobs on.
+	 *\param fileName name of the output file.
+	 *\return number of jobs run.
+	 */
+	std::size_t run(ThreadPool &pool, const std::string &fileName);
+};
+
+#endif /* Batch_hpp */
@@ -0,0 +1,81 @@
+#ifndef BinaryIO_hpp
+#define BinaryIO_hpp
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdint>
+
+/**
+ *\file
+ *\brief Helpers for writing and reading values in the host's binary representation.
+ *
+ * Only meant for trivially copyable values and vectors of them, the files they produce are read back
+ * on the same kind of machine. Vectors and strings are prefixed with their length as a 64-bit word.
+ */
+
+/**
+ *\brief Writes a trivially copyable value.
+ *\param out std::ostream reference that is being written to.
+ *\param value the value to write.
+ */
+template<class T>
+void writeBinary(std::ostream &out, const T &value)
+{
+	out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+/**
+ *\brief Reads a trivially copyable value.
+ *\param in std::istream reference that is being read from.
+ *\param value the value that is read.
+ */
+template<class T>
+void readBinary(std::istream &in, T &value)
+{
+	in.read(reinterpret_cast<char*>(&value), sizeof(T));
+}
+
+/**
+ *\brief Writes a vector of trivially copyable values prefixed with its length.
+ */
+template<class T>
+void writeBinary(std::ostream &out, const std::vector<T> &values)
+{
+	writeBinary(out, static_cast<std::uint64_t>(values.size()));
+	out.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+}
+
+/**
+ *\brief Reads a vector written by writeBinary().
+ */
+template<class T>
+void readBinary(std::istream &in, std::vector<T> &values)
+{
+	std::uint64_t size = 0;
+	readBinary(in, size);
+	values.resize(in ? static_cast<std::size_t>(size) : 0);
+	in.read(reinterpret_cast<char*>(values.data()), values.size() * sizeof(T));
+}
+
+/**
+ *\brief Writes a string prefixed with its length.
+ */
+inline void writeBinary(std::ostream &out, const std::string &value)
+{
+	writeBinary(out, static_cast<std::uint64_t>(value.size()));
+	out.write(value.data(), value.size());
+}
+
+/**
+ *\brief Reads a string written by writeBinary().
+ */
+inline void readBinary(std::istream &in, std::string &value)
+{
+	std::uint64_t size = 0;
+	readBinary(in, size);
+	value.resize(in ? static_cast<std::size_t>(size) : 0);
+	in.read(&value[0], value.size());
+}
+
+#endif /* BinaryIO_hpp */
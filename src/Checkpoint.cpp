@@ -0,0 +1,168 @@
+#include "Checkpoint.hpp"
+#include "BinaryIO.hpp"
+#include <fstream>
+#include <stdexcept>
+#include <cstdio> // For std::rename.
+#include <fcntl.h>
+#include <unistd.h>
+
+const std::uint64_t Checkpoint::magic;
+const std::uint64_t Checkpoint::version;
+
+void Checkpoint::save(const std::string &fileName) const
+{
+	std::string temporaryName = fileName + ".tmp";
+
+	{
+		std::ofstream out(temporaryName, std::ios::out | std::ios::binary | std::ios::trunc);
+
+		writeBinary(out, magic);
+		writeBinary(out, version);
+
+		writeBinary(out, static_cast<std::int32_t>(parameters.rowCount));
+		writeBinary(out, static_cast<std::int32_t>(parameters.colCount));
+		writeBinary(out, parameters.initialOrder);
+		writeBinary(out, static_cast<std::int64_t>(parameters.sweeps));
+		writeBinary(out, static_cast<std::uint64_t>(parameters.seed));
+		writeBinary(out, static_cast<std::int32_t>(parameters.threadCount));
+		writeBinary(out, static_cast<std::int32_t>(parameters.replicaCount));
+		writeBinary(out, static_cast<std::int32_t>(parameters.layout));
+		writeBinary(out, parameters.engine);
+		writeBinary(out, static_cast<std::int64_t>(parameters.stubbornNumber));
+		writeBinary(out, static_cast<std::int32_t>(parameters.stubbornPlacement));
+		writeBinary(out, parameters.stubbornMask);
+		writeBinary(out, parameters.outputDirectory);
+
+		writeBinary(out, static_cast<std::int32_t>(frameStride));
+		writeBinary(out, static_cast<std::int32_t>(checkpointInterval));
+		writeBinary(out, static_cast<std::int64_t>(sweep));
+		writeBinary(out, static_cast<std::int32_t>(absorbed));
+		writeBinary(out, consensusTime);
+		writeBinary(out, generator);
+		writeBinary(out, opinions);
+		writeBinary(out, stubborn);
+		writeBinary(out, engineState);
+		writeBinary(out, orderParameterBytes);
+		writeBinary(out, trajectoryBytes);
+		writeBinary(out, trajectoryIndex);
+
+		out.close();
+		if(!out)
+		{
+			throw std::runtime_error("cannot write checkpoint " + temporaryName);
+		}
+	}
+
+	// Only replace the previous checkpoint once the new one is safely on disk.
+	syncFile(temporaryName);
+	if(std::rename(temporaryName.c_str(), fileName.c_str()) != 0)
+	{
+		throw std::runtime_error("cannot rename checkpoint to " + fileName);
+	}
+	syncDirectory(fileName);
+}
+
+void Checkpoint::load(const std::string &fileName)
+{
+	std::ifstream in(fileName, std::ios::in | std::ios::binary);
+	if(!in)
+	{
+		throw std::runtime_error("cannot open checkpoint " + fileName);
+	}
+
+	std::uint64_t fileMagic = 0;
+	std::uint64_t fileVersion = 0;
+	readBinary(in, fileMagic);
+	readBinary(in, fileVersion);
+	if(fileMagic != magic || fileVersion != version)
+	{
+		throw std::runtime_error("unknown checkpoint format " + fileName);
+	}
+
+	std::int32_t value32 = 0;
+	std::int64_t value64 = 0;
+	std::uint64_t seed = 0;
+
+	readBinary(in, value32);
+	parameters.rowCount = value32;
+	readBinary(in, value32);
+	parameters.colCount = value32;
+	readBinary(in, parameters.initialOrder);
+	readBinary(in, value64);
+	parameters.sweeps = value64;
+	readBinary(in, seed);
+	parameters.seed = seed;
+	readBinary(in, value32);
+	parameters.threadCount = value32;
+	readBinary(in, value32);
+	parameters.replicaCount = value32;
+	readBinary(in, value32);
+	parameters.layout = static_cast<VoterArray::Layout>(value32);
+	readBinary(in, parameters.engine);
+	readBinary(in, value64);
+	parameters.stubbornNumber = value64;
+	readBinary(in, value32);
+	parameters.stubbornPlacement = static_cast<StubbornPlacement>(value32);
+	readBinary(in, parameters.stubbornMask);
+	readBinary(in, parameters.outputDirectory);
+
+	readBinary(in, value32);
+	frameStride = value32;
+	readBinary(in, value32);
+	checkpointInterval = value32;
+	readBinary(in, value64);
+	sweep = value64;
+	readBinary(in, value32);
+	absorbed = value32 != 0;
+	readBinary(in, consensusTime);
+	readBinary(in, generator);
+	readBinary(in, opinions);
+	readBinary(in, stubborn);
+	readBinary(in, engineState);
+	readBinary(in, orderParameterBytes);
+	readBinary(in, trajectoryBytes);
+	readBinary(in, trajectoryIndex);
+
+	std::size_t frameWords = (static_cast<std::size_t>(parameters.rowCount) * parameters.colCount + 63) / 64;
+	if(!in || opinions.size() != frameWords || stubborn.size() != frameWords)
+	{
+		throw std::runtime_error("truncated or inconsistent checkpoint " + fileName);
+	}
+}
+
+void Checkpoint::syncFile(const std::string &fileName)
+{
+	int descriptor = open(fileName.c_str(), O_RDONLY);
+	if(descriptor < 0)
+	{
+		throw std::runtime_error("cannot open " + fileName + " to sync it");
+	}
+
+	int status = fsync(descriptor);
+	::close(descriptor);
+
+	if(status != 0)
+	{
+		throw std::runtime_error("cannot sync " + fileName);
+	}
+}
+
+void Checkpoint::syncDirectory(const std::string &fileName)
+{
+	std::string::size_type slash = fileName.rfind('/');
+	std::string directory = slash == std::string::npos ? "." : slash == 0 ? "/" : fileName.substr(0, slash);
+
+	int descriptor = open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+	if(descriptor < 0)
+	{
+		throw std::runtime_error("cannot open " + directory + " to sync it");
+	}
+
+	int status = fsync(descriptor);
+	::close(descriptor);
+
+	if(status != 0)
+	{
+		throw std::runtime_error("cannot sync " + directory);
+	}
+}
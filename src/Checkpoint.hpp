@@ -0,0 +1,92 @@
+#ifndef Checkpoint_hpp
+#define Checkpoint_hpp
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "VoterInputParameters.hpp"
+#include "RandomEngine.hpp"
+
+/**
+ *\file
+ *\class Checkpoint
+ *\brief Everything needed to continue a single simulation exactly where it stopped.
+ *
+ * Holds the input parameters, the number of sweeps done and whether and when the lattice froze, the
+ * packed lattice, the state of the main generator and of the update engine, and how much of the order
+ * parameter file and trajectory had been written. Continuing from a checkpoint reproduces the uninterrupted run bit for bit.
+ *
+ * Checkpoints are written to a temporary file that is synced and then renamed over the previous one,
+ * and the directory is synced after the rename, so a crash while writing leaves the previous
+ * checkpoint intact and one that has been saved survives a crash.
+ */
+class Checkpoint
+{
+public:
+	/// Magic number at the start of every checkpoint file, "VOTERCHK" read as a little-endian word.
+	static const std::uint64_t magic = 0x4b48435245544f56ULL;
+
+	/// Version of the file format.
+	static const std::uint64_t version = 5;
+
+	/// Input parameters of the run.
+	VoterInputParameters parameters;
+	/// Sweeps between frames of the trajectory, 0 when not animating.
+	int frameStride;
+	/// Sweeps between checkpoints.
+	int checkpointInterval;
+	/// Number of sweeps done.
+	long long sweep;
+	/// Whether the lattice had reached an absorbing state.
+	bool absorbed;
+	/// Time it did, see VoterResults::consensusTime.
+	double consensusTime;
+	/// State of the main generator.
+	std::uint64_t generator[RandomEngine::stateSize];
+	/// Opinions packed as by VoterArray::packOpinions().
+	std::vector<std::uint64_t> opinions;
+	/// Stubborn flags packed as by VoterArray::packStubborn().
+	std::vector<std::uint64_t> stubborn;
+	/// State saved by the update engine, empty for the sequential update.
+	std::string engineState;
+	/// Size of the order parameter file in bytes.
+	std::uint64_t orderParameterBytes;
+	/// Size of the trajectory in bytes, see TrajectoryWriter::getByteCount().
+	std::uint64_t trajectoryBytes;
+	/// Index of the frames in the trajectory, see TrajectoryWriter::getIndex().
+	std::vector<std::uint64_t> trajectoryIndex;
+
+	/**
+	 *\brief Writes the checkpoint, replacing the file atomically.
+	 *\param fileName name of the checkpoint file.
+	 *
+	 * Throws std::runtime_error if the checkpoint cannot be written.
+	 */
+	void save(const std::string &fileName) const;
+
+	/**
+	 *\brief Reads a checkpoint written by save().
+	 *\param fileName name of the checkpoint file.
+	 *
+	 * Throws std::runtime_error if the file cannot be read or is not a checkpoint.
+	 */
+	void load(const std::string &fileName);
+
+	/**
+	 *\brief Forces a file that has been written and flushed out to disk.
+	 *\param fileName name of the file.
+	 *
+	 * Throws std::runtime_error if the file cannot be synced.
+	 */
+	static void syncFile(const std::string &fileName);
+
+	/**
+	 *\brief Forces the entry of a file that has just been created or renamed out to disk.
+	 *\param fileName name of the file, its directory is synced.
+	 *
+	 * Throws std::runtime_error if the directory cannot be synced.
+	 */
+	static void syncDirectory(const std::string &fileName);
+};
+
+#endif /* Checkpoint_hpp */
@@ -0,0 +1,253 @@
+#include "ClusterAnalysis.hpp"
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+	/// Marks a root that has not been given a new label.
+	const std::size_t unnumbered = std::numeric_limits<std::size_t>::max();
+
+	/**
+	 *\brief Reads up to 64 bits of a packed frame starting at any bit, the first in the lowest bit.
+	 */
+	std::uint64_t readBits(const std::vector<std::uint64_t> &frame, std::size_t begin, int length)
+	{
+		std::size_t word = begin >> 6;
+		std::size_t offset = begin & 63;
+
+		std::uint64_t bits = frame[word] >> offset;
+		if(offset && offset + length > 64)
+		{
+			bits |= frame[word + 1] << (64 - offset);
+		}
+		return length < 64 ? bits & ((std::uint64_t(1) << length) - 1) : bits;
+	}
+
+	/**
+	 *\brief Index of the highest set bit, the histogram entry of a cluster size.
+	 */
+	int highestBit(std::size_t size)
+	{
+		return 63 - __builtin_clzll(size);
+	}
+}
+
+ClusterAnalysis::ClusterAnalysis(int rowCount, int colCount) :
+	m_rowCount(rowCount),
+	m_colCount(colCount)
+{
+
+}
+
+void ClusterAnalysis::findRuns(const std::vector<std::uint64_t> &frame, int row, std::vector<Run> &runs)
+{
+	std::size_t rowBegin = static_cast<std::size_t>(row) * m_colCount;
+	runs.clear();
+
+	int begin = 0;
+	int opinion = static_cast<int>(frame[rowBegin >> 6] >> (rowBegin & 63) & 1);
+	for(int col = 0; col < m_colCount; col += 64)
+	{
+		int length = std::min(64, m_colCount - col);
+		std::uint64_t bits = readBits(frame, rowBegin + col, length);
+		std::uint64_t valid = length < 64 ? (std::uint64_t(1) << length) - 1 : ~std::uint64_t(0);
+
+		// Each bit that differs from the opinion of the run so far ends it.
+		std::uint64_t change = (opinion ? ~bits : bits) & valid;
+		while(change)
+		{
+			int end = col + __builtin_ctzll(change);
+			runs.push_back({begin, end, opinion, m_parent.size()});
+			m_parent.push_back(m_parent.size());
+			m_size.push_back(end - begin);
+
+			begin = end;
+			opinion ^= 1;
+			change = ((opinion ? ~bits : bits) & valid) & (~std::uint64_t(0) << (end - col));
+		}
+	}
+	runs.push_back({begin, m_colCount, opinion, m_parent.size()});
+	m_parent.push_back(m_parent.size());
+	m_size.push_back(m_colCount - begin);
+
+	// The row wraps round, so the first and last runs touch if they have the same opinion.
+	if(runs.size() > 1 && runs.front().opinion == runs.back().opinion)
+	{
+		join(runs.front().label, runs.back().label);
+	}
+}
+
+std::size_t ClusterAnalysis::find(std::size_t label)
+{
+	std::size_t root = label;
+	while(m_parent[root] != root)
+	{
+		root = m_parent[root];
+	}
+	while(m_parent[label] != root)
+	{
+		std::size_t next = m_parent[label];
+		m_parent[label] = root;
+		label = next;
+	}
+	return root;
+}
+
+void ClusterAnalysis::join(std::size_t first, std::size_t second)
+{
+	first = find(first);
+	second = find(second);
+	if(first == second)
+	{
+		return;
+	}
+	if(m_size[first] < m_size[second])
+	{
+		std::swap(first, second);
+	}
+	m_parent[second] = first;
+	m_size[first] += m_size[second];
+}
+
+void ClusterAnalysis::joinRows(const std::vector<Run> &upper, const std::vector<Run> &lower)
+{
+	// Both rows are covered by their runs in order, so stepping past whichever run ends first visits
+	// every pair that shares a column once.
+	auto above = upper.begin();
+	auto below = lower.begin();
+	while(above != upper.end() && below != lower.end())
+	{
+		if(above->opinion == below->opinion)
+		{
+			join(above->label, below->label);
+		}
+
+		int aboveEnd = above->end;
+		int belowEnd = below->end;
+		if(aboveEnd <= belowEnd)
+		{
+			++above;
+		}
+		if(belowEnd <= aboveEnd)
+		{
+			++below;
+		}
+	}
+}
+
+void ClusterAnalysis::count(std::size_t size, Result &result)
+{
+	++result.clusterCount;
+	++result.histogram[highestBit(size)];
+	result.largest = std::max(result.largest, size);
+}
+
+void ClusterAnalysis::retire(Result &result)
+{
+	// Number the clusters still open, those of the runs that later rows can reach.
+	m_renumber.assign(m_parent.size(), unnumbered);
+	std::size_t labelCount = 0;
+	for(auto *runs : {&m_firstRuns, &m_currentRuns})
+	{
+		for(auto &run : *runs)
+		{
+			run.label = find(run.label);
+			if(m_renumber[run.label] == unnumbered)
+			{
+				m_renumber[run.label] = labelCount++;
+			}
+		}
+	}
+
+	// Every other root is a complete cluster.
+	m_keptSizes.assign(labelCount, 0);
+	for(std::size_t label = 0; label < m_parent.size(); ++label)
+	{
+		if(m_parent[label] != label)
+		{
+			continue;
+		}
+		if(m_renumber[label] == unnumbered)
+		{
+			count(m_size[label], result);
+		}
+		else
+		{
+			m_keptSizes[m_renumber[label]] = m_size[label];
+		}
+	}
+
+	for(auto *runs : {&m_firstRuns, &m_currentRuns})
+	{
+		for(auto &run : *runs)
+		{
+			run.label = m_renumber[run.label];
+		}
+	}
+	m_size.swap(m_keptSizes);
+	m_parent.resize(labelCount);
+	for(std::size_t label = 0; label < labelCount; ++label)
+	{
+		m_parent[label] = label;
+	}
+}
+
+void ClusterAnalysis::analyse(const std::vector<std::uint64_t> &frame, Result &result)
+{
+	result.clusterCount = 0;
+	result.largest = 0;
+	result.histogram.assign(getBinCount(), 0);
+
+	m_parent.clear();
+	m_size.clear();
+	m_firstRuns.clear();
+	m_previousRuns.clear();
+
+	for(int row = 0; row < m_rowCount; ++row)
+	{
+		findRuns(frame, row, m_currentRuns);
+		if(row > 0)
+		{
+			joinRows(m_previousRuns, m_currentRuns);
+		}
+		retire(result);
+
+		if(row == 0)
+		{
+			m_firstRuns = m_currentRuns;
+		}
+		m_previousRuns.swap(m_currentRuns);
+	}
+
+	// Close the periodic boundary between the last row and the first, every cluster is then complete.
+	if(m_rowCount > 1)
+	{
+		joinRows(m_previousRuns, m_firstRuns);
+	}
+	for(std::size_t label = 0; label < m_parent.size(); ++label)
+	{
+		if(find(label) == label)
+		{
+			count(m_size[label], result);
+		}
+	}
+
+	std::size_t siteCount = static_cast<std::size_t>(m_rowCount) * m_colCount;
+	result.largestFraction = siteCount ? static_cast<double>(result.largest) / siteCount : 0;
+}
+
+std::size_t ClusterAnalysis::getBinCount() const
+{
+	std::size_t siteCount = static_cast<std::size_t>(m_rowCount) * m_colCount;
+	return siteCount ? highestBit(siteCount) + 1 : 0;
+}
+
+std::ostream& operator<<(std::ostream& out, const ClusterAnalysis::Result &result)
+{
+	out << result.sweep << ' ' << result.clusterCount << ' ' << result.largestFraction;
+	for(auto clusters : result.histogram)
+	{
+		out << ' ' << clusters;
+	}
+	return out;
+}
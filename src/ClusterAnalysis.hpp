@@ -0,0 +1,151 @@
+#ifndef ClusterAnalysis_hpp
+#define ClusterAnalysis_hpp
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <iostream>
+
+/**
+ *\file
+ *\class ClusterAnalysis
+ *\brief Sizes of the domains of equal opinion on a periodic lattice.
+ *
+ * A domain is a set of voters of the same opinion connected through nearest neighbours, with the lattice
+ * wrapped round in both directions. The lattice is read from a packed row-major frame, as produced by
+ * VoterArray::packOpinions(), so it can be a snapshot analysed on another thread.
+ *
+ * The frame is scanned a row at a time in the manner of Hoshen and Kopelman. Each row is cut into runs
+ * of equal opinion, found a word at a time, and every run is given a label that is joined with the
+ * labels of the runs it touches in the row above, in a union-find with union by size and path
+ * compression. After each row the clusters that no longer touch the current row or the first row are
+ * complete, they go into the histogram and the labels still in use are renumbered, so memory stays
+ * proportional to the number of runs in two rows. The first row is joined to the last at the end to
+ * close the periodic boundary.
+ */
+class ClusterAnalysis
+{
+public:
+	/**
+	 *\struct Result
+	 *\brief Domain statistics of one lattice.
+	 */
+	struct Result
+	{
+		/// Number of sweeps done when the lattice was taken.
+		long long sweep = 0;
+		/// Number of domains of either opinion.
+		std::size_t clusterCount = 0;
+		/// Number of sites in the largest domain.
+		std::size_t largest = 0;
+		/// Fraction of the sites in the largest domain.
+		double largestFraction = 0;
+		/// Number of domains of 2^k to 2^(k+1)-1 sites in entry k, one entry per power of two up to the lattice size.
+		std::vector<std::size_t> histogram;
+	};
+
+private:
+	/**
+	 *\struct Run
+	 *\brief Columns [begin, end) of a row with the same opinion.
+	 */
+	struct Run
+	{
+		/// First column of the run.
+		int begin;
+		/// Column after the last of the run.
+		int end;
+		/// Opinion of the run, 1 for democrat.
+		int opinion;
+		/// Label of the run in the union-find.
+		std::size_t label;
+	};
+
+	/// Number of rows in the lattice.
+	int m_rowCount;
+
+	/// Number of columns in the lattice.
+	int m_colCount;
+
+	/// Parent of each label, a label is the root of its cluster when it is its own parent.
+	std::vector<std::size_t> m_parent;
+
+	/// Number of sites in the cluster of each root.
+	std::vector<std::size_t> m_size;
+
+	/// New label of each root kept when renumbering, scratch space.
+	std::vector<std::size_t> m_renumber;
+
+	/// Sizes of the clusters kept when renumbering, scratch space.
+	std::vector<std::size_t> m_keptSizes;
+
+	/// Runs of the first row, kept to close the periodic boundary.
+	std::vector<Run> m_firstRuns;
+
+	/// Runs of the row above.
+	std::vector<Run> m_previousRuns;
+
+	/// Runs of the current row.
+	std::vector<Run> m_currentRuns;
+
+	/**
+	 *\brief Cuts a row of the frame into runs, each with a new label.
+	 */
+	void findRuns(const std::vector<std::uint64_t> &frame, int row, std::vector<Run> &runs);
+
+	/**
+	 *\brief Root of the cluster of a label, pointing the labels on the way straight at it.
+	 */
+	std::size_t find(std::size_t label);
+
+	/**
+	 *\brief Joins the clusters of two labels.
+	 */
+	void join(std::size_t first, std::size_t second);
+
+	/**
+	 *\brief Joins the runs of two neighbouring rows that share a column and an opinion.
+	 */
+	void joinRows(const std::vector<Run> &upper, const std::vector<Run> &lower);
+
+	/**
+	 *\brief Adds a complete cluster to a result.
+	 */
+	static void count(std::size_t size, Result &result);
+
+	/**
+	 *\brief Counts the clusters that no longer touch the current or first row and renumbers the rest from 0.
+	 */
+	void retire(Result &result);
+
+public:
+	/**
+	 *\brief Constructor for lattices of the given size.
+	 *\param rowCount number of rows in the lattice.
+	 *\param colCount number of columns in the lattice.
+	 */
+	ClusterAnalysis(int rowCount, int colCount);
+
+	/**
+	 *\brief Finds the domains of a lattice in a single pass over its rows.
+	 *\param frame opinions packed row-major as by VoterArray::packOpinions().
+	 *\param result overwritten with the domain statistics, apart from the sweep.
+	 */
+	void analyse(const std::vector<std::uint64_t> &frame, Result &result);
+
+	/**
+	 *\brief Getter for the number of histogram entries.
+	 *\return one more than the largest power of two not above the number of sites.
+	 */
+	std::size_t getBinCount() const;
+};
+
+/**
+ *\brief streams a result as one line, the sweep, the number of domains, the fraction in the largest and the histogram.
+ *\param out std::ostream reference that is being streamed to.
+ *\param result the result to print.
+ *\return std::ostream reference to output can be chained.
+ */
+std::ostream& operator<<(std::ostream& out, const ClusterAnalysis::Result &result);
+
+#endif /* ClusterAnalysis_hpp */
@@ -1,18 +1,127 @@
 #include "DataArray.hpp"
+#include <complex>
+#include <thread>
+#include <algorithm> // For std::min.
+
+namespace
+{
+    /**
+     *\brief In place iterative radix-2 fast Fourier transform.
+     *\param data values to transform, the size must be a power of two.
+     *\param inverse true for the inverse transform, which is left unnormalised.
+     */
+    void fft(std::vector<std::complex<double> > &data, bool inverse)
+    {
+        std::size_t n = data.size();
+
+        // Bit reversal permutation.
+        for(std::size_t i = 1, j = 0; i < n; ++i)
+        {
+            std::size_t bit = n >> 1;
+            for(; j & bit; bit >>= 1)
+            {
+                j ^= bit;
+            }
+            j ^= bit;
+            if(i < j)
+            {
+                std::swap(data[i], data[j]);
+            }
+        }
+
+        for(std::size_t length = 2; length <= n; length <<= 1)
+        {
+            double angle = 2 * M_PI / length * (inverse ? 1 : -1);
+            std::complex<double> step(std::cos(angle), std::sin(angle));
+            for(std::size_t begin = 0; begin < n; begin += length)
+            {
+                std::complex<double> twiddle(1);
+                for(std::size_t k = 0; k < length / 2; ++k)
+                {
+                    std::complex<double> even = data[begin + k];
+                    std::complex<double> odd  = data[begin + k + length / 2] * twiddle;
+                    data[begin + k]              = even + odd;
+                    data[begin + k + length / 2] = even - odd;
+                    twiddle *= step;
+                }
+            }
+        }
+    }
+
+    /**
+     *\brief Runs work(thread) on threadCount threads, the calling thread being thread 0.
+     */
+    template<class Work>
+    void runThreads(int threadCount, Work work)
+    {
+        std::vector<std::thread> threads;
+        for(int thread = 1; thread < threadCount; ++thread)
+        {
+            threads.emplace_back(work, thread);
+        }
+        work(0);
+
+        for(auto &thread : threads)
+        {
+            thread.join();
+        }
+    }
+
+    /**
+     *\brief Standard deviation of a set of estimates.
+     */
+    double spread(const std::vector<double> &estimates)
+    {
+        double mean = 0;
+        for(const auto &estimate : estimates)
+        {
+            mean += estimate;
+        }
+        mean /= estimates.size();
+
+        double sum = 0;
+        for(const auto &estimate : estimates)
+        {
+            sum += (estimate - mean) * (estimate - mean);
+        }
+        return std::sqrt(sum / estimates.size());
+    }
+}
+
+double DataArray::IMomentFunctor::operator()(const DataArray &data) const
+{
+    std::vector<double> moments(getOrder() + 1, 0);
+    for(std::size_t point = 0; point < data.getSize(); ++point)
+    {
+        double power = 1;
+        for(int k = 1; k <= getOrder(); ++k)
+        {
+            power *= data[point];
+            moments[k] += power;
+        }
+    }
+
+    moments[0] = 1;
+    for(int k = 1; k <= getOrder(); ++k)
+    {
+        moments[k] /= data.getSize();
+    }
+    return fromMoments(moments);
+}
 
 DataArray::DataArray():m_size{0}{}
 
-DataArray::DataArray(int size)
+DataArray::DataArray(std::size_t size):m_size{0}
 {
     m_data.reserve(size);
 }
 
-double& DataArray::operator[](int index)
+double& DataArray::operator[](std::size_t index)
 {
     return m_data[index];
 }
 
-const double& DataArray::operator[](int index) const
+const double& DataArray::operator[](std::size_t index) const
 {
     return m_data[index];
 }
@@ -29,7 +138,13 @@ void DataArray::pop_back()
     m_size--;
 }
 
-void DataArray::reserve(int size)
+void DataArray::clear()
+{
+    m_data.clear();
+    m_size = 0;
+}
+
+void DataArray::reserve(std::size_t size)
 {
     m_data.reserve(size);
 }
@@ -84,7 +199,7 @@ double DataArray::error() const
     double meanSquared = sum / m_size;
     double mean        = (*this).mean();
 
-    return sqrt((meanSquared - mean * mean) / (m_size - 1));
+    return sqrt((meanSquared - mean * mean) / (m_size - 1.0));
 
 }
 
@@ -93,7 +208,7 @@ double DataArray::error() const
 
 std::ostream& operator<<(std::ostream& out, const DataArray& data)
 {
-    int index = 0;
+    std::size_t index = 0;
     for(const auto& point : data.m_data)
     {
         out << index++ << ' ' << point << '\n';
@@ -108,9 +223,11 @@ double DataArray::autoCorrelation(int t) const
     double mean_m         = 0;
     double mean_mSquared  = 0;
 
-    for(int point = 0; point < m_size; ++point)
+    long long size = static_cast<long long>(m_size);
+    std::size_t lag = size ? static_cast<std::size_t>(((t % size) + size) % size) : 0;
+    for(std::size_t point = 0; point < m_size; ++point)
     {
-        term1 += m_data[point]*m_data[(point+t)%m_size];
+        term1 += m_data[point]*m_data[(point+lag)%m_size];
         mean_m += m_data[point];
         mean_mSquared += m_data[point] * m_data[point];
     }
@@ -125,19 +242,271 @@ double DataArray::autoCorrelation(int t) const
     return (term1-term2)/normalisation;
 }
 
+std::vector<double> DataArray::autoCovarianceSums() const
+{
+    // Zero padding to twice the length keeps the circular convolution of the transform from wrapping.
+    std::size_t length = 1;
+    while(length < 2 * m_size)
+    {
+        length <<= 1;
+    }
+
+    double average = mean();
+    std::vector<std::complex<double> > transform(length);
+    for(std::size_t point = 0; point < m_size; ++point)
+    {
+        transform[point] = m_data[point] - average;
+    }
+
+    // The power spectrum transforms back to the autocovariance (Wiener-Khinchin).
+    fft(transform, false);
+    for(auto &value : transform)
+    {
+        value = std::norm(value);
+    }
+    fft(transform, true);
+
+    std::vector<double> sums(m_size);
+    for(std::size_t t = 0; t < m_size; ++t)
+    {
+        sums[t] = transform[t].real() / length;
+    }
+
+    return sums;
+}
+
+std::vector<double> DataArray::autoCorrelation() const
+{
+    std::vector<double> sums = autoCovarianceSums();
+    std::vector<double> autoCorrelationData(m_size);
+
+    // The periodic sum at time t is the non-wrapping one plus the part that wrapped, which is the
+    // non-wrapping sum at time N - t.
+    for(std::size_t t = 0; t < m_size; ++t)
+    {
+        autoCorrelationData[t] = (sums[t] + (t ? sums[m_size - t] : 0)) / sums[0];
+    }
+
+    return autoCorrelationData;
+}
+
 std::vector<double> DataArray::autoCorrelation(int t1, int t2) const
 {
     std::vector<double> autoCorrelationData;
+    if(m_size == 0)
+    {
+        return autoCorrelationData;
+    }
+
+    std::vector<double> all = autoCorrelation();
     autoCorrelationData.reserve(t2-t1);
+    long long size = static_cast<long long>(m_size);
     for(int t = t1; t < t2; ++t)
     {
-        autoCorrelationData.push_back(autoCorrelation(t));
+        autoCorrelationData.push_back(all[((t % size) + size) % size]);
     }
 
     return autoCorrelationData;
 }
 
-int DataArray::getSize() const
+double DataArray::integratedAutoCorrelationTime(double c) const
+{
+    if(m_size < 2)
+    {
+        return 0.5;
+    }
+
+    // A constant trace has no fluctuations to correlate, and dividing by its zero variance would give NaN.
+    std::vector<double> sums = autoCovarianceSums();
+    if(sums[0] == 0)
+    {
+        return 0.5;
+    }
+    double variance = sums[0] / m_size;
+
+    double tau = 0.5;
+    for(std::size_t t = 1; t < m_size; ++t)
+    {
+        tau += sums[t] / static_cast<double>(m_size - t) / variance;
+        if(t >= c * tau)
+        {
+            break;
+        }
+    }
+
+    return tau;
+}
+
+std::size_t DataArray::getSize() const
 {
 	return m_size;
-}
\ No newline at end of file
+}
+
+std::vector<double> DataArray::blockPowerSums(int order, int blockSize) const
+{
+    std::size_t blockCount = blockSize > 0 ? m_size / blockSize : 0;
+    std::vector<double> sums(blockCount * order, 0);
+
+    for(std::size_t block = 0; block < blockCount; ++block)
+    {
+        double *blockSums = &sums[block * order];
+        for(std::size_t point = block * blockSize; point < (block + 1) * blockSize; ++point)
+        {
+            double power = 1;
+            for(int k = 0; k < order; ++k)
+            {
+                power *= m_data[point];
+                blockSums[k] += power;
+            }
+        }
+    }
+
+    return sums;
+}
+
+double DataArray::bootstrapError(const IDataFunctor &function, int resampleCount, RandomEngine &generator, int blockSize, int threadCount) const
+{
+    blockSize = std::max(blockSize, 1);
+    std::size_t blockCount = m_size / blockSize;
+    if(blockCount < 1 || resampleCount < 2)
+    {
+        generator.longJump();
+        return 0;
+    }
+
+    const IMomentFunctor *momentFunction = dynamic_cast<const IMomentFunctor*>(&function);
+    int order = momentFunction ? momentFunction->getOrder() : 0;
+    std::vector<double> sums = blockPowerSums(order, blockSize);
+
+    // Resamples are handed out in chunks, chunk c drawing from the generator jumped c times.
+    const int chunkSize = 64;
+    int chunkCount = (resampleCount + chunkSize - 1) / chunkSize;
+    threadCount = std::max(1, std::min(threadCount, chunkCount));
+
+    std::vector<double> estimates(resampleCount);
+    runThreads(threadCount, [&](int thread)
+    {
+        RandomEngine stream = generator;
+        for(int jump = 0; jump < thread; ++jump)
+        {
+            stream.jump();
+        }
+
+        DataArray sample(blockCount * blockSize);
+        std::vector<double> moments(order + 1, 0);
+        std::vector<double> total(order, 0);
+
+        for(int chunk = thread; chunk < chunkCount; chunk += threadCount)
+        {
+            RandomEngine local = stream;
+            for(int resample = chunk * chunkSize; resample < std::min((chunk + 1) * chunkSize, resampleCount); ++resample)
+            {
+                if(momentFunction)
+                {
+                    std::fill(total.begin(), total.end(), 0);
+                    for(std::size_t i = 0; i < blockCount; ++i)
+                    {
+                        std::uint64_t word = local();
+                        const double *blockSums = &sums[takeBounded(word, blockCount) * order];
+                        for(int k = 0; k < order; ++k)
+                        {
+                            total[k] += blockSums[k];
+                        }
+                    }
+
+                    moments[0] = 1;
+                    for(int k = 1; k <= order; ++k)
+                    {
+                        moments[k] = total[k - 1] / (static_cast<double>(blockCount) * blockSize);
+                    }
+                    estimates[resample] = momentFunction->fromMoments(moments);
+                }
+                else
+                {
+                    sample.clear();
+                    for(std::size_t i = 0; i < blockCount; ++i)
+                    {
+                        std::uint64_t word = local();
+                        std::size_t first = takeBounded(word, blockCount) * blockSize;
+                        for(std::size_t point = first; point < first + blockSize; ++point)
+                        {
+                            sample.push_back(m_data[point]);
+                        }
+                    }
+                    estimates[resample] = function(sample);
+                }
+            }
+
+            for(int jump = 0; jump < threadCount; ++jump)
+            {
+                stream.jump();
+            }
+        }
+    });
+
+    // Fewer than 2^64 chunk streams are ever used, a long jump gets past all of them.
+    generator.longJump();
+
+    return spread(estimates);
+}
+
+double DataArray::jackknifeError(const IDataFunctor &function, int blockSize, int threadCount) const
+{
+    blockSize = std::max(blockSize, 1);
+    std::size_t blockCount = m_size / blockSize;
+    if(blockCount < 2)
+    {
+        return 0;
+    }
+
+    const IMomentFunctor *momentFunction = dynamic_cast<const IMomentFunctor*>(&function);
+    int order = momentFunction ? momentFunction->getOrder() : 0;
+    std::vector<double> sums = blockPowerSums(order, blockSize);
+
+    std::vector<double> total(order, 0);
+    for(std::size_t block = 0; block < blockCount; ++block)
+    {
+        for(int k = 0; k < order; ++k)
+        {
+            total[k] += sums[block * order + k];
+        }
+    }
+
+    threadCount = static_cast<int>(std::max<std::size_t>(1, std::min<std::size_t>(threadCount, blockCount)));
+
+    std::vector<double> estimates(blockCount);
+    runThreads(threadCount, [&](int thread)
+    {
+        DataArray sample((blockCount - 1) * blockSize);
+        std::vector<double> moments(order + 1, 0);
+
+        for(std::size_t block = thread; block < blockCount; block += threadCount)
+        {
+            if(momentFunction)
+            {
+                // Leaving a block out only takes its sums off the totals.
+                moments[0] = 1;
+                for(int k = 1; k <= order; ++k)
+                {
+                    moments[k] = (total[k - 1] - sums[block * order + k - 1]) /
+                                 (static_cast<double>(blockCount - 1) * blockSize);
+                }
+                estimates[block] = momentFunction->fromMoments(moments);
+            }
+            else
+            {
+                sample.clear();
+                for(std::size_t point = 0; point < blockCount * blockSize; ++point)
+                {
+                    if(point / blockSize != block)
+                    {
+                        sample.push_back(m_data[point]);
+                    }
+                }
+                estimates[block] = function(sample);
+            }
+        }
+    });
+
+    return std::sqrt(blockCount - 1.0) * spread(estimates);
+}
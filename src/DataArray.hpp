@@ -2,10 +2,12 @@
 #define DataArray_hpp
 
 #include <vector>
+#include <cstddef>
 #include <cmath>
 #include <random>
 #include <iostream>
 #include <random>
+#include "RandomEngine.hpp"
 
 
 /**
@@ -25,7 +27,25 @@ private:
     /**
      *\brief Member variable to hold the size of the sample set.
      */
-    int m_size;
+    std::size_t m_size;
+
+    /**
+     *\brief Sums of products of the mean subtracted samples a given time apart, without wrapping around.
+     *
+     * Computed for every time at once by zero padding the samples to at least twice their length and
+     * using fast Fourier transforms, which takes O(N log N).
+     *
+     *\return vector whose element t is the sum over i < N - t of (x_i - mean)(x_{i+t} - mean).
+     */
+    std::vector<double> autoCovarianceSums() const;
+
+    /**
+     *\brief Sums of the powers of the samples in each block, used by the resampling methods.
+     *\param order highest power.
+     *\param blockSize number of consecutive samples in a block.
+     *\return vector with the sums of powers 1 to order of block b at b * order to (b + 1) * order - 1.
+     */
+    std::vector<double> blockPowerSums(int order, int blockSize) const;
 
 public:
 	/**
@@ -49,6 +69,42 @@ public:
 			 *\return a floating point value representing the result of the function.
 			 */
 			virtual double operator()(const DataArray &data) const = 0;
+
+			/**
+			 *\brief Virtual destructor so functors can be deleted through the interface.
+			 */
+			virtual ~IDataFunctor() = default;
+	};
+
+	/**
+	 *\class IMomentFunctor
+	 *\brief Interface for a functor that only depends on the first few moments of the data.
+	 *
+	 * Most derived quantities, such as a susceptibility or a Binder cumulant, are functions of the means
+	 * of a few powers of the samples. Knowing this the resampling methods work on sums of those powers
+	 * instead of building resampled arrays, so a jackknife estimate costs O(1) and a bootstrap resample
+	 * O(number of blocks).
+	 */
+	class IMomentFunctor : public IDataFunctor
+	{
+		public:
+			/**
+			 *\brief Getter for the highest power of the samples the function depends on.
+			 *\return Integer value representing the order.
+			 */
+			virtual int getOrder() const = 0;
+
+			/**
+			 *\brief Evaluates the function from the moments of the data.
+			 *\param moments vector of getOrder() + 1 values, element k is the mean of the k-th power of the samples.
+			 *\return a floating point value representing the result of the function.
+			 */
+			virtual double fromMoments(const std::vector<double> &moments) const = 0;
+
+			/**
+			 *\brief Evaluates the function on the moments of the data, see IDataFunctor.
+			 */
+			double operator()(const DataArray &data) const override;
 	};
 
 	/**
@@ -58,32 +114,32 @@ public:
 
     /**
      *\brief Constructor that takes reserves space.
-     *\param size integer instance representing size of sample set.
+     *\param size number of samples to reserve space for.
      *
      * This constructor will reserve space for the vector which is more efficient. If the user
      * knows how many data points will be in the set before use this constructor should be used.
      */
-    DataArray(int size);
+    DataArray(std::size_t size);
 
 	/** 
      *\brief Getter method for size of data.
-     *\return Integer value representing the size of the DataArray.
+     *\return the number of samples in the DataArray.
      */
-    int getSize() const;
+    std::size_t getSize() const;
 
     /**
      *\brief operator() overload to accesses samples.
-     *\param index integer value representing  the index of the sample being accessed.
+     *\param index the index of the sample being accessed.
      *\return floating point reference to the sample so it can be used or changed.
      */
-    double& operator[](int index);
+    double& operator[](std::size_t index);
 
     /**
      *\brief Constant operator() overload to access samples in a constant instance.
      *
      * See non constant version
      */
-    const double& operator[](int index) const;
+    const double& operator[](std::size_t index) const;
 
     /**
      *\brief Adds a sample to the DataArray.
@@ -99,14 +155,19 @@ public:
      */
     void pop_back(); 
 
+    /**
+     *\brief Removes every sample from DataArray, keeping the memory reserved.
+     */
+    void clear();
+
     /**
      *\brief Reserves memory for DataArray making it faster.
-     *\param size integer value representing the number of elements to reserve space for.
+     *\param size the number of elements to reserve space for.
      *
      * This method reserves space for the vector member variable and should be used when the number of samples
      * being recorded is known beforehand.
      */
-    void reserve(int size);
+    void reserve(std::size_t size);
 
     /**
      *\brief Helper function to sum the samples in the data.
@@ -150,19 +211,83 @@ public:
 
     /**
      *\brief function to calculate the autocorrelation function for a specific computer time.
+     *
+     * The samples are treated as periodic, time i + t wraps around to (i + t) % N. This rescans the
+     * data, to get many times use one of the other overloads.
+     *
      *\param t time value to compute autocorrelation of data for.
      *\return floating point value representing value of autocorrelation function.
      */
     double autoCorrelation(int t) const;
 
+    /**
+     *\brief function to calculate the autocorrelation function for every computer time at once.
+     *
+     * Gives the same values as autoCorrelation(int) for t = 0 to N - 1 but takes O(N log N) rather than
+     * O(N^2), the periodic sums are put together from the non-wrapping ones of autoCovarianceSums().
+     *
+     *\return vector of floating point values representing values of autocorrelation function indexed
+     * by the time.
+     */
+    std::vector<double> autoCorrelation() const;
+
     /**
      *\brief function to calculate the autocorrelation function for a range computer times.
+     *
+     * Uses the O(N log N) method of autoCorrelation().
+     *
      *\param t1 initial time value to compute autocorrelation of data for.
      *\param t2 final time value to compute autocorrelation for.
      *\return vector of floating point values representing values of autocorrelation function indexed 
      * according to their position in the vector.
      */
     std::vector<double> autoCorrelation(int t1, int t2) const;
+
+    /**
+     *\brief function to estimate the integrated autocorrelation time with automatic windowing.
+     *
+     * Sums the normalised autocorrelation rho(t), estimated without wrapping around, as
+     * tau = 1/2 + sum_{t=1}^{W} rho(t), stopping at the first window W >= c * tau (Sokal's criterion).
+     * The error of the mean of correlated data is then sqrt(2 * tau) times the naive error(). A
+     * constant trace gives 1/2, as uncorrelated data does.
+     *
+     *\param c window factor, larger is less biased but noisier.
+     *\return floating point value representing the integrated autocorrelation time in samples.
+     */
+    double integratedAutoCorrelationTime(double c = 5.0) const;
+
+    /**
+     *\brief function to calculate the bootstrap error of a function of the data.
+     *
+     * The data are cut into consecutive blocks of blockSize samples, a trailing partial block being left
+     * out, and each resample draws as many blocks with replacement. Blocks longer than the correlation
+     * time keep the correlations within them, so the error stays correct for correlated data. The
+     * resamples are shared between threads in chunks that each draw from their own stream, jumped off
+     * the generator, so the result does not depend on the number of threads. Resamples of an
+     * IMomentFunctor are sums of per block moments, other functors are handed a per thread buffer.
+     *
+     *\param function the function of the data.
+     *\param resampleCount number of bootstrap resamples.
+     *\param generator RandomEngine reference the streams are jumped off, it is left long jumped past them.
+     *\param blockSize number of consecutive samples in a block.
+     *\param threadCount number of threads to use.
+     *\return floating point value representing the standard deviation of the function over the resamples.
+     */
+    double bootstrapError(const IDataFunctor &function, int resampleCount, RandomEngine &generator, int blockSize = 1, int threadCount = 1) const;
+
+    /**
+     *\brief function to calculate the jackknife error of a function of the data.
+     *
+     * The data are cut into blocks as in bootstrapError() and the function is evaluated with each block
+     * left out in turn. For an IMomentFunctor each estimate is the total moments minus those of the
+     * block, other functors are handed a per thread buffer.
+     *
+     *\param function the function of the data.
+     *\param blockSize number of consecutive samples in a block.
+     *\param threadCount number of threads to use.
+     *\return floating point value representing the jackknife error, 0 if there are fewer than two blocks.
+     */
+    double jackknifeError(const IDataFunctor &function, int blockSize = 1, int threadCount = 1) const;
 };
 
 #endif /* DataArray_hpp */
\ No newline at end of file
@@ -0,0 +1,314 @@
+#include "Ensemble.hpp"
+#include "RejectionFreeEngine.hpp"
+#include "FixedVoterArray.hpp"
+#include "placeStubborn.hpp"
+#include "MultiSpinVoterArray.hpp"
+#include <algorithm>
+#include <cstdlib> // For std::abs of long long.
+#include <iomanip> // For std::setprecision.
+
+Ensemble::Ensemble(const VoterInputParameters &parameters, int replicaCount, const RandomEngine &generator) :
+	m_parameters(parameters),
+	m_replicaCount{replicaCount},
+	m_generator(generator),
+	m_sum(parameters.sweeps, 0),
+	m_squareSum(parameters.sweeps, 0),
+	m_absoluteSum(parameters.sweeps, 0),
+	m_final(replicaCount, 0),
+	m_consensusTime(replicaCount, -1)
+{
+
+}
+
+void Ensemble::run(ThreadPool &pool)
+{
+	// Split the streams off in order so that replica r always gets the same one.
+	RandomEngine generator = m_generator;
+	bool multiSpin = m_parameters.engine == "multi-spin";
+
+	// An exception cannot leave a pool task, so the first is kept and the replicas still queued are dropped.
+	m_error = nullptr;
+	for(int replica = 0; replica < m_replicaCount; ++replica)
+	{
+		if(!multiSpin || replica % MultiSpinVoterArray::laneCount == 0)
+		{
+			pool.submit([this, multiSpin, replica, generator]
+			{
+				{
+					std::lock_guard<std::mutex> lock(m_mutex);
+					if(m_error)
+					{
+						return;
+					}
+				}
+
+				try
+				{
+					if(multiSpin)
+					{
+						runLanes(replica, generator);
+					}
+					else
+					{
+						runReplica(replica, generator);
+					}
+				}
+				catch(...)
+				{
+					std::lock_guard<std::mutex> lock(m_mutex);
+					if(!m_error)
+					{
+						m_error = std::current_exception();
+					}
+				}
+			});
+		}
+		generator.longJump();
+	}
+	pool.wait();
+
+	if(m_error)
+	{
+		std::rethrow_exception(m_error);
+	}
+}
+
+void Ensemble::runReplica(int replica, RandomEngine generator)
+{
+	std::unique_ptr<VoterArray> latticePointer = makeVoterArray(generator, m_parameters.rowCount, m_parameters.colCount, m_parameters.initialOrder, m_parameters.layout);
+	VoterArray &lattice = *latticePointer;
+	placeStubborn(lattice, m_parameters.stubbornPlacement, m_parameters.stubbornNumber, m_parameters.stubbornMask, generator);
+
+	std::vector<long long> trace;
+	trace.reserve(m_parameters.sweeps);
+
+	// Time the replica froze, -1 until it does.
+	double consensusTime = lattice.frozen() ? 0 : -1;
+	if(consensusTime < 0 && m_parameters.engine == "rejection-free")
+	{
+		RejectionFreeEngine engine(lattice);
+		for(long long sweep = 0; sweep < m_parameters.sweeps; ++sweep)
+		{
+			engine.advance(sweep + 1, generator);
+			trace.push_back(lattice.magnetization());
+			if(lattice.frozen())
+			{
+				consensusTime = engine.getTime();
+				break;
+			}
+		}
+	}
+	else if(consensusTime < 0 && m_parameters.engine == "synchronous")
+	{
+		for(long long sweep = 0; sweep < m_parameters.sweeps; ++sweep)
+		{
+			lattice.synchronousSweep(generator);
+			trace.push_back(lattice.magnetization());
+			if(lattice.frozen())
+			{
+				consensusTime = sweep + 1;
+				break;
+			}
+		}
+	}
+	else if(consensusTime < 0)
+	{
+		for(long long sweep = 0; sweep < m_parameters.sweeps; ++sweep)
+		{
+			lattice.sweep(generator);
+			trace.push_back(lattice.magnetization());
+			if(lattice.frozen())
+			{
+				consensusTime = sweep + lattice.freezingFraction();
+				break;
+			}
+		}
+	}
+
+	// A frozen replica would keep its magnetization for the rest of the sweeps, so they are not run.
+	trace.resize(m_parameters.sweeps, lattice.magnetization());
+
+	std::vector<__int128> squareSum(m_parameters.sweeps);
+	std::vector<long long> absoluteSum(m_parameters.sweeps);
+	for(long long sweep = 0; sweep < m_parameters.sweeps; ++sweep)
+	{
+		squareSum[sweep]   = static_cast<__int128>(trace[sweep]) * trace[sweep];
+		absoluteSum[sweep] = std::abs(trace[sweep]);
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_final[replica] = lattice.orderParameter();
+	m_consensusTime[replica] = consensusTime;
+	add(trace, squareSum, absoluteSum);
+}
+
+void Ensemble::runLanes(int firstReplica, RandomEngine generator)
+{
+	MultiSpinVoterArray lattice(generator, m_parameters.rowCount, m_parameters.colCount, m_parameters.initialOrder,
+		m_parameters.stubbornPlacement, m_parameters.stubbornNumber, m_parameters.stubbornMask);
+
+	// The last group can have lanes to spare, they are simulated but not counted.
+	int laneCount = std::min(MultiSpinVoterArray::laneCount, m_replicaCount - firstReplica);
+
+	std::vector<long long> sum(m_parameters.sweeps, 0);
+	std::vector<__int128> squareSum(m_parameters.sweeps, 0);
+	std::vector<long long> absoluteSum(m_parameters.sweeps, 0);
+	long long magnetization[MultiSpinVoterArray::laneCount];
+	lattice.magnetizations(magnetization);
+
+	// The lanes that are counted and can still change, a lane leaving the set has just frozen. Once
+	// every counted lane has the remaining sweeps only repeat the last order parameters.
+	std::vector<double> consensusTime(laneCount, -1);
+	std::uint64_t counted = laneCount < MultiSpinVoterArray::laneCount ? (std::uint64_t(1) << laneCount) - 1 : ~std::uint64_t(0);
+	std::uint64_t live = lattice.liveLanes(counted);
+	for(int lane = 0; lane < laneCount; ++lane)
+	{
+		if(!((live >> lane) & 1))
+		{
+			consensusTime[lane] = 0;
+		}
+	}
+
+	for(long long sweep = 0; sweep < m_parameters.sweeps; ++sweep)
+	{
+		if(live)
+		{
+			lattice.sweep(generator);
+			lattice.magnetizations(magnetization);
+
+			std::uint64_t stillLive = lattice.liveLanes(live);
+			for(std::uint64_t frozen = live & ~stillLive; frozen; frozen &= frozen - 1)
+			{
+				consensusTime[__builtin_ctzll(frozen)] = sweep + 1;
+			}
+			live = stillLive;
+		}
+
+		for(int lane = 0; lane < laneCount; ++lane)
+		{
+			sum[sweep]         += magnetization[lane];
+			squareSum[sweep]   += static_cast<__int128>(magnetization[lane]) * magnetization[lane];
+			absoluteSum[sweep] += std::abs(magnetization[lane]);
+		}
+	}
+
+	std::vector<double> orderParameter;
+	lattice.orderParameters(orderParameter);
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for(int lane = 0; lane < laneCount; ++lane)
+	{
+		m_final[firstReplica + lane] = orderParameter[lane];
+		m_consensusTime[firstReplica + lane] = consensusTime[lane];
+	}
+	add(sum, squareSum, absoluteSum);
+}
+
+void Ensemble::add(const std::vector<long long> &sum, const std::vector<__int128> &squareSum, const std::vector<long long> &absoluteSum)
+{
+	// Integer addition is exact, so the order the replicas finish in does not change the totals.
+	for(long long sweep = 0; sweep < m_parameters.sweeps; ++sweep)
+	{
+		m_sum[sweep]         += sum[sweep];
+		m_squareSum[sweep]   += squareSum[sweep];
+		m_absoluteSum[sweep] += absoluteSum[sweep];
+	}
+}
+
+DataArray Ensemble::meanOrderParameter() const
+{
+	double siteCount = static_cast<double>(m_parameters.rowCount) * m_parameters.colCount;
+	DataArray data(m_parameters.sweeps);
+	for(const auto &sum : m_sum)
+	{
+		data.push_back(static_cast<double>(sum) / siteCount / m_replicaCount);
+	}
+	return data;
+}
+
+DataArray Ensemble::squareOrderParameter() const
+{
+	double siteCount = static_cast<double>(m_parameters.rowCount) * m_parameters.colCount;
+	DataArray data(m_parameters.sweeps);
+	for(const auto &sum : m_squareSum)
+	{
+		data.push_back(static_cast<double>(sum) / (siteCount * siteCount) / m_replicaCount);
+	}
+	return data;
+}
+
+DataArray Ensemble::absoluteOrderParameter() const
+{
+	double siteCount = static_cast<double>(m_parameters.rowCount) * m_parameters.colCount;
+	DataArray data(m_parameters.sweeps);
+	for(const auto &sum : m_absoluteSum)
+	{
+		data.push_back(static_cast<double>(sum) / siteCount / m_replicaCount);
+	}
+	return data;
+}
+
+VoterResults Ensemble::results() const
+{
+	DataArray final(m_replicaCount);
+	DataArray absoluteFinal(m_replicaCount);
+	for(const auto &orderParameter : m_final)
+	{
+		final.push_back(orderParameter);
+		absoluteFinal.push_back(std::abs(orderParameter));
+	}
+
+	VoterResults results;
+	results.orderParameter              = final.mean();
+	results.orderParameterError         = final.error();
+	results.absoluteOrderParameter      = absoluteFinal.mean();
+	results.absoluteOrderParameterError = absoluteFinal.error();
+	results.squareOrderParameter        = final.squareMean();
+
+	DataArray consensusTimes(m_replicaCount);
+	for(double time : m_consensusTime)
+	{
+		if(time >= 0)
+		{
+			consensusTimes.push_back(time);
+		}
+	}
+	results.replicaCount  = m_replicaCount;
+	results.absorbedCount = static_cast<int>(consensusTimes.getSize());
+	if(consensusTimes.getSize())
+	{
+		results.absorbed           = true;
+		results.consensusTime      = consensusTimes.mean();
+		results.consensusTimeError = consensusTimes.getSize() > 1 ? consensusTimes.error() : 0;
+	}
+	return results;
+}
+
+void Ensemble::writeReplicas(std::ostream &out) const
+{
+	// The consensus times with every digit, so the fraction of a sweep that places the update is kept.
+	std::streamsize precision = out.precision();
+	out << "# replica final-order consensus-time\n";
+	for(int replica = 0; replica < m_replicaCount; ++replica)
+	{
+		out << replica << ' ' << m_final[replica] << ' ' << std::setprecision(17) << m_consensusTime[replica] << std::setprecision(precision) << '\n';
+	}
+}
+
+std::ostream& operator<<(std::ostream &out, const Ensemble &ensemble)
+{
+	DataArray mean     = ensemble.meanOrderParameter();
+	DataArray square   = ensemble.squareOrderParameter();
+	DataArray absolute = ensemble.absoluteOrderParameter();
+
+	for(std::size_t sweep = 0; sweep < mean.getSize(); ++sweep)
+	{
+		// Error in the mean over the replicas.
+		double variance = square[sweep] - mean[sweep] * mean[sweep];
+		double error = ensemble.m_replicaCount > 1 ? std::sqrt(std::max(variance, 0.0) / (ensemble.m_replicaCount - 1)) : 0;
+
+		out << sweep << ' ' << mean[sweep] << ' ' << error << ' ' << square[sweep] << ' ' << absolute[sweep] << '\n';
+	}
+
+	return out;
+}
@@ -0,0 +1,153 @@
+#ifndef Ensemble_hpp
+#define Ensemble_hpp
+
+#include <vector>
+#include <mutex>
+#include <exception>
+#include <iostream>
+#include "VoterArray.hpp"
+#include "VoterInputParameters.hpp"
+#include "VoterResults.hpp"
+#include "DataArray.hpp"
+#include "ThreadPool.hpp"
+#include "RandomEngine.hpp"
+
+/**
+ *\file
+ *\class Ensemble
+ *\brief Runs independent replicas of a Voter simulation and aggregates their order parameters.
+ *
+ * Replica r draws from the stream that starts r long jumps (2^192 outputs each) after the base
+ * generator, so a run is reproducible whatever the number of threads and the order the replicas
+ * finish in. Only the moments of the magnetization over the replicas are kept for each sweep, as exact
+ * integer sums that a finished replica adds straight away, so they come out the same however the
+ * replicas were scheduled and the memory does not grow with the number of replicas.
+ *
+ * With the multi-spin engine the replicas run 64 at a time as the lanes of a MultiSpinVoterArray, each
+ * group drawing from the stream of its first replica.
+ *
+ * A replica stops at an absorbing state as a single run does, its order parameter is carried on
+ * unchanged for the sweeps it skips and the time it froze is kept.
+ */
+class Ensemble
+{
+private:
+	/// Parameters shared by every replica.
+	VoterInputParameters m_parameters;
+
+	/// Number of replicas.
+	int m_replicaCount;
+
+	/// Generator the replica streams are split from.
+	RandomEngine m_generator;
+
+	/// Sum over the replicas of the magnetization for each sweep.
+	std::vector<long long> m_sum;
+
+	/// Sum over the replicas of the square of the magnetization for each sweep, the square of a large
+	/// lattice alone can overflow 64 bits.
+	std::vector<__int128> m_squareSum;
+
+	/// Sum over the replicas of the absolute magnetization for each sweep.
+	std::vector<long long> m_absoluteSum;
+
+	/// Order parameter of each replica after the final sweep.
+	std::vector<double> m_final;
+
+	/// Time each replica reached an absorbing state, -1 if it did not.
+	std::vector<double> m_consensusTime;
+
+	/// First exception thrown by a replica, rethrown by run() once the pool is idle.
+	std::exception_ptr m_error;
+
+	/// Guards the sums, the final values and m_error.
+	std::mutex m_mutex;
+
+	/**
+	 *\brief Adds the sums over finished replicas for each sweep to the totals.
+	 *\param sum sum of the magnetization.
+	 *\param squareSum sum of the square of the magnetization.
+	 *\param absoluteSum sum of the absolute magnetization.
+	 *
+	 * Must be called with m_mutex held.
+	 */
+	void add(const std::vector<long long> &sum, const std::vector<__int128> &squareSum, const std::vector<long long> &absoluteSum);
+
+	/**
+	 *\brief Runs a single replica and adds its trace to the sums.
+	 *\param replica index of the replica.
+	 *\param generator RandomEngine for the replica.
+	 */
+	void runReplica(int replica, RandomEngine generator);
+
+	/**
+	 *\brief Runs a group of replicas as the lanes of a multi-spin lattice and adds their traces to the sums.
+	 *\param firstReplica index of the replica in the first lane.
+	 *\param generator RandomEngine for the group.
+	 */
+	void runLanes(int firstReplica, RandomEngine generator);
+
+public:
+	/**
+	 *\brief Constructor.
+	 *\param parameters input parameters shared by every replica.
+	 *\param replicaCount number of replicas.
+	 *\param generator base generator that the replica streams are split from.
+	 *
+	 * The engine of the parameters picks the update, sequential, rejection-free, synchronous or multi-spin.
+	 */
+	Ensemble(const VoterInputParameters &parameters, int replicaCount, const RandomEngine &generator);
+
+	/**
+	 *\brief Runs every replica on the thread pool and waits for them.
+	 *\param pool ThreadPool reference to run the replicas on.
+	 *
+	 * The first exception a replica throws is rethrown once the pool is idle, the replicas not yet
+	 * started are then skipped.
+	 */
+	void run(ThreadPool &pool);
+
+	/**
+	 *\brief Getter for the replica averaged order parameter.
+	 *\return DataArray holding the mean order parameter for each sweep.
+	 */
+	DataArray meanOrderParameter() const;
+
+	/**
+	 *\brief Getter for the replica averaged square of the order parameter.
+	 *\return DataArray holding the mean square order parameter for each sweep.
+	 */
+	DataArray squareOrderParameter() const;
+
+	/**
+	 *\brief Getter for the replica averaged absolute order parameter.
+	 *\return DataArray holding the mean absolute order parameter for each sweep.
+	 */
+	DataArray absoluteOrderParameter() const;
+
+	/**
+	 *\brief Summarises the replicas after the final sweep.
+	 *\return VoterResults with the means and errors over the replicas, and over the consensus times of
+	 * those that were absorbed.
+	 */
+	VoterResults results() const;
+
+	/**
+	 *\brief Writes a line per replica, its index, final order parameter and consensus time, -1 if there was none.
+	 *\param out std::ostream reference that is the stream being output to.
+	 */
+	void writeReplicas(std::ostream &out) const;
+
+	/**
+	 *\brief operator<< overload to output the per sweep summary to a stream.
+	 *\param out std::ostream reference that is the stream being output to.
+	 *\param ensemble constant Ensemble reference to be printed.
+	 *\return std::ostream reference so that the operator can be chained.
+	 *
+	 * Each line holds the sweep, the mean order parameter and its error, the mean square order
+	 * parameter and the mean absolute order parameter.
+	 */
+	friend std::ostream& operator<<(std::ostream &out, const Ensemble &ensemble);
+};
+
+#endif /* Ensemble_hpp */
@@ -0,0 +1,23 @@
+#include "FixedVoterArray.hpp"
+
+std::unique_ptr<VoterArray> makeVoterArray(RandomEngine &generator, int rows, int cols, double initialOrder,
+	VoterArray::Layout layout)
+{
+	if(layout == VoterArray::RowMajor && rows == cols)
+	{
+		switch(rows)
+		{
+			case 64:   return std::unique_ptr<VoterArray>(new FixedVoterArray<64,64>(generator, initialOrder));
+			case 128:  return std::unique_ptr<VoterArray>(new FixedVoterArray<128,128>(generator, initialOrder));
+			case 256:  return std::unique_ptr<VoterArray>(new FixedVoterArray<256,256>(generator, initialOrder));
+			case 512:  return std::unique_ptr<VoterArray>(new FixedVoterArray<512,512>(generator, initialOrder));
+			case 1024: return std::unique_ptr<VoterArray>(new FixedVoterArray<1024,1024>(generator, initialOrder));
+			case 2048: return std::unique_ptr<VoterArray>(new FixedVoterArray<2048,2048>(generator, initialOrder));
+			case 4096: return std::unique_ptr<VoterArray>(new FixedVoterArray<4096,4096>(generator, initialOrder));
+			case 8192: return std::unique_ptr<VoterArray>(new FixedVoterArray<8192,8192>(generator, initialOrder));
+		}
+	}
+
+	// Fall back on the runtime sized lattice.
+	return std::unique_ptr<VoterArray>(new VoterArray(generator, rows, cols, initialOrder, layout));
+}
@@ -0,0 +1,139 @@
+#ifndef FixedVoterArray_hpp
+#define FixedVoterArray_hpp
+
+#include <memory>
+#include "VoterArray.hpp"
+#include "RandomEngine.hpp"
+
+/**
+ *\file
+ *\class FixedVoterArray
+ *\brief VoterArray with compile-time power of two dimensions.
+ *
+ * The storage, always in the RowMajor layout, and every observable are those of VoterArray, only the
+ * sweep is specialised. With the
+ * dimensions known at compile time the periodic boundaries wrap with bit masks instead of %, the row,
+ * column and direction are taken from the random word with shifts, and the neighbour is selected
+ * from small offset tables so the update has no branches apart from the stubborn check. With stubborn
+ * voters present the sites are drawn from the mobile sites as in VoterArray::sweep().
+ *
+ *\tparam Rows number of rows, a power of two.
+ *\tparam Cols number of columns, a power of two.
+ */
+template<int Rows, int Cols>
+class FixedVoterArray : public VoterArray
+{
+	static_assert(Rows > 0 && (Rows & (Rows - 1)) == 0, "Rows must be a power of two");
+	static_assert(Cols > 0 && (Cols & (Cols - 1)) == 0, "Cols must be a power of two");
+
+public:
+	/**
+	 *\brief Constructor that randomises lattice, see VoterArray.
+	 *\param generator RandomEngine reference for generating random numbers.
+	 *\param initialOrder initial value of the order parameter.
+	 */
+	FixedVoterArray(RandomEngine &generator, double initialOrder) : VoterArray(generator, Rows, Cols, initialOrder)
+	{
+
+	}
+
+	/**
+	 *\brief Performs a sweep of random sequential updates, see VoterArray::sweep().
+	 *\param generator RandomEngine reference for random number generation.
+	 */
+	void sweep(RandomEngine &generator) override
+	{
+		// Offsets of the four neighbours in the order right, down, left and up.
+		static const int rowOffset[4] = {0, 1, 0, -1};
+		static const int colOffset[4] = {1, 0, -1, 0};
+
+		const std::size_t blockSize = 1024;
+		std::uint64_t words[blockSize];
+
+		long long freezing = freezingChange();
+		m_freezingUpdate = 0;
+
+		Delta delta;
+		if(m_stubbornCount)
+		{
+			// Draw from the mobile sites only, the division by Cols is a shift.
+			const std::vector<std::size_t> &mobile = mobileSites();
+			m_sweepUpdates = mobile.size();
+			std::size_t remaining = mobile.size();
+			while(remaining)
+			{
+				std::size_t count = remaining < blockSize ? remaining : blockSize;
+				generator.fill(words, count);
+
+				for(std::size_t i = 0; i < count; ++i)
+				{
+					std::uint64_t word = words[i];
+					std::size_t site = mobile[takeBounded(word, mobile.size())];
+					int direction = static_cast<int>(takeBounded(word, 4));
+
+					int row = static_cast<int>(site / Cols);
+					int col = static_cast<int>(site % Cols);
+					int neighbourRow = (row + rowOffset[direction]) & (Rows - 1);
+					int neighbourCol = (col + colOffset[direction]) & (Cols - 1);
+					copyOpinion(row, col, site, static_cast<std::size_t>(neighbourRow) * Cols + neighbourCol, delta);
+					if(delta.activeBonds == freezing && !m_freezingUpdate)
+					{
+						m_freezingUpdate = mobile.size() - remaining + i + 1;
+					}
+				}
+
+				remaining -= count;
+			}
+			applyDelta(delta);
+			return;
+		}
+
+		// No site is stubborn, so every draw is an update.
+		const std::size_t siteCount = static_cast<std::size_t>(Rows) * Cols;
+		m_sweepUpdates = siteCount;
+		std::size_t remaining = siteCount;
+		while(remaining)
+		{
+			std::size_t count = remaining < blockSize ? remaining : blockSize;
+			generator.fill(words, count);
+
+			for(std::size_t i = 0; i < count; ++i)
+			{
+				std::uint64_t word = words[i];
+				int row = static_cast<int>(takeBounded(word, Rows));
+				int col = static_cast<int>(takeBounded(word, Cols));
+				int direction = static_cast<int>(takeBounded(word, 4));
+
+				std::size_t site = static_cast<std::size_t>(row) * Cols + col;
+				int neighbourRow = (row + rowOffset[direction]) & (Rows - 1);
+				int neighbourCol = (col + colOffset[direction]) & (Cols - 1);
+				copyOpinion(row, col, site, static_cast<std::size_t>(neighbourRow) * Cols + neighbourCol, delta);
+				if(delta.activeBonds == freezing && !m_freezingUpdate)
+				{
+					m_freezingUpdate = siteCount - remaining + i + 1;
+				}
+			}
+
+			remaining -= count;
+		}
+		applyDelta(delta);
+	}
+};
+
+/**
+ *\brief Creates the lattice for a simulation.
+ *
+ * Square row-major lattices with a power of two side from 64 to 8192 get a FixedVoterArray specialised
+ * for their size, every other size or layout gets the runtime sized VoterArray.
+ *
+ *\param generator RandomEngine reference for generating random numbers.
+ *\param rows number of rows on the board.
+ *\param cols number of columns on the board.
+ *\param initialOrder initial value of the order parameter.
+ *\param layout layout of the sites in memory.
+ *\return owning pointer to the lattice.
+ */
+std::unique_ptr<VoterArray> makeVoterArray(RandomEngine &generator, int rows, int cols, double initialOrder,
+	VoterArray::Layout layout = VoterArray::RowMajor);
+
+#endif /* FixedVoterArray_hpp */
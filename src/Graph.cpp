@@ -0,0 +1,520 @@
+#include "Graph.hpp"
+#include <algorithm> // For std::sort, std::unique and std::reverse.
+#include <unordered_set> // For the edges already made by the generators.
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <limits>
+
+namespace
+{
+	/// Number of stub pairings randomRegular() tries before giving up.
+	const int maxPairings = 100;
+
+	/**
+	 *\brief Key of an undirected edge that is the same whichever way round the ends are given.
+	 */
+	std::uint64_t edgeKey(std::uint32_t a, std::uint32_t b)
+	{
+		return a < b ? (std::uint64_t(a) << 32) | b : (std::uint64_t(b) << 32) | a;
+	}
+
+	/**
+	 *\brief Checks that a number of vertices fits the 32-bit labels.
+	 */
+	void checkVertexCount(std::size_t vertexCount)
+	{
+		if(vertexCount == 0 || vertexCount > std::numeric_limits<std::uint32_t>::max())
+		{
+			throw std::runtime_error("the number of vertices must be between 1 and 2^32-1");
+		}
+	}
+}
+
+Graph::Graph(std::size_t vertexCount, const std::vector<Edge> &edges) :
+	m_offset(vertexCount + 1, 0),
+	m_label(vertexCount)
+{
+	checkVertexCount(vertexCount);
+	for(std::size_t vertex = 0; vertex < vertexCount; ++vertex)
+	{
+		m_label[vertex] = static_cast<std::uint32_t>(vertex);
+	}
+
+	// Count the degrees, place every edge at both ends, then sort and deduplicate each neighbour list.
+	for(const auto &edge : edges)
+	{
+		if(edge.first != edge.second)
+		{
+			++m_offset[edge.first + 1];
+			++m_offset[edge.second + 1];
+		}
+	}
+	for(std::size_t vertex = 0; vertex < vertexCount; ++vertex)
+	{
+		m_offset[vertex + 1] += m_offset[vertex];
+	}
+
+	m_neighbour.resize(m_offset.back());
+	std::vector<std::size_t> next(m_offset.begin(), m_offset.end() - 1);
+	for(const auto &edge : edges)
+	{
+		if(edge.first != edge.second)
+		{
+			m_neighbour[next[edge.first]++] = edge.second;
+			m_neighbour[next[edge.second]++] = edge.first;
+		}
+	}
+
+	std::size_t end = 0;
+	for(std::size_t vertex = 0; vertex < vertexCount; ++vertex)
+	{
+		auto first = m_neighbour.begin() + m_offset[vertex];
+		auto last = m_neighbour.begin() + m_offset[vertex + 1];
+		std::sort(first, last);
+		last = std::unique(first, last);
+
+		// Close up the gaps left by the repeats.
+		m_offset[vertex] = end;
+		end = std::copy(first, last, m_neighbour.begin() + end) - m_neighbour.begin();
+	}
+	m_offset[vertexCount] = end;
+	m_neighbour.resize(end);
+	m_neighbour.shrink_to_fit();
+}
+
+std::size_t Graph::getVertexCount() const
+{
+	return m_label.size();
+}
+
+std::size_t Graph::getEdgeCount() const
+{
+	return m_neighbour.size() / 2;
+}
+
+std::uint32_t Graph::getLabel(std::uint32_t vertex) const
+{
+	return m_label[vertex];
+}
+
+std::vector<std::uint32_t> Graph::breadthFirstOrder(bool byDegree) const
+{
+	std::size_t vertexCount = getVertexCount();
+
+	// Each component starts from its lowest degree vertex, found by scanning the vertices by degree.
+	std::vector<std::uint32_t> starts(vertexCount);
+	for(std::size_t vertex = 0; vertex < vertexCount; ++vertex)
+	{
+		starts[vertex] = static_cast<std::uint32_t>(vertex);
+	}
+	std::stable_sort(starts.begin(), starts.end(), [this](std::uint32_t a, std::uint32_t b)
+	{
+		return getDegree(a) < getDegree(b);
+	});
+
+	std::vector<std::uint32_t> order;
+	order.reserve(vertexCount);
+	std::vector<bool> visited(vertexCount, false);
+	std::vector<std::uint32_t> reached;
+	for(auto start : starts)
+	{
+		if(visited[start])
+		{
+			continue;
+		}
+
+		visited[start] = true;
+		order.push_back(start);
+
+		// The order itself is the queue.
+		for(std::size_t head = order.size() - 1; head < order.size(); ++head)
+		{
+			std::uint32_t vertex = order[head];
+			reached.clear();
+			for(std::size_t i = 0; i < getDegree(vertex); ++i)
+			{
+				std::uint32_t neighbour = neighbours(vertex)[i];
+				if(!visited[neighbour])
+				{
+					visited[neighbour] = true;
+					reached.push_back(neighbour);
+				}
+			}
+			if(byDegree)
+			{
+				std::stable_sort(reached.begin(), reached.end(), [this](std::uint32_t a, std::uint32_t b)
+				{
+					return getDegree(a) < getDegree(b);
+				});
+			}
+			order.insert(order.end(), reached.begin(), reached.end());
+		}
+	}
+
+	return order;
+}
+
+void Graph::reorder(Ordering ordering)
+{
+	if(ordering == Graph::NoOrdering)
+	{
+		return;
+	}
+
+	std::vector<std::uint32_t> order = breadthFirstOrder(ordering == Graph::RcmOrdering);
+	if(ordering == Graph::RcmOrdering)
+	{
+		std::reverse(order.begin(), order.end());
+	}
+
+	// order[new] is the old label, invert it and rebuild the arrays with the new labels.
+	std::size_t vertexCount = getVertexCount();
+	std::vector<std::uint32_t> relabel(vertexCount);
+	for(std::size_t vertex = 0; vertex < vertexCount; ++vertex)
+	{
+		relabel[order[vertex]] = static_cast<std::uint32_t>(vertex);
+	}
+
+	std::vector<std::size_t> offset(vertexCount + 1, 0);
+	std::vector<std::uint32_t> neighbour(m_neighbour.size());
+	std::vector<std::uint32_t> label(vertexCount);
+	for(std::size_t vertex = 0; vertex < vertexCount; ++vertex)
+	{
+		std::uint32_t old = order[vertex];
+		label[vertex] = m_label[old];
+		offset[vertex + 1] = offset[vertex] + getDegree(old);
+
+		auto first = neighbour.begin() + offset[vertex];
+		for(std::size_t i = 0; i < getDegree(old); ++i)
+		{
+			first[i] = relabel[neighbours(old)[i]];
+		}
+		std::sort(first, first + getDegree(old));
+	}
+
+	m_offset.swap(offset);
+	m_neighbour.swap(neighbour);
+	m_label.swap(label);
+}
+
+std::size_t Graph::bandwidth() const
+{
+	std::size_t width = 0;
+	for(std::size_t vertex = 0; vertex < getVertexCount(); ++vertex)
+	{
+		// The neighbours are sorted so the first and last are the furthest away.
+		std::size_t degree = getDegree(static_cast<std::uint32_t>(vertex));
+		if(degree)
+		{
+			const std::uint32_t *first = neighbours(static_cast<std::uint32_t>(vertex));
+			width = std::max<std::size_t>(width, vertex > first[0] ? vertex - first[0] : first[0] - vertex);
+			width = std::max<std::size_t>(width, vertex > first[degree - 1] ? vertex - first[degree - 1] : first[degree - 1] - vertex);
+		}
+	}
+	return width;
+}
+
+Graph Graph::load(const std::string &fileName)
+{
+	std::ifstream input(fileName);
+	if(!input)
+	{
+		throw std::runtime_error("cannot open edge list " + fileName);
+	}
+
+	std::vector<Edge> edges;
+	std::uint64_t vertexCount = 0;
+	std::string line;
+	std::size_t lineNumber = 0;
+	while(std::getline(input, line))
+	{
+		++lineNumber;
+		std::istringstream fields(line);
+		std::string first;
+		if(!(fields >> first) || first[0] == '#')
+		{
+			continue;
+		}
+
+		std::istringstream firstField(first);
+		std::uint64_t a;
+		std::uint64_t b;
+		if(!(firstField >> a) || !(fields >> b) || a >= std::numeric_limits<std::uint32_t>::max() || b >= std::numeric_limits<std::uint32_t>::max())
+		{
+			throw std::runtime_error("bad edge on line " + std::to_string(lineNumber) + " of " + fileName);
+		}
+		edges.emplace_back(static_cast<std::uint32_t>(a), static_cast<std::uint32_t>(b));
+		vertexCount = std::max(vertexCount, std::max(a, b) + 1);
+	}
+
+	return Graph(vertexCount, edges);
+}
+
+Graph Graph::randomRegular(std::size_t vertexCount, int degree, RandomEngine &generator)
+{
+	checkVertexCount(vertexCount);
+	if(degree < 0 || static_cast<std::size_t>(degree) >= vertexCount || (vertexCount * degree) % 2)
+	{
+		throw std::runtime_error("a random regular graph needs a degree below the number of vertices and an even number of stubs");
+	}
+
+	std::vector<Edge> edges;
+	std::unordered_set<std::uint64_t> made;
+	std::vector<std::uint32_t> stubs;
+	for(int attempt = 0; attempt < maxPairings; ++attempt)
+	{
+		edges.clear();
+		made.clear();
+		stubs.clear();
+		for(std::size_t vertex = 0; vertex < vertexCount; ++vertex)
+		{
+			stubs.insert(stubs.end(), degree, static_cast<std::uint32_t>(vertex));
+		}
+
+		// Pair random stubs, giving up on a pairing once a long run of draws finds nothing usable.
+		int failures = 0;
+		while(!stubs.empty() && failures < 1000)
+		{
+			std::uint64_t word = generator();
+			std::size_t i = takeBounded(word, stubs.size());
+			std::size_t j = takeBounded(word, stubs.size());
+			std::uint32_t a = stubs[i];
+			std::uint32_t b = stubs[j];
+			if(a == b || made.count(edgeKey(a, b)))
+			{
+				++failures;
+				continue;
+			}
+
+			failures = 0;
+			made.insert(edgeKey(a, b));
+			edges.emplace_back(a, b);
+
+			// Remove the larger index first so the smaller one is still in place.
+			std::swap(stubs[std::max(i, j)], stubs.back());
+			stubs.pop_back();
+			std::swap(stubs[std::min(i, j)], stubs.back());
+			stubs.pop_back();
+		}
+
+		if(stubs.empty())
+		{
+			return Graph(vertexCount, edges);
+		}
+	}
+
+	throw std::runtime_error("could not pair the stubs of a random regular graph, try a lower degree");
+}
+
+Graph Graph::smallWorld(std::size_t vertexCount, int degree, double rewiring, RandomEngine &generator)
+{
+	checkVertexCount(vertexCount);
+	if(degree < 2 || degree % 2 || static_cast<std::size_t>(degree) >= vertexCount || rewiring < 0 || rewiring > 1)
+	{
+		throw std::runtime_error("a small world needs an even degree of at least 2 below the number of vertices and a rewiring probability in [0,1]");
+	}
+
+	std::vector<Edge> edges;
+	std::unordered_set<std::uint64_t> made;
+	for(std::size_t vertex = 0; vertex < vertexCount; ++vertex)
+	{
+		for(int step = 1; step <= degree / 2; ++step)
+		{
+			std::uint32_t a = static_cast<std::uint32_t>(vertex);
+			std::uint32_t b = static_cast<std::uint32_t>((vertex + step) % vertexCount);
+			edges.emplace_back(a, b);
+			made.insert(edgeKey(a, b));
+		}
+	}
+
+	// Rewire ring by ring as in the original construction, the near end staying put.
+	for(int step = 1; step <= degree / 2; ++step)
+	{
+		for(std::size_t vertex = 0; vertex < vertexCount; ++vertex)
+		{
+			Edge &edge = edges[vertex * (degree / 2) + step - 1];
+			if(generator.uniform() >= rewiring)
+			{
+				continue;
+			}
+
+			// Draw new far ends until one is free, keeping the edge if none turns up, as for a vertex joined to nearly everything.
+			std::uint32_t a = edge.first;
+			std::uint32_t b;
+			int attempts = 0;
+			do
+			{
+				std::uint64_t word = generator();
+				b = static_cast<std::uint32_t>(takeBounded(word, vertexCount));
+			}
+			while((b == a || made.count(edgeKey(a, b))) && ++attempts < 100);
+
+			if(b != a && !made.count(edgeKey(a, b)))
+			{
+				made.erase(edgeKey(edge.first, edge.second));
+				made.insert(edgeKey(a, b));
+				edge.second = b;
+			}
+		}
+	}
+
+	return Graph(vertexCount, edges);
+}
+
+Graph Graph::scaleFree(std::size_t vertexCount, int links, RandomEngine &generator)
+{
+	checkVertexCount(vertexCount);
+	if(links < 1 || static_cast<std::size_t>(links) >= vertexCount)
+	{
+		throw std::runtime_error("a scale free network needs at least one link per vertex and more vertices than links");
+	}
+
+	// Every edge puts both its ends in the list, so a uniform pick from it is proportional to degree.
+	std::vector<Edge> edges;
+	std::vector<std::uint32_t> ends;
+	for(int a = 0; a <= links; ++a)
+	{
+		for(int b = a + 1; b <= links; ++b)
+		{
+			edges.emplace_back(a, b);
+			ends.push_back(a);
+			ends.push_back(b);
+		}
+	}
+
+	std::vector<std::uint32_t> targets;
+	for(std::size_t vertex = links + 1; vertex < vertexCount; ++vertex)
+	{
+		targets.clear();
+		while(targets.size() < static_cast<std::size_t>(links))
+		{
+			std::uint64_t word = generator();
+			std::uint32_t target = ends[takeBounded(word, ends.size())];
+			if(std::find(targets.begin(), targets.end(), target) == targets.end())
+			{
+				targets.push_back(target);
+			}
+		}
+
+		for(auto target : targets)
+		{
+			edges.emplace_back(static_cast<std::uint32_t>(vertex), target);
+			ends.push_back(static_cast<std::uint32_t>(vertex));
+			ends.push_back(target);
+		}
+	}
+
+	return Graph(vertexCount, edges);
+}
+
+Graph Graph::cubic(std::size_t length)
+{
+	if(length < 3 || length > 1625)
+	{
+		throw std::runtime_error("a cubic lattice needs between 3 and 1625 sites along each side");
+	}
+
+	std::vector<Edge> edges;
+	edges.reserve(3 * length * length * length);
+	for(std::size_t z = 0; z < length; ++z)
+	{
+		for(std::size_t y = 0; y < length; ++y)
+		{
+			for(std::size_t x = 0; x < length; ++x)
+			{
+				// Join each site to the next one along every axis, which covers every edge once.
+				std::uint32_t site = static_cast<std::uint32_t>(x + length * (y + length * z));
+				edges.emplace_back(site, static_cast<std::uint32_t>((x + 1) % length + length * (y + length * z)));
+				edges.emplace_back(site, static_cast<std::uint32_t>(x + length * ((y + 1) % length + length * z)));
+				edges.emplace_back(site, static_cast<std::uint32_t>(x + length * (y + length * ((z + 1) % length))));
+			}
+		}
+	}
+
+	return Graph(length * length * length, edges);
+}
+
+Graph Graph::make(const std::string &description, RandomEngine &generator)
+{
+	std::size_t colon = description.find(':');
+	std::string kind = description.substr(0, colon);
+	std::string rest = colon == std::string::npos ? "" : description.substr(colon + 1);
+
+	if(kind == "file")
+	{
+		return load(rest);
+	}
+
+	std::istringstream numbers(rest);
+	std::vector<double> values;
+	std::string field;
+	while(std::getline(numbers, field, ':'))
+	{
+		std::istringstream value(field);
+		double number;
+		if(!(value >> number) || !(value >> std::ws).eof())
+		{
+			throw std::runtime_error("bad number " + field + " in graph " + description);
+		}
+		values.push_back(number);
+	}
+
+	if(kind == "regular" && values.size() == 2)
+	{
+		return randomRegular(static_cast<std::size_t>(values[0]), static_cast<int>(values[1]), generator);
+	}
+	if(kind == "small-world" && values.size() == 3)
+	{
+		return smallWorld(static_cast<std::size_t>(values[0]), static_cast<int>(values[1]), values[2], generator);
+	}
+	if(kind == "scale-free" && values.size() == 2)
+	{
+		return scaleFree(static_cast<std::size_t>(values[0]), static_cast<int>(values[1]), generator);
+	}
+	if(kind == "cubic" && values.size() == 1)
+	{
+		return cubic(static_cast<std::size_t>(values[0]));
+	}
+
+	throw std::runtime_error("unknown graph " + description + ", use regular:N:k, small-world:N:k:p, scale-free:N:m, cubic:L or file:name");
+}
+
+std::ostream& operator<<(std::ostream& out, Graph::Ordering ordering)
+{
+	switch(ordering)
+	{
+		case Graph::NoOrdering:
+			return out << "none";
+		case Graph::BfsOrdering:
+			return out << "bfs";
+		case Graph::RcmOrdering:
+			return out << "rcm";
+	}
+	return out;
+}
+
+std::istream& operator>>(std::istream& in, Graph::Ordering &ordering)
+{
+	std::string name;
+	in >> name;
+
+	if(name == "none")
+	{
+		ordering = Graph::NoOrdering;
+	}
+	else if(name == "bfs")
+	{
+		ordering = Graph::BfsOrdering;
+	}
+	else if(name == "rcm")
+	{
+		ordering = Graph::RcmOrdering;
+	}
+	else
+	{
+		in.setstate(std::ios::failbit);
+	}
+
+	return in;
+}
@@ -0,0 +1,230 @@
+#ifndef Graph_hpp
+#define Graph_hpp
+
+#include <vector>
+#include <string>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+#include <iostream>
+#include "RandomEngine.hpp"
+
+/**
+ *\file
+ *\class Graph
+ *\brief Undirected graph stored as compressed sparse row (CSR) adjacency arrays.
+ *
+ * The neighbours of vertex v are m_neighbour[m_offset[v]] to m_neighbour[m_offset[v+1]-1], in
+ * increasing order, so reading them is one contiguous run of memory. Self loops and repeated edges are
+ * dropped when the graph is built. Graphs come from an edge list or from one of the generators, and
+ * can be relabelled with reorder() so that neighbouring vertices get nearby labels; the label a vertex
+ * had when it was built is kept for output.
+ */
+class Graph
+{
+public:
+	/**
+	 * \enum Ordering
+	 * \brief How reorder() labels the vertices.
+	 *
+	 * NoOrdering keeps the labels, BfsOrdering numbers the vertices in breadth first order from the
+	 * lowest degree vertex of each component and RcmOrdering is the reverse Cuthill-McKee order, breadth
+	 * first with the neighbours taken in increasing degree and the result reversed, which keeps the
+	 * bandwidth of the adjacency matrix small.
+	 */
+	enum Ordering
+	{
+		NoOrdering,
+		BfsOrdering,
+		RcmOrdering,
+	};
+
+	/// An undirected edge between two vertices.
+	typedef std::pair<std::uint32_t, std::uint32_t> Edge;
+
+private:
+	/// Start of the neighbours of each vertex plus a final entry holding the number of entries.
+	std::vector<std::size_t> m_offset;
+
+	/// Neighbours of every vertex one after the other, each edge appearing once for either end.
+	std::vector<std::uint32_t> m_neighbour;
+
+	/// Label each vertex had when the graph was built.
+	std::vector<std::uint32_t> m_label;
+
+	/**
+	 *\brief Breadth first order of the vertices, one component after the other.
+	 *\param byDegree true to take the neighbours of each vertex in increasing degree.
+	 *\return the vertices in the order they are reached.
+	 */
+	std::vector<std::uint32_t> breadthFirstOrder(bool byDegree) const;
+
+public:
+	/**
+	 *\brief Constructor for a graph with no vertices.
+	 */
+	Graph() = default;
+
+	/**
+	 *\brief Constructor that builds the CSR arrays from an edge list.
+	 *\param vertexCount number of vertices, every edge must be between vertices below it.
+	 *\param edges the edges, in either direction, self loops and repeats are dropped.
+	 */
+	Graph(std::size_t vertexCount, const std::vector<Edge> &edges);
+
+	/**
+	 *\brief Getter for the number of vertices.
+	 *\return the number of vertices.
+	 */
+	std::size_t getVertexCount() const;
+
+	/**
+	 *\brief Getter for the number of edges.
+	 *\return the number of undirected edges.
+	 */
+	std::size_t getEdgeCount() const;
+
+	/**
+	 *\brief Getter for the degree of a vertex.
+	 *\param vertex the vertex.
+	 *\return the number of neighbours.
+	 */
+	std::size_t getDegree(std::uint32_t vertex) const
+	{
+		return m_offset[vertex + 1] - m_offset[vertex];
+	}
+
+	/**
+	 *\brief Getter for the neighbours of a vertex.
+	 *\param vertex the vertex.
+	 *\return pointer to the first of getDegree(vertex) neighbours.
+	 */
+	const std::uint32_t* neighbours(std::uint32_t vertex) const
+	{
+		return m_neighbour.data() + m_offset[vertex];
+	}
+
+	/**
+	 *\brief Starts loading where the neighbours of a vertex are into the cache.
+	 *\param vertex the vertex.
+	 */
+	void prefetchOffset(std::uint32_t vertex) const
+	{
+		__builtin_prefetch(m_offset.data() + vertex);
+	}
+
+	/**
+	 *\brief Getter for the label a vertex had when the graph was built.
+	 *\param vertex the current label of the vertex.
+	 *\return the original label.
+	 */
+	std::uint32_t getLabel(std::uint32_t vertex) const;
+
+	/**
+	 *\brief Relabels the vertices.
+	 *\param ordering how to label the vertices.
+	 */
+	void reorder(Ordering ordering);
+
+	/**
+	 *\brief Getter for the bandwidth, the largest label difference across an edge.
+	 *\return the bandwidth of the adjacency matrix.
+	 */
+	std::size_t bandwidth() const;
+
+	/**
+	 *\brief Reads an edge list, two vertex labels per line, starting from 0.
+	 *
+	 * Blank lines and lines starting with # are skipped, and the number of vertices is one more than
+	 * the largest label.
+	 *
+	 *\param fileName name of the file.
+	 *\return the graph.
+	 *\throws std::runtime_error if the file cannot be read.
+	 */
+	static Graph load(const std::string &fileName);
+
+	/**
+	 *\brief Generates a random regular graph.
+	 *
+	 * Pairs up the degree stubs of the vertices at random, rejecting pairs that would make a self loop
+	 * or a repeated edge, and starts again in the rare case the last stubs cannot be paired. For a degree
+	 * close to the number of vertices nearly every pairing gets stuck, so it gives up after a fixed number.
+	 *
+	 *\param vertexCount number of vertices.
+	 *\param degree degree of every vertex, vertexCount*degree must be even.
+	 *\param generator RandomEngine reference for the pairing.
+	 *\return the graph.
+	 *\throws std::runtime_error for impossible parameters or when no pairing succeeds.
+	 */
+	static Graph randomRegular(std::size_t vertexCount, int degree, RandomEngine &generator);
+
+	/**
+	 *\brief Generates a Watts-Strogatz small world.
+	 *
+	 * Starts from a ring with every vertex joined to its degree/2 nearest vertices either side and moves
+	 * the far end of each edge to a random vertex with the rewiring probability, avoiding self loops and
+	 * repeated edges.
+	 *
+	 *\param vertexCount number of vertices.
+	 *\param degree even degree of the ring.
+	 *\param rewiring probability of rewiring each edge.
+	 *\param generator RandomEngine reference for the rewiring.
+	 *\return the graph.
+	 *\throws std::runtime_error for impossible parameters.
+	 */
+	static Graph smallWorld(std::size_t vertexCount, int degree, double rewiring, RandomEngine &generator);
+
+	/**
+	 *\brief Generates a Barabasi-Albert scale free network.
+	 *
+	 * Starts from a complete graph on links+1 vertices, every further vertex joining links distinct
+	 * vertices chosen with probability proportional to their degree.
+	 *
+	 *\param vertexCount number of vertices.
+	 *\param links number of edges each new vertex brings.
+	 *\param generator RandomEngine reference for the attachment.
+	 *\return the graph.
+	 *\throws std::runtime_error for impossible parameters.
+	 */
+	static Graph scaleFree(std::size_t vertexCount, int links, RandomEngine &generator);
+
+	/**
+	 *\brief Generates a periodic simple cubic lattice, vertex x + L*(y + L*z) being site (x,y,z).
+	 *\param length number of sites along each side, at least 3.
+	 *\return the graph.
+	 *\throws std::runtime_error for impossible parameters.
+	 */
+	static Graph cubic(std::size_t length);
+
+	/**
+	 *\brief Builds a graph from a description.
+	 *
+	 * The description is one of regular:N:k, small-world:N:k:p, scale-free:N:m, cubic:L or file:name,
+	 * see the generators for the meaning of the numbers.
+	 *
+	 *\param description the description.
+	 *\param generator RandomEngine reference for the random generators.
+	 *\return the graph.
+	 *\throws std::runtime_error for a bad description.
+	 */
+	static Graph make(const std::string &description, RandomEngine &generator);
+};
+
+/**
+ *\brief streams the name of an ordering, none, bfs or rcm.
+ *\param out std::ostream reference that is being streamed to.
+ *\param ordering the ordering to print.
+ *\return std::ostream reference to output can be chained.
+ */
+std::ostream& operator<<(std::ostream& out, Graph::Ordering ordering);
+
+/**
+ *\brief reads the name of an ordering, none, bfs or rcm, setting the failbit for any other name.
+ *\param in std::istream reference that is being read from.
+ *\param ordering the ordering that is read.
+ *\return std::istream reference so input can be chained.
+ */
+std::istream& operator>>(std::istream& in, Graph::Ordering &ordering);
+
+#endif /* Graph_hpp */
@@ -0,0 +1,75 @@
+#include "Instrumentation.hpp"
+#include <iomanip>
+
+Instrumentation::Instrumentation(long long firstSweep, long long totalSweeps, double interval) :
+	m_seconds(),
+	m_firstSweep(firstSweep),
+	m_totalSweeps(totalSweeps),
+	m_reportedSweeps(firstSweep),
+	m_interval(interval),
+	m_sweepsDone(firstSweep)
+{
+
+}
+
+void Instrumentation::report(std::ostream &out)
+{
+	// The recent rate shows slow downs, the average over the run gives the steadier estimate of the time left.
+	double recent = (m_sweepsDone - m_reportedSweeps) / m_sinceReport.elapsed();
+	double elapsed = m_total.elapsed();
+	double average = elapsed > 0 ? (m_sweepsDone - m_firstSweep) / elapsed : 0;
+	double remaining = average > 0 ? (m_totalSweeps - m_sweepsDone) / average : 0;
+
+	std::streamsize precision = out.precision();
+	out << "Sweep " << m_sweepsDone << '/' << m_totalSweeps << std::fixed << std::setprecision(1)
+	    << "  " << recent << " sweeps/s  elapsed " << elapsed << " s  ETA " << remaining << " s" << std::defaultfloat << std::setprecision(precision) << '\n';
+
+	m_reportedSweeps = m_sweepsDone;
+	m_sinceReport.reset();
+}
+
+void Instrumentation::setCounters(const UpdateCounters &counters)
+{
+	m_counters = counters;
+}
+
+double Instrumentation::getSeconds(Phase phase) const
+{
+	return m_seconds[phase];
+}
+
+std::ostream& operator<<(std::ostream &out, const Instrumentation &instrumentation)
+{
+	int outputColumnWidth = 30;
+	double elapsed = instrumentation.m_total.elapsed();
+	long long sweeps = instrumentation.m_sweepsDone - instrumentation.m_firstSweep;
+
+	out << "Instrumentation..." << '\n';
+	out << std::setw(outputColumnWidth) << std::setfill(' ') << std::left << "Sweeps: " <<
+	std::right << sweeps << '\n';
+	out << std::setw(outputColumnWidth) << std::setfill(' ') << std::left << "Sweeps-Per-Second: " <<
+	std::right << (elapsed > 0 ? sweeps / elapsed : 0) << '\n';
+	if(!instrumented)
+	{
+		return out;
+	}
+
+	static const char *names[Instrumentation::PhaseCount] = {"Update-Time(s): ", "Observable-Time(s): ", "Output-Time(s): "};
+	for(int phase = 0; phase < Instrumentation::PhaseCount; ++phase)
+	{
+		double seconds = instrumentation.m_seconds[phase];
+		out << std::setw(outputColumnWidth) << std::setfill(' ') << std::left << names[phase] <<
+		std::right << seconds << " (" << (elapsed > 0 ? 100 * seconds / elapsed : 0) << "%)" << '\n';
+	}
+
+	const UpdateCounters &counters = instrumentation.m_counters;
+	out << std::setw(outputColumnWidth) << std::setfill(' ') << std::left << "Attempted-Updates: " <<
+	std::right << counters.attempts << '\n';
+	out << std::setw(outputColumnWidth) << std::setfill(' ') << std::left << "Flips: " <<
+	std::right << counters.flips << " (" << (counters.attempts ? static_cast<double>(counters.flips) / counters.attempts : 0) << " per attempt)" << '\n';
+	out << std::setw(outputColumnWidth) << std::setfill(' ') << std::left << "Stubborn-Hits: " <<
+	std::right << counters.stubbornHits << '\n';
+	out << std::setw(outputColumnWidth) << std::setfill(' ') << std::left << "Updates-Per-Second: " <<
+	std::right << (instrumentation.m_seconds[Instrumentation::Updates] > 0 ? counters.attempts / instrumentation.m_seconds[Instrumentation::Updates] : 0) << '\n';
+	return out;
+}
@@ -0,0 +1,176 @@
+#ifndef Instrumentation_hpp
+#define Instrumentation_hpp
+#include "Timer.hpp"
+#include <iostream>
+
+/**
+ *\file
+ *\brief Counters and phase timers for the hot paths of a simulation.
+ *
+ * The counters and phase timers are compiled in with -DVOTER_INSTRUMENTATION, without it the counting
+ * branches are constant false and the scoped timers are empty, so they cost nothing. The progress lines
+ * only need a clock read per sweep and are always available.
+ */
+
+#ifdef VOTER_INSTRUMENTATION
+/// Whether the update counters and phase timers are compiled in.
+constexpr bool instrumented = true;
+#else
+/// Whether the update counters and phase timers are compiled in.
+constexpr bool instrumented = false;
+#endif
+
+/**
+ *\struct UpdateCounters
+ *\brief Counts of what the site updates did.
+ */
+struct UpdateCounters
+{
+	/// Updates attempted, including those that picked a stubborn voter.
+	unsigned long long attempts = 0;
+	/// Updates that changed an opinion.
+	unsigned long long flips = 0;
+	/// Updates that picked a stubborn voter and so did nothing.
+	unsigned long long stubbornHits = 0;
+
+	/**
+	 *\brief Adds another set of counts to these.
+	 *\param other counts to add.
+	 *\return reference to these counts.
+	 */
+	UpdateCounters& operator+=(const UpdateCounters &other)
+	{
+		attempts += other.attempts;
+		flips += other.flips;
+		stubbornHits += other.stubbornHits;
+		return *this;
+	}
+};
+
+/**
+ *\class Instrumentation
+ *\brief Time spent in each phase of the main loop, the update counts and the progress of a run.
+ */
+class Instrumentation
+{
+public:
+	/**
+	 *\enum Phase
+	 *\brief The parts of a sweep that are timed separately.
+	 */
+	enum Phase
+	{
+		Updates,
+		Observables,
+		Output,
+		PhaseCount
+	};
+
+	/**
+	 *\class Scope
+	 *\brief Adds the time until it goes out of scope to a phase.
+	 */
+	class Scope
+	{
+#ifdef VOTER_INSTRUMENTATION
+	private:
+		/// Where the time is added.
+		Instrumentation &m_owner;
+		/// Phase the time is added to.
+		Phase m_phase;
+		/// Started when the scope is entered.
+		Timer m_timer;
+	public:
+		Scope(Instrumentation &owner, Phase phase) : m_owner(owner), m_phase(phase) {}
+		~Scope() { m_owner.m_seconds[m_phase] += m_timer.elapsed(); }
+#else
+	public:
+		Scope(Instrumentation &, Phase) {}
+#endif
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+	};
+
+private:
+	/// Seconds spent in each phase.
+	double m_seconds[PhaseCount];
+
+	/// Counts of the site updates.
+	UpdateCounters m_counters;
+
+	/// Started with the run.
+	Timer m_total;
+
+	/// Started at the last progress line.
+	Timer m_sinceReport;
+
+	/// Sweep the run started from, non-zero when resuming.
+	long long m_firstSweep;
+
+	/// Sweep the run ends at.
+	long long m_totalSweeps;
+
+	/// Sweeps done at the last progress line.
+	long long m_reportedSweeps;
+
+	/// Seconds between progress lines, 0 for none.
+	double m_interval;
+
+	/// Sweeps done by the end of the run, for the throughput.
+	long long m_sweepsDone;
+
+public:
+	/**
+	 *\brief Constructor that starts the clocks.
+	 *\param firstSweep sweep the run starts from.
+	 *\param totalSweeps sweep the run ends at.
+	 *\param interval seconds between progress lines, 0 for none.
+	 */
+	Instrumentation(long long firstSweep, long long totalSweeps, double interval);
+
+	/**
+	 *\brief Prints a line with the sweep rate and the estimated time left if the interval has passed.
+	 *\param sweepsDone sweeps done so far, counted from 0 rather than from the first sweep.
+	 *\param out stream to print to.
+	 */
+	void progress(long long sweepsDone, std::ostream &out)
+	{
+		m_sweepsDone = sweepsDone;
+		if(m_interval > 0 && m_sinceReport.elapsed() >= m_interval)
+		{
+			report(out);
+		}
+	}
+
+	/**
+	 *\brief Prints a progress line.
+	 *\param out stream to print to.
+	 */
+	void report(std::ostream &out);
+
+	/**
+	 *\brief Setter for the update counts, taken from the lattice at the end of the run.
+	 *\param counters counts of the site updates.
+	 */
+	void setCounters(const UpdateCounters &counters);
+
+	/**
+	 *\brief Getter for the time spent in a phase.
+	 *\param phase the phase.
+	 *\return time in seconds, 0 without -DVOTER_INSTRUMENTATION.
+	 */
+	double getSeconds(Phase phase) const;
+
+	/**
+	 *\brief operator<< overload for outputting the totals.
+	 *\param out std::ostream reference that is the stream being outputted to.
+	 *\param instrumentation constant Instrumentation instance to be output.
+	 *\return std::ostream reference so the operator can be chained.
+	 *
+	 * The throughput is always output, the phase times and update counts only when compiled in, in the
+	 * same table format as VoterResults.
+	 */
+	friend std::ostream& operator<<(std::ostream &out, const Instrumentation &instrumentation);
+};
+
+#endif /* Instrumentation_hpp */
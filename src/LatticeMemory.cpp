@@ -0,0 +1,281 @@
+#include "LatticeMemory.hpp"
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <cstdint>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <stdlib.h>
+
+LatticeMemory::Mode LatticeMemory::s_mode = LatticeMemory::Transparent;
+std::string LatticeMemory::s_directory = ".";
+int LatticeMemory::s_threadCount = 1;
+
+namespace
+{
+	/// Size of a huge page, the smallest plane that is mapped.
+	const std::size_t hugePage = std::size_t(1) << 21;
+
+	/// Smallest plane whose first write is split over the threads.
+	const std::size_t parallelFillBytes = std::size_t(1) << 26;
+
+	/**
+	 *\brief Rounds a size up to whole huge pages.
+	 */
+	std::size_t roundUp(std::size_t bytes)
+	{
+		return (bytes + hugePage - 1) & ~(hugePage - 1);
+	}
+
+	/**
+	 *\brief Guards mappings().
+	 */
+	std::mutex& mappingMutex()
+	{
+		static std::mutex mutex;
+		return mutex;
+	}
+
+	/**
+	 *\brief Length of every live mapping by its address, the planes that deallocate() must unmap.
+	 */
+	std::map<void*, std::size_t>& mappings()
+	{
+		static std::map<void*, std::size_t> lengths;
+		return lengths;
+	}
+
+	/**
+	 *\brief Whether a plane of this size is mapped rather than taken from the heap.
+	 */
+	bool isMapped(std::size_t bytes)
+	{
+		return LatticeMemory::getMode() != LatticeMemory::Heap && bytes >= hugePage;
+	}
+
+	/**
+	 *\brief Maps anonymous memory starting on a huge page and asks for transparent huge pages.
+	 *\return the memory or nullptr.
+	 */
+	void* mapTransparent(std::size_t length)
+	{
+		// Transparent huge pages need aligned memory, so map a huge page more than needed and trim both ends.
+		void *memory = mmap(nullptr, length + hugePage, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+		if(memory == MAP_FAILED)
+		{
+			return nullptr;
+		}
+
+		std::uintptr_t begin = reinterpret_cast<std::uintptr_t>(memory);
+		std::uintptr_t aligned = (begin + hugePage - 1) & ~static_cast<std::uintptr_t>(hugePage - 1);
+		if(aligned > begin)
+		{
+			munmap(memory, aligned - begin);
+		}
+		if(begin + hugePage > aligned)
+		{
+			munmap(reinterpret_cast<void*>(aligned + length), begin + hugePage - aligned);
+		}
+
+#ifdef MADV_HUGEPAGE
+		madvise(reinterpret_cast<void*>(aligned), length, MADV_HUGEPAGE);
+#endif
+		return reinterpret_cast<void*>(aligned);
+	}
+
+	/**
+	 *\brief Maps memory from the reserved pool of huge pages, or transparent huge pages if it is short.
+	 *\return the memory or nullptr.
+	 */
+	void* mapExplicit(std::size_t length)
+	{
+#ifdef MAP_HUGETLB
+		void *memory = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		if(memory != MAP_FAILED)
+		{
+			return memory;
+		}
+#endif
+
+		static bool warned = false;
+		if(!warned)
+		{
+			std::cerr << "not enough explicit huge pages reserved, using transparent huge pages\n";
+			warned = true;
+		}
+		return mapTransparent(length);
+	}
+
+	/**
+	 *\brief Maps a new unlinked file in a directory, which goes away with the mapping.
+	 *\return the memory or nullptr.
+	 */
+	void* mapFile(const std::string &directory, std::size_t length)
+	{
+		std::string pattern = directory + "/LatticeXXXXXX";
+		std::vector<char> name(pattern.begin(), pattern.end());
+		name.push_back('\0');
+
+		int file = mkstemp(name.data());
+		if(file < 0)
+		{
+			return nullptr;
+		}
+		unlink(name.data());
+
+		void *memory = MAP_FAILED;
+		if(ftruncate(file, static_cast<off_t>(length)) == 0)
+		{
+			memory = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+		}
+		close(file);
+		return memory == MAP_FAILED ? nullptr : memory;
+	}
+}
+
+void LatticeMemory::configure(Mode mode, const std::string &directory, int threadCount)
+{
+	s_mode = mode;
+	s_directory = directory;
+	s_threadCount = threadCount;
+}
+
+LatticeMemory::Mode LatticeMemory::getMode()
+{
+	return s_mode;
+}
+
+void* LatticeMemory::allocate(std::size_t bytes)
+{
+	if(!isMapped(bytes))
+	{
+		return ::operator new(bytes);
+	}
+
+	std::size_t length = roundUp(bytes);
+	void *memory = nullptr;
+	switch(s_mode)
+	{
+		case LatticeMemory::Explicit:
+			memory = mapExplicit(length);
+			break;
+		case LatticeMemory::File:
+			memory = mapFile(s_directory, length);
+			break;
+		default:
+			memory = mapTransparent(length);
+			break;
+	}
+
+	if(!memory)
+	{
+		throw std::bad_alloc();
+	}
+
+	try
+	{
+		std::lock_guard<std::mutex> lock(mappingMutex());
+		mappings()[memory] = length;
+	}
+	catch(...)
+	{
+		munmap(memory, length);
+		throw;
+	}
+	return memory;
+}
+
+void LatticeMemory::deallocate(void *pointer, std::size_t) noexcept
+{
+	std::size_t length = 0;
+	{
+		std::lock_guard<std::mutex> lock(mappingMutex());
+		auto mapping = mappings().find(pointer);
+		if(mapping != mappings().end())
+		{
+			length = mapping->second;
+			mappings().erase(mapping);
+		}
+	}
+
+	if(length)
+	{
+		munmap(pointer, length);
+	}
+	else
+	{
+		::operator delete(pointer);
+	}
+}
+
+void LatticeMemory::fill(std::uint64_t *words, std::size_t count, std::uint64_t value)
+{
+	std::size_t threadCount = s_threadCount > 1 && count * sizeof(std::uint64_t) >= parallelFillBytes && !ThreadPool::inWorker() ? s_threadCount : 1;
+	if(threadCount == 1)
+	{
+		std::fill(words, words + count, value);
+		return;
+	}
+
+	// One contiguous chunk of whole huge pages per thread, in order like the strips of a parallel sweep.
+	std::size_t pageWords = hugePage / sizeof(std::uint64_t);
+	std::size_t chunk = ((count + threadCount - 1) / threadCount + pageWords - 1) / pageWords * pageWords;
+	std::vector<std::thread> threads;
+	for(std::size_t begin = 0; begin < count; begin += chunk)
+	{
+		std::size_t end = std::min(count, begin + chunk);
+		threads.emplace_back([=]{ std::fill(words + begin, words + end, value); });
+	}
+	for(auto &thread : threads)
+	{
+		thread.join();
+	}
+}
+
+std::ostream& operator<<(std::ostream& out, LatticeMemory::Mode mode)
+{
+	switch(mode)
+	{
+		case LatticeMemory::Heap:
+			return out << "heap";
+		case LatticeMemory::Transparent:
+			return out << "transparent";
+		case LatticeMemory::Explicit:
+			return out << "explicit";
+		case LatticeMemory::File:
+			return out << "file";
+	}
+	return out;
+}
+
+std::istream& operator>>(std::istream& in, LatticeMemory::Mode &mode)
+{
+	std::string name;
+	in >> name;
+
+	if(name == "heap")
+	{
+		mode = LatticeMemory::Heap;
+	}
+	else if(name == "transparent")
+	{
+		mode = LatticeMemory::Transparent;
+	}
+	else if(name == "explicit")
+	{
+		mode = LatticeMemory::Explicit;
+	}
+	else if(name == "file")
+	{
+		mode = LatticeMemory::File;
+	}
+	else
+	{
+		in.setstate(std::ios::failbit);
+	}
+
+	return in;
+}
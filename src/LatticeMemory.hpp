@@ -0,0 +1,164 @@
+#ifndef LatticeMemory_hpp
+#define LatticeMemory_hpp
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <iostream>
+#include <utility>
+#include <new>
+
+/**
+ *\file
+ *\class LatticeMemory
+ *\brief Memory for the bitplanes of very large lattices.
+ *
+ * Once a lattice is far larger than the caches nearly every random update misses the TLB as well, each
+ * 4 kB page needing an entry of its own. Planes of at least a huge page are therefore mapped directly and
+ * backed by 2 MB pages: Transparent asks for transparent huge pages with madvise(), Explicit takes them
+ * from the pool reserved in /proc/sys/vm/nr_hugepages and falls back to transparent ones if the pool is
+ * short. File maps the planes from unlinked files in a directory instead, for lattices larger than
+ * memory, leaving the paging to the kernel. Heap keeps every plane on the heap. Smaller planes always
+ * come from the heap.
+ *
+ * A mapped page only gets physical memory when it is first written, on the NUMA node of the thread that
+ * writes it. fill() splits that first write over the threads in contiguous chunks, the same way a
+ * parallel sweep splits the lattice into strips of rows, so each thread's strip is mostly local to it.
+ * Inside a ThreadPool task, where the other cores are busy with lattices of their own, it writes alone.
+ *
+ * The mode is global and should be set before the first lattice is made. Each mapping is recorded with
+ * its length, so a plane is given back the way it was allocated whatever the mode is by then.
+ */
+class LatticeMemory
+{
+public:
+	/**
+	 * \enum Mode
+	 * \brief Where the large planes are put.
+	 */
+	enum Mode
+	{
+		Heap,
+		Transparent,
+		Explicit,
+		File,
+	};
+
+private:
+	/// Where the large planes are put.
+	static Mode s_mode;
+
+	/// Directory of the backing files in the File mode.
+	static std::string s_directory;
+
+	/// Number of threads that share the first write of a large plane.
+	static int s_threadCount;
+
+public:
+	/**
+	 *\brief Sets where the large planes are put and how many threads first write them.
+	 *\param mode where the large planes are put.
+	 *\param directory directory of the backing files, only used in the File mode.
+	 *\param threadCount number of threads that share the first write of a large plane.
+	 */
+	static void configure(Mode mode, const std::string &directory, int threadCount);
+
+	/**
+	 *\brief Getter for the mode.
+	 *\return where the large planes are put.
+	 */
+	static Mode getMode();
+
+	/**
+	 *\brief Allocates memory for a plane, mapping it if it is large.
+	 *\param bytes size of the plane.
+	 *\return the memory, aligned to a huge page if it was mapped.
+	 */
+	static void* allocate(std::size_t bytes);
+
+	/**
+	 *\brief Gives back memory from allocate().
+	 *\param pointer the memory.
+	 *\param bytes the size it was allocated with, a mapping is unmapped with the length recorded for it.
+	 */
+	static void deallocate(void *pointer, std::size_t bytes) noexcept;
+
+	/**
+	 *\brief Writes a value to every word of a plane, split over the threads if it is large.
+	 *\param words first word of the plane.
+	 *\param count number of words.
+	 *\param value value to write.
+	 */
+	static void fill(std::uint64_t *words, std::size_t count, std::uint64_t value);
+};
+
+/**
+ *\class LatticeAllocator
+ *\brief Standard allocator drawing on LatticeMemory.
+ *
+ * Elements made without a value are left unwritten, so that resizing a plane does not touch its pages
+ * and LatticeMemory::fill() can make the first write.
+ */
+template<class T>
+class LatticeAllocator
+{
+public:
+	typedef T value_type;
+
+	LatticeAllocator() = default;
+
+	template<class U>
+	LatticeAllocator(const LatticeAllocator<U>&) {}
+
+	T* allocate(std::size_t count)
+	{
+		return static_cast<T*>(LatticeMemory::allocate(count * sizeof(T)));
+	}
+
+	void deallocate(T *pointer, std::size_t count) noexcept
+	{
+		LatticeMemory::deallocate(pointer, count * sizeof(T));
+	}
+
+	template<class U>
+	void construct(U*) noexcept
+	{
+
+	}
+
+	template<class U, class... Args>
+	void construct(U *pointer, Args&&... args)
+	{
+		::new(static_cast<void*>(pointer)) U(std::forward<Args>(args)...);
+	}
+};
+
+template<class T, class U>
+bool operator==(const LatticeAllocator<T>&, const LatticeAllocator<U>&)
+{
+	return true;
+}
+
+template<class T, class U>
+bool operator!=(const LatticeAllocator<T>&, const LatticeAllocator<U>&)
+{
+	return false;
+}
+
+/**
+ *\brief streams the name of a mode, heap, transparent, explicit or file.
+ *\param out std::ostream reference that is being streamed to.
+ *\param mode the mode to print.
+ *\return std::ostream reference to output can be chained.
+ */
+std::ostream& operator<<(std::ostream& out, LatticeMemory::Mode mode);
+
+/**
+ *\brief reads the name of a mode, heap, transparent, explicit or file, setting the failbit for any other name.
+ *\param in std::istream reference that is being read from.
+ *\param mode the mode that is read.
+ *\return std::istream reference so input can be chained.
+ */
+std::istream& operator>>(std::istream& in, LatticeMemory::Mode &mode);
+
+#endif /* LatticeMemory_hpp */
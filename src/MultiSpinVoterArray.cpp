@@ -0,0 +1,156 @@
+#include "MultiSpinVoterArray.hpp"
+#include <algorithm> // For std::min.
+
+const int MultiSpinVoterArray::laneCount;
+
+MultiSpinVoterArray::MultiSpinVoterArray(RandomEngine &generator, int rows, int cols, double initialOrder,
+	StubbornPlacement placement, long long stubbornNumber, const std::string &stubbornMask) :
+	m_rowCount{rows},
+	m_colCount{cols},
+	m_opinion(static_cast<std::size_t>(rows) * cols, 0),
+	m_stubborn(m_opinion.size(), 0)
+{
+	std::vector<std::uint64_t> opinions;
+	std::vector<std::uint64_t> stubborn;
+
+	// Build the lanes one at a time and scatter their packed frames into the site words.
+	for(int lane = 0; lane < laneCount; ++lane)
+	{
+		VoterArray lattice(generator, rows, cols, initialOrder);
+		placeStubborn(lattice, placement, stubbornNumber, stubbornMask, generator);
+		lattice.packOpinions(opinions);
+		lattice.packStubborn(stubborn);
+
+		for(std::size_t site = 0; site < m_opinion.size(); ++site)
+		{
+			m_opinion[site]  |= ((opinions[site >> 6] >> (site & 63)) & 1) << lane;
+			m_stubborn[site] |= ((stubborn[site >> 6] >> (site & 63)) & 1) << lane;
+		}
+	}
+}
+
+int MultiSpinVoterArray::getRows() const
+{
+	return m_rowCount;
+}
+
+int MultiSpinVoterArray::getCols() const
+{
+	return m_colCount;
+}
+
+VoterArray::State MultiSpinVoterArray::operator()(int lane, int row, int col) const
+{
+	std::size_t site = static_cast<std::size_t>(col) + static_cast<std::size_t>(row) * m_colCount;
+	int opinion = (m_opinion[site] >> lane) & 1;
+	int stubborn = (m_stubborn[site] >> lane) & 1;
+	return static_cast<VoterArray::State>(opinion | (stubborn << 1));
+}
+
+void MultiSpinVoterArray::update(RandomEngine &generator)
+{
+	std::uint64_t word = generator();
+	int row = static_cast<int>(takeBounded(word, m_rowCount));
+	int col = static_cast<int>(takeBounded(word, m_colCount));
+	std::uint64_t high = generator();
+	updateSite(row, col, high, generator());
+}
+
+void MultiSpinVoterArray::sweep(RandomEngine &generator)
+{
+	// Each update takes a word for the site and two for the directions of the lanes.
+	const std::size_t blockSize = 1024;
+	std::uint64_t words[3 * blockSize];
+
+	std::size_t remaining = m_opinion.size();
+	while(remaining)
+	{
+		std::size_t count = remaining < blockSize ? remaining : blockSize;
+		generator.fill(words, 3 * count);
+
+		for(std::size_t i = 0; i < count; ++i)
+		{
+			std::uint64_t word = words[3 * i];
+			int row = static_cast<int>(takeBounded(word, m_rowCount));
+			int col = static_cast<int>(takeBounded(word, m_colCount));
+			updateSite(row, col, words[3 * i + 1], words[3 * i + 2]);
+		}
+
+		remaining -= count;
+	}
+}
+
+std::uint64_t MultiSpinVoterArray::liveLanes(std::uint64_t lanes) const
+{
+	std::uint64_t live = 0;
+	for(int row = 0; row < m_rowCount && (live & lanes) != lanes; ++row)
+	{
+		std::size_t rowBegin = static_cast<std::size_t>(row) * m_colCount;
+		std::size_t downBegin = static_cast<std::size_t>(row + 1 == m_rowCount ? 0 : row + 1) * m_colCount;
+		for(int col = 0; col < m_colCount; ++col)
+		{
+			std::size_t site = rowBegin + col;
+			std::size_t right = rowBegin + (col + 1 == m_colCount ? 0 : col + 1);
+			std::size_t down = downBegin + col;
+
+			// A bond is live in the lanes where its ends disagree and at least one of them is mobile.
+			live |= (m_opinion[site] ^ m_opinion[right]) & ~(m_stubborn[site] & m_stubborn[right]);
+			live |= (m_opinion[site] ^ m_opinion[down]) & ~(m_stubborn[site] & m_stubborn[down]);
+		}
+	}
+	return live & lanes;
+}
+
+void MultiSpinVoterArray::magnetizations(long long (&magnetization)[laneCount]) const
+{
+	// Bit-sliced counter: plane p holds bit p of the number of democrats seen in each lane. It can count
+	// up to 2^planeCount - 1 words before it has to be emptied into the per lane totals.
+	const int planeCount = 8;
+	const std::size_t flushInterval = (std::size_t(1) << planeCount) - 1;
+
+	long long democrats[laneCount] = {0};
+	std::uint64_t plane[planeCount] = {0};
+
+	for(std::size_t begin = 0; begin < m_opinion.size(); begin += flushInterval)
+	{
+		std::size_t end = std::min(begin + flushInterval, m_opinion.size());
+		for(std::size_t site = begin; site < end; ++site)
+		{
+			// Ripple carry add of one bit per lane, usually done after a plane or two.
+			std::uint64_t carry = m_opinion[site];
+			for(int p = 0; carry && p < planeCount; ++p)
+			{
+				std::uint64_t sum = plane[p] ^ carry;
+				carry &= plane[p];
+				plane[p] = sum;
+			}
+		}
+
+		for(int p = 0; p < planeCount; ++p)
+		{
+			for(int lane = 0; plane[p] && lane < laneCount; ++lane)
+			{
+				democrats[lane] += static_cast<long long>((plane[p] >> lane) & 1) << p;
+			}
+			plane[p] = 0;
+		}
+	}
+
+	long long siteCount = static_cast<long long>(m_opinion.size());
+	for(int lane = 0; lane < laneCount; ++lane)
+	{
+		magnetization[lane] = siteCount - 2 * democrats[lane];
+	}
+}
+
+void MultiSpinVoterArray::orderParameters(std::vector<double> &orderParameter) const
+{
+	long long magnetization[laneCount];
+	magnetizations(magnetization);
+
+	orderParameter.resize(laneCount);
+	for(int lane = 0; lane < laneCount; ++lane)
+	{
+		orderParameter[lane] = static_cast<double>(magnetization[lane]) / m_opinion.size();
+	}
+}
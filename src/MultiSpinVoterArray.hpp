@@ -0,0 +1,154 @@
+#ifndef MultiSpinVoterArray_hpp
+#define MultiSpinVoterArray_hpp
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include "VoterArray.hpp"
+#include "RandomEngine.hpp"
+#include "placeStubborn.hpp"
+
+/**
+ *\file
+ *\class MultiSpinVoterArray
+ *\brief 64 replicas of a Voter lattice updated together, one bit of every site word per replica.
+ *
+ * Site (row,col) is a 64-bit word holding the opinion of that site in each replica (lane), a set bit
+ * being a democrat, and a second word marks the lanes in which the voter is stubborn. An update picks
+ * one site for all the lanes and two random words whose bits give every lane its own neighbour
+ * direction; the new opinions are put together from the four neighbour words with bitwise selects, so
+ * one update of 64 replicas costs about as much as one update of a single VoterArray.
+ *
+ * Each lane on its own follows exactly the random sequential dynamics of VoterArray::update(), but
+ * since all lanes visit the same sequence of sites the replicas are not fully independent: they only
+ * decorrelate through their neighbour choices. Ensemble averages are unbiased, errors that assume
+ * independent replicas are somewhat optimistic early on while the lanes are still alike.
+ *
+ * With stubborn voters every site is still drawn, a sweep being one update per site, so the time scale
+ * matches VoterArray::sweep() whose sweeps are one update per mobile site.
+ */
+class MultiSpinVoterArray
+{
+public:
+	/// Number of replicas in a word.
+	static const int laneCount = 64;
+
+private:
+	/// Number of rows in the lattice.
+	int m_rowCount;
+
+	/// Number of columns in the lattice.
+	int m_colCount;
+
+	/// Opinion of every lane at each site in row-major order, a set bit is a democrat.
+	std::vector<std::uint64_t> m_opinion;
+
+	/// Lanes in which the voter at each site is stubborn.
+	std::vector<std::uint64_t> m_stubborn;
+
+	/**
+	 *\brief Updates a site in every lane.
+	 *\param row row index of site, must be in range.
+	 *\param col column index of site, must be in range.
+	 *\param high random word whose bits are the high bit of each lane's direction.
+	 *\param low random word whose bits are the low bit of each lane's direction.
+	 */
+	void updateSite(int row, int col, std::uint64_t high, std::uint64_t low)
+	{
+		std::size_t rowBegin = static_cast<std::size_t>(row) * m_colCount;
+		std::size_t upBegin = static_cast<std::size_t>(row ? row - 1 : m_rowCount - 1) * m_colCount;
+		std::size_t downBegin = static_cast<std::size_t>(row + 1 == m_rowCount ? 0 : row + 1) * m_colCount;
+		int left = col ? col - 1 : m_colCount - 1;
+		int right = col + 1 == m_colCount ? 0 : col + 1;
+
+		// Directions 0 right, 1 down, 2 left and 3 up as in VoterArray::updateSite().
+		std::uint64_t chosen = (~high & ((~low & m_opinion[rowBegin + right]) | (low & m_opinion[downBegin + col]))) |
+		                       ( high & ((~low & m_opinion[rowBegin + left])  | (low & m_opinion[upBegin + col])));
+
+		std::uint64_t &site = m_opinion[rowBegin + col];
+		std::uint64_t stubborn = m_stubborn[rowBegin + col];
+		site = (site & stubborn) | (chosen & ~stubborn);
+	}
+
+public:
+	/**
+	 *\brief Constructor that sets up each lane as an independent VoterArray would be.
+	 *
+	 * Lane r is a VoterArray constructed with the generator after the lanes before it, with its stubborn
+	 * voters placed by placeStubborn(), so every lane starts from the distribution of a single run.
+	 *
+	 *\param generator RandomEngine reference for generating random numbers.
+	 *\param rows number of rows on the board.
+	 *\param cols number of columns on the board.
+	 *\param initialOrder initial value of the order parameter.
+	 *\param placement where the stubborn voters go.
+	 *\param stubbornNumber number of stubborn voters in each lane.
+	 *\param stubbornMask name of the mask file for the mask placement.
+	 */
+	MultiSpinVoterArray(RandomEngine &generator, int rows, int cols, double initialOrder,
+		StubbornPlacement placement = RandomStubborn, long long stubbornNumber = 0, const std::string &stubbornMask = "");
+
+	/**
+	 *\brief Getter for the number of rows.
+	 *\return Integer value representing the number of rows.
+	 */
+	int getRows() const;
+
+	/**
+	 *\brief Getter for number of columns.
+	 *\return Integer value representing the number of columns.
+	 */
+	int getCols() const;
+
+	/**
+	 *\brief Getter for the state of a site in one lane.
+	 *\param lane index of the replica.
+	 *\param row row index of site, must be in range.
+	 *\param col column index of site, must be in range.
+	 *\return the state of the site in that replica.
+	 */
+	VoterArray::State operator()(int lane, int row, int col) const;
+
+	/**
+	 *\brief Updates a random site in every lane, each lane copying its own random neighbour.
+	 *\param generator RandomEngine reference for random number generation.
+	 */
+	void update(RandomEngine &generator);
+
+	/**
+	 *\brief Performs a sweep, one update per site, in every lane.
+	 *\param generator RandomEngine reference for random number generation.
+	 */
+	void sweep(RandomEngine &generator);
+
+	/**
+	 *\brief Sums the voter values of every lane.
+	 *
+	 * The lanes are counted together with a bit-sliced counter, a few word operations per site, rather
+	 * than extracting the bits of each lane one at a time.
+	 *
+	 *\param magnetization array the sum of the voter values of each lane is written to.
+	 */
+	void magnetizations(long long (&magnetization)[laneCount]) const;
+
+	/**
+	 *\brief Getter for the order parameter of every lane.
+	 *\param orderParameter vector resized to laneCount and overwritten with the order parameter of each lane.
+	 */
+	void orderParameters(std::vector<double> &orderParameter) const;
+
+	/**
+	 *\brief Finds the lanes that have not reached an absorbing state, see VoterArray::frozen().
+	 *
+	 * A lane is live while it has an active bond with a mobile end, found for all lanes at once by
+	 * comparing each site word with its right and lower neighbours. The scan stops once every lane asked
+	 * about is found live, which early in a run is after a few sites.
+	 *
+	 *\param lanes the lanes to test.
+	 *\return a word with the bit of each live lane among them set.
+	 */
+	std::uint64_t liveLanes(std::uint64_t lanes = ~std::uint64_t(0)) const;
+};
+
+#endif /* MultiSpinVoterArray_hpp */
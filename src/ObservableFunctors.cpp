@@ -0,0 +1,26 @@
+#include "ObservableFunctors.hpp"
+
+SusceptibilityFunctor::SusceptibilityFunctor(double siteCount) : m_siteCount{siteCount}
+{
+
+}
+
+int SusceptibilityFunctor::getOrder() const
+{
+	return 2;
+}
+
+double SusceptibilityFunctor::fromMoments(const std::vector<double> &moments) const
+{
+	return m_siteCount * (moments[2] - moments[1] * moments[1]);
+}
+
+int BinderCumulantFunctor::getOrder() const
+{
+	return 4;
+}
+
+double BinderCumulantFunctor::fromMoments(const std::vector<double> &moments) const
+{
+	return 1 - moments[4] / (3 * moments[2] * moments[2]);
+}
@@ -0,0 +1,46 @@
+#ifndef ObservableFunctors_hpp
+#define ObservableFunctors_hpp
+
+#include <vector>
+#include "DataArray.hpp"
+
+/**
+ *\file
+ *\brief Derived quantities of an order parameter trace, for use with the resampling errors of DataArray.
+ */
+
+/**
+ *\class SusceptibilityFunctor
+ *\brief The susceptibility N (<m^2> - <m>^2) of the order parameter m on a lattice of N sites.
+ */
+class SusceptibilityFunctor : public DataArray::IMomentFunctor
+{
+private:
+	/// Number of sites in the lattice.
+	double m_siteCount;
+
+public:
+	/**
+	 *\brief Constructor.
+	 *\param siteCount number of sites in the lattice, 1 gives the variance of the order parameter.
+	 */
+	explicit SusceptibilityFunctor(double siteCount = 1);
+
+	int getOrder() const override;
+
+	double fromMoments(const std::vector<double> &moments) const override;
+};
+
+/**
+ *\class BinderCumulantFunctor
+ *\brief The Binder cumulant 1 - <m^4> / (3 <m^2>^2) of the order parameter m.
+ */
+class BinderCumulantFunctor : public DataArray::IMomentFunctor
+{
+public:
+	int getOrder() const override;
+
+	double fromMoments(const std::vector<double> &moments) const override;
+};
+
+#endif /* ObservableFunctors_hpp */
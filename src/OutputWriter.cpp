@@ -0,0 +1,252 @@
+#include "OutputWriter.hpp"
+
+namespace
+{
+	/// Number of records collected before a batch is handed off.
+	const std::size_t batchSize = 256;
+}
+
+OutputWriter::OutputWriter(const std::string &orderParameterFile, TrajectoryWriter &trajectory, std::size_t capacity, Policy policy, bool append) :
+	m_orderParameterOutput(orderParameterFile, append ? std::ios::out | std::ios::app : std::ios::out),
+	m_trajectory(trajectory),
+	m_clusterBackground{false},
+	m_capacity{capacity < 1 ? 1 : capacity},
+	m_policy{policy},
+	m_dropped{0},
+	m_busy{false},
+	m_stop{false}
+{
+	m_batch.reserve(batchSize);
+	m_thread = std::thread(&OutputWriter::work, this);
+}
+
+OutputWriter::~OutputWriter()
+{
+	flush();
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_itemQueued.notify_one();
+	m_thread.join();
+}
+
+void OutputWriter::push(Item &item, std::unique_lock<std::mutex> &lock)
+{
+	m_itemDone.wait(lock, [this]{ return m_queue.size() < m_capacity; });
+	m_queue.push_back(std::move(item));
+	m_itemQueued.notify_one();
+}
+
+void OutputWriter::record(const Record &record)
+{
+	m_batch.push_back(record);
+	if(m_batch.size() < batchSize)
+	{
+		return;
+	}
+
+	// Records are never dropped, the batch waits for room whatever the policy.
+	Item item;
+	item.kind = Records;
+	item.records.swap(m_batch);
+	item.sweep = 0;
+	m_batch.reserve(batchSize);
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	push(item, lock);
+}
+
+template<class Voters>
+bool OutputWriter::pack(const Voters &voters, std::uint64_t sweep)
+{
+	Item item;
+	item.kind = Snapshot;
+	item.sweep = sweep;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if(m_policy == OutputWriter::Drop && m_queue.size() >= m_capacity)
+		{
+			++m_dropped;
+			return false;
+		}
+
+		// Reuse a buffer the writer has finished with to save an allocation.
+		if(!m_spareFrames.empty())
+		{
+			item.frame.swap(m_spareFrames.back());
+			m_spareFrames.pop_back();
+		}
+	}
+
+	// Pack outside the lock so the writer thread is not held up.
+	voters.packOpinions(item.frame);
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	push(item, lock);
+	return true;
+}
+
+bool OutputWriter::snapshot(const VoterArray &lattice, std::uint64_t sweep)
+{
+	return pack(lattice, sweep);
+}
+
+bool OutputWriter::snapshot(const VoterGraph &graph, std::uint64_t sweep)
+{
+	return pack(graph, sweep);
+}
+
+void OutputWriter::enableClusters(const std::string &clusterFile, int rowCount, int colCount, bool background, bool append)
+{
+	m_clusterOutput.open(clusterFile, append ? std::ios::out | std::ios::app : std::ios::out);
+	m_clusterAnalysis.reset(new ClusterAnalysis(rowCount, colCount));
+	m_clusterBackground = background;
+
+	if(!append)
+	{
+		m_clusterOutput << "# sweep clusters largest-fraction, then the number of clusters of 2^k to 2^(k+1)-1 sites for k = 0 to "
+		                << m_clusterAnalysis->getBinCount() - 1 << '\n';
+	}
+}
+
+void OutputWriter::clusters(const VoterArray &lattice, std::uint64_t sweep)
+{
+	Item item;
+	item.kind = m_clusterBackground ? ClusterFrame : ClusterResult;
+	item.sweep = sweep;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if(!m_spareFrames.empty())
+		{
+			item.frame.swap(m_spareFrames.back());
+			m_spareFrames.pop_back();
+		}
+	}
+
+	// Only the copy is made on the simulation thread in the background, the writer thread owns the
+	// analysis then and nothing else touches it.
+	lattice.packOpinions(item.frame);
+	if(!m_clusterBackground)
+	{
+		m_clusterAnalysis->analyse(item.frame, item.clusters);
+	}
+	item.clusters.sweep = static_cast<long long>(sweep);
+
+	// Like the records the analysis is never dropped, whatever the policy.
+	std::unique_lock<std::mutex> lock(m_mutex);
+	push(item, lock);
+}
+
+void OutputWriter::flush()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	if(!m_batch.empty())
+	{
+		Item item;
+		item.kind = Records;
+		item.records.swap(m_batch);
+		item.sweep = 0;
+		m_batch.reserve(batchSize);
+		push(item, lock);
+	}
+
+	m_itemDone.wait(lock, [this]{ return m_queue.empty() && !m_busy; });
+	m_orderParameterOutput.flush();
+	m_trajectory.flush();
+	if(m_clusterAnalysis)
+	{
+		m_clusterOutput.flush();
+	}
+}
+
+std::size_t OutputWriter::getDroppedCount()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_dropped;
+}
+
+void OutputWriter::work()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while(true)
+	{
+		m_itemQueued.wait(lock, [this]{ return m_stop || !m_queue.empty(); });
+		if(m_queue.empty())
+		{
+			return;
+		}
+
+		Item item = std::move(m_queue.front());
+		m_queue.pop_front();
+		m_busy = true;
+		m_itemDone.notify_all();
+
+		// Format and write without holding the lock.
+		lock.unlock();
+		switch(item.kind)
+		{
+			case Records:
+				for(const auto &record : item.records)
+				{
+					m_orderParameterOutput << record.sweep << ' ' << record.orderParameter << ' ' << record.activeBondDensity << '\n';
+				}
+				break;
+			case Snapshot:
+				m_trajectory.write(item.frame, item.sweep);
+				break;
+			case ClusterFrame:
+				m_clusterAnalysis->analyse(item.frame, item.clusters);
+				m_clusterOutput << item.clusters << '\n';
+				break;
+			case ClusterResult:
+				m_clusterOutput << item.clusters << '\n';
+				break;
+		}
+		lock.lock();
+
+		if(!item.frame.empty())
+		{
+			m_spareFrames.push_back(std::move(item.frame));
+		}
+		m_busy = false;
+		m_itemDone.notify_all();
+	}
+}
+
+std::ostream& operator<<(std::ostream& out, OutputWriter::Policy policy)
+{
+	switch(policy)
+	{
+		case OutputWriter::Block:
+			return out << "block";
+		case OutputWriter::Drop:
+			return out << "drop";
+	}
+	return out;
+}
+
+std::istream& operator>>(std::istream& in, OutputWriter::Policy &policy)
+{
+	std::string name;
+	in >> name;
+
+	if(name == "block")
+	{
+		policy = OutputWriter::Block;
+	}
+	else if(name == "drop")
+	{
+		policy = OutputWriter::Drop;
+	}
+	else
+	{
+		in.setstate(std::ios::failbit);
+	}
+
+	return in;
+}
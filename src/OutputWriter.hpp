@@ -0,0 +1,252 @@
+#ifndef OutputWriter_hpp
+#define OutputWriter_hpp
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include "VoterArray.hpp"
+#include "ClusterAnalysis.hpp"
+#include "VoterGraph.hpp"
+#include "Trajectory.hpp"
+
+/**
+ *\file
+ *\class OutputWriter
+ *\brief Writes the per sweep output on a dedicated thread.
+ *
+ * The simulation thread hands off scalar records and lattice snapshots and carries on, the writer
+ * thread formats the records into the order parameter file and appends the snapshots to the trajectory.
+ * Records are collected in a batch that is swapped out as a whole once full, and snapshot buffers are
+ * recycled, so handing off costs a copy of the packed lattice at most. Optionally the domains of the
+ * lattice are analysed with ClusterAnalysis and their histogram written to a file of its own, either on
+ * the simulation thread or on the writer thread from a snapshot.
+ *
+ * The queue between the threads is bounded. When it is full a batch of records always waits for room,
+ * what happens to a snapshot depends on the policy: Block waits as well and Drop discards the snapshot
+ * so the simulation never waits for the filesystem. Lattices for the cluster analysis are never dropped.
+ */
+class OutputWriter
+{
+public:
+	/**
+	 * \enum Policy
+	 * \brief What to do with a snapshot when the queue is full.
+	 */
+	enum Policy
+	{
+		Block,
+		Drop,
+	};
+
+	/**
+	 *\struct Record
+	 *\brief Scalar observables of one sweep.
+	 */
+	struct Record
+	{
+		/// Sweep the record belongs to.
+		long long sweep;
+		/// Order parameter after the sweep.
+		double orderParameter;
+		/// Density of active bonds after the sweep.
+		double activeBondDensity;
+	};
+
+private:
+	/**
+	 * \enum Kind
+	 * \brief What an item holds.
+	 */
+	enum Kind
+	{
+		Records,
+		Snapshot,
+		ClusterFrame,
+		ClusterResult,
+	};
+
+	/**
+	 *\struct Item
+	 *\brief Unit of work for the writer thread, a batch of records, a snapshot, a lattice to analyse or the analysis.
+	 */
+	struct Item
+	{
+		/// What the item holds.
+		Kind kind;
+		/// Batch of records, empty for the other kinds.
+		std::vector<Record> records;
+		/// Packed lattice, empty for a batch of records.
+		std::vector<std::uint64_t> frame;
+		/// Number of sweeps done when the lattice was taken.
+		std::uint64_t sweep;
+		/// Domains of the lattice, filled in on the writer thread for a lattice to analyse.
+		ClusterAnalysis::Result clusters;
+	};
+
+	/// Order parameter file.
+	std::fstream m_orderParameterOutput;
+
+	/// Trajectory the snapshots are appended to.
+	TrajectoryWriter &m_trajectory;
+
+	/// Cluster file, only open once the cluster analysis is enabled.
+	std::fstream m_clusterOutput;
+
+	/// Analysis of the domains, null until enabled.
+	std::unique_ptr<ClusterAnalysis> m_clusterAnalysis;
+
+	/// Whether the domains are found on the writer thread rather than the simulation thread.
+	bool m_clusterBackground;
+
+	/// Maximum number of items in the queue.
+	std::size_t m_capacity;
+
+	/// What to do with a snapshot when the queue is full.
+	Policy m_policy;
+
+	/// Records collected by the simulation thread since the last hand off.
+	std::vector<Record> m_batch;
+
+	/// Items waiting for the writer thread.
+	std::deque<Item> m_queue;
+
+	/// Snapshot buffers that have been written and can be reused.
+	std::vector<std::vector<std::uint64_t> > m_spareFrames;
+
+	/// Number of snapshots dropped because the queue was full.
+	std::size_t m_dropped;
+
+	/// True while the writer thread is formatting an item.
+	bool m_busy;
+
+	/// Set when the writer thread should exit.
+	bool m_stop;
+
+	/// Guards the queue, the spare buffers and the flags.
+	std::mutex m_mutex;
+
+	/// Signalled when an item is queued or the writer should stop.
+	std::condition_variable m_itemQueued;
+
+	/// Signalled when the writer thread takes an item from the queue or finishes one.
+	std::condition_variable m_itemDone;
+
+	/// Writer thread.
+	std::thread m_thread;
+
+	/**
+	 *\brief Loop run by the writer thread.
+	 */
+	void work();
+
+	/**
+	 *\brief Queues an item, waiting for room if the queue is full.
+	 *\param item the item, moved from.
+	 *\param lock lock on m_mutex held by the caller.
+	 */
+	void push(Item &item, std::unique_lock<std::mutex> &lock);
+
+	/**
+	 *\brief Packs the opinions of a lattice or graph into a snapshot and queues it, see snapshot().
+	 */
+	template<class Voters>
+	bool pack(const Voters &voters, std::uint64_t sweep);
+
+public:
+	/**
+	 *\brief Constructor that opens the order parameter file and starts the writer thread.
+	 *\param orderParameterFile name of the order parameter file.
+	 *\param trajectory TrajectoryWriter reference the snapshots are appended to, only used by the writer thread.
+	 *\param capacity maximum number of items in the queue.
+	 *\param policy what to do with a snapshot when the queue is full.
+	 *\param append true to append to an existing order parameter file rather than replace it.
+	 */
+	OutputWriter(const std::string &orderParameterFile, TrajectoryWriter &trajectory, std::size_t capacity, Policy policy, bool append = false);
+
+	/**
+	 *\brief Destructor that writes everything still queued and stops the writer thread.
+	 */
+	~OutputWriter();
+
+	OutputWriter(const OutputWriter&) = delete;
+	OutputWriter& operator=(const OutputWriter&) = delete;
+
+	/**
+	 *\brief Adds a record to the current batch, handing the batch off once it is full.
+	 *\param record the scalar observables of a sweep.
+	 */
+	void record(const Record &record);
+
+	/**
+	 *\brief Hands off a snapshot of the lattice.
+	 *\param lattice VoterArray to take the snapshot of.
+	 *\param sweep number of sweeps done.
+	 *\return false if the snapshot was dropped.
+	 */
+	bool snapshot(const VoterArray &lattice, std::uint64_t sweep);
+
+	/**
+	 *\brief Hands off a snapshot of the voters on a graph, in their original vertex labels.
+	 *\param graph VoterGraph to take the snapshot of.
+	 *\param sweep number of sweeps done.
+	 *\return false if the snapshot was dropped.
+	 */
+	bool snapshot(const VoterGraph &graph, std::uint64_t sweep);
+
+	/**
+	 *\brief Enables the cluster analysis, call before the first lattice is handed off.
+	 *\param clusterFile name of the cluster file.
+	 *\param rowCount number of rows in the lattice.
+	 *\param colCount number of columns in the lattice.
+	 *\param background true to find the domains on the writer thread from a copy of the lattice.
+	 *\param append true to append to an existing cluster file rather than replace it.
+	 */
+	void enableClusters(const std::string &clusterFile, int rowCount, int colCount, bool background, bool append = false);
+
+	/**
+	 *\brief Finds the domains of the lattice, or hands off a copy for the writer thread to do so, and queues the line for the cluster file.
+	 *\param lattice VoterArray to analyse.
+	 *\param sweep number of sweeps done.
+	 */
+	void clusters(const VoterArray &lattice, std::uint64_t sweep);
+
+	/**
+	 *\brief Hands off the current batch and waits until everything queued has been written and flushed.
+	 *
+	 * The order parameter file, the trajectory and the cluster file are flushed, after which the trajectory
+	 * can be used by the caller until the next record or snapshot.
+	 */
+	void flush();
+
+	/**
+	 *\brief Getter for the number of dropped snapshots.
+	 *\return number of snapshots discarded because the queue was full.
+	 */
+	std::size_t getDroppedCount();
+};
+
+/**
+ *\brief streams the name of a policy, block or drop.
+ *\param out std::ostream reference that is being streamed to.
+ *\param policy the policy to print.
+ *\return std::ostream reference to output can be chained.
+ */
+std::ostream& operator<<(std::ostream& out, OutputWriter::Policy policy);
+
+/**
+ *\brief reads the name of a policy, block or drop, setting the failbit for any other name.
+ *\param in std::istream reference that is being read from.
+ *\param policy the policy that is read.
+ *\return std::istream reference so input can be chained.
+ */
+std::istream& operator>>(std::istream& in, OutputWriter::Policy &policy);
+
+#endif /* OutputWriter_hpp */
@@ -0,0 +1,242 @@
+#include "ParallelSweeper.hpp"
+#include "BinaryIO.hpp"
+#include <stdexcept>
+#include <algorithm> // For std::lower_bound and std::upper_bound.
+
+namespace
+{
+	/**
+	 *\brief Cuts the rows into strips as evenly as the words of the planes allow.
+	 *\return the first row of each strip plus the number of rows, or nothing if some strip would get fewer than 64 sites.
+	 */
+	std::vector<int> cutStrips(const VoterArray &lattice, int stripCount)
+	{
+		int rows = lattice.getRows();
+		std::vector<int> cuts;
+		for(int row = 1; row < rows; ++row)
+		{
+			if(lattice.separatesWords(row))
+			{
+				cuts.push_back(row);
+			}
+		}
+
+		// Each cut goes to the allowed row nearest the even cut, below the rest of the strips.
+		std::vector<int> begin(1, 0);
+		for(int strip = 1; strip < stripCount; ++strip)
+		{
+			long long even = static_cast<long long>(strip) * rows / stripCount;
+			auto above = std::upper_bound(cuts.begin(), cuts.end(), begin.back());
+			if(above == cuts.end())
+			{
+				return std::vector<int>();
+			}
+			auto nearest = std::lower_bound(above, cuts.end(), even);
+			if(nearest == cuts.end() || (nearest != above && even - *(nearest - 1) <= *nearest - even))
+			{
+				--nearest;
+			}
+			begin.push_back(*nearest);
+		}
+		begin.push_back(rows);
+
+		for(int strip = 0; strip < stripCount; ++strip)
+		{
+			if(static_cast<long long>(begin[strip + 1] - begin[strip]) * lattice.getCols() < 64)
+			{
+				return std::vector<int>();
+			}
+		}
+		return begin;
+	}
+
+	/**
+	 *\brief Largest usable thread count for the lattice dimensions.
+	 */
+	int usableThreads(const VoterArray &lattice, int threadCount)
+	{
+		while(threadCount > 1 && cutStrips(lattice, 2 * threadCount).empty())
+		{
+			--threadCount;
+		}
+		return threadCount < 1 ? 1 : threadCount;
+	}
+}
+
+ParallelSweeper::ParallelSweeper(VoterArray &lattice, int threadCount, RandomEngine &generator) :
+	m_lattice(lattice),
+	m_mobile{nullptr},
+	m_barrier(usableThreads(lattice, threadCount) + 1),
+	m_stop{false}
+{
+	threadCount = usableThreads(lattice, threadCount);
+
+	// A single thread takes the whole lattice in one strip and an empty one.
+	m_stripBegin = cutStrips(lattice, 2 * threadCount);
+	if(m_stripBegin.empty())
+	{
+		m_stripBegin = {0, lattice.getRows(), lattice.getRows()};
+	}
+
+	m_deltas.resize(threadCount);
+	// Give each thread the next 2^128 outputs of the generator.
+	for(int thread = 0; thread < threadCount; ++thread)
+	{
+		m_generators.push_back(generator);
+		generator.jump();
+	}
+
+	for(int thread = 0; thread < threadCount; ++thread)
+	{
+		m_threads.emplace_back(&ParallelSweeper::work, this, thread);
+	}
+}
+
+ParallelSweeper::~ParallelSweeper()
+{
+	// Release the workers from the start of sweep barrier with the stop flag set.
+	m_stop = true;
+	m_barrier.wait();
+
+	for(auto &thread : m_threads)
+	{
+		thread.join();
+	}
+}
+
+int ParallelSweeper::getThreadCount() const
+{
+	return static_cast<int>(m_threads.size());
+}
+
+void ParallelSweeper::work(int thread)
+{
+	while(true)
+	{
+		// Wait for the start of a sweep.
+		m_barrier.wait();
+		if(m_stop)
+		{
+			return;
+		}
+
+		updateStrip(thread, 2 * thread);
+		m_barrier.wait();
+
+		updateStrip(thread, 2 * thread + 1);
+		m_barrier.wait();
+	}
+}
+
+void ParallelSweeper::updateStrip(int thread, int strip)
+{
+	RandomEngine &generator = m_generators[thread];
+	VoterArray::Delta &delta = m_deltas[thread];
+
+	// Generate the random words in blocks, each supplies the site and neighbour of one update.
+	const std::size_t blockSize = 1024;
+	std::uint64_t words[blockSize];
+
+	if(m_mobile)
+	{
+		const std::size_t *mobile = m_mobile->data() + m_mobileBegin[strip];
+		std::size_t mobileCount = m_mobileBegin[strip + 1] - m_mobileBegin[strip];
+		int cols = m_lattice.getCols();
+
+		std::size_t remaining = mobileCount;
+		while(remaining)
+		{
+			std::size_t count = remaining < blockSize ? remaining : blockSize;
+			generator.fill(words, count);
+
+			for(std::size_t i = 0; i < count; ++i)
+			{
+				std::uint64_t word = words[i];
+				std::size_t site = mobile[takeBounded(word, mobileCount)];
+				m_lattice.updateSite(static_cast<int>(site / cols), static_cast<int>(site % cols), static_cast<int>(takeBounded(word, 4)), delta);
+			}
+
+			remaining -= count;
+		}
+		return;
+	}
+
+	int stripRows = m_stripBegin[strip + 1] - m_stripBegin[strip];
+	int cols = m_lattice.getCols();
+
+	std::size_t remaining = static_cast<std::size_t>(stripRows) * cols;
+	while(remaining)
+	{
+		std::size_t count = remaining < blockSize ? remaining : blockSize;
+		generator.fill(words, count);
+
+		for(std::size_t i = 0; i < count; ++i)
+		{
+			std::uint64_t word = words[i];
+			int row = m_stripBegin[strip] + static_cast<int>(takeBounded(word, stripRows));
+			int col = static_cast<int>(takeBounded(word, cols));
+			m_lattice.updateSite(row, col, static_cast<int>(takeBounded(word, 4)), delta);
+		}
+
+		remaining -= count;
+	}
+}
+
+void ParallelSweeper::saveState(std::ostream &out) const
+{
+	std::uint64_t state[RandomEngine::stateSize];
+
+	writeBinary(out, static_cast<std::int32_t>(m_generators.size()));
+	for(const auto &generator : m_generators)
+	{
+		generator.getState(state);
+		writeBinary(out, state);
+	}
+}
+
+void ParallelSweeper::loadState(std::istream &in)
+{
+	std::uint64_t state[RandomEngine::stateSize];
+
+	std::int32_t threadCount = 0;
+	readBinary(in, threadCount);
+	if(!in || threadCount != static_cast<std::int32_t>(m_generators.size()))
+	{
+		throw std::runtime_error("parallel sweeper state is for a different number of threads");
+	}
+
+	// The workers are waiting at the start of sweep barrier, which orders these writes before their next reads.
+	for(auto &generator : m_generators)
+	{
+		readBinary(in, state);
+		generator.setState(state);
+	}
+}
+
+void ParallelSweeper::sweep()
+{
+	// The mobile sites are in row-major order so those of a strip are a contiguous run of the list.
+	m_mobile = nullptr;
+	if(m_lattice.getStubbornCount())
+	{
+		m_mobile = &m_lattice.mobileSites();
+		m_mobileBegin.clear();
+		for(int row : m_stripBegin)
+		{
+			std::size_t first = static_cast<std::size_t>(row) * m_lattice.getCols();
+			m_mobileBegin.push_back(std::lower_bound(m_mobile->begin(), m_mobile->end(), first) - m_mobile->begin());
+		}
+	}
+
+	// Start the even phase, wait for it to finish and then wait for the odd phase.
+	m_barrier.wait();
+	m_barrier.wait();
+	m_barrier.wait();
+
+	// The workers are idle now so their changes can be merged into the lattice.
+	for(auto &delta : m_deltas)
+	{
+		m_lattice.applyDelta(delta);
+		delta = VoterArray::Delta();
+	}
+}
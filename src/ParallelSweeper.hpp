@@ -0,0 +1,122 @@
+#ifndef ParallelSweeper_hpp
+#define ParallelSweeper_hpp
+
+#include <vector>
+#include <thread>
+#include <iostream>
+#include "VoterArray.hpp"
+#include "RandomEngine.hpp"
+#include "Barrier.hpp"
+
+/**
+ *\file
+ *\class ParallelSweeper
+ *\brief Performs sweeps of a VoterArray on several threads by domain decomposition.
+ *
+ * The lattice is cut into 2*threads strips of whole rows, thread k owns strips 2k and 2k+1. A sweep
+ * runs in two phases: in the first every thread updates random sites in its even strip and in the
+ * second in its odd strip, with a barrier in between. Neighbouring strips are never written in the
+ * same phase so the neighbour reads at strip edges are consistent. The strips are only cut at rows
+ * that start a new word of the planes, see VoterArray::separatesWords(), so no two strips share a word
+ * and no thread writes to a word another thread is using. That means whole 8 row blocks in the Tiled
+ * and Morton layouts, and a multiple of 64 sites before the cut otherwise. Every strip also holds at
+ * least 64 sites, so in the Halo layout the ghost rows, which share words with the first and last rows
+ * and are written by the owners of the rows they mirror, are only touched by the two edge strips. Each
+ * strip receives as many updates as it has sites so a sweep is still one update per site on average.
+ * With stubborn voters present each strip draws from and receives as many updates as its mobile sites,
+ * as in VoterArray::sweep().
+ *
+ * Each thread draws from its own stream, taken from the generator passed to the constructor by
+ * jumping it ahead 2^128 outputs per thread.
+ */
+class ParallelSweeper
+{
+private:
+	/// Lattice being updated.
+	VoterArray &m_lattice;
+
+	/// First row of each strip plus a final entry holding the number of rows.
+	std::vector<int> m_stripBegin;
+
+	/// Mobile sites of the lattice for the current sweep, null when there are no stubborn voters.
+	const std::vector<std::size_t> *m_mobile;
+
+	/// Position in m_mobile of the first mobile site of each strip plus a final entry holding its size.
+	std::vector<std::size_t> m_mobileBegin;
+
+	/// One generator per thread.
+	std::vector<RandomEngine> m_generators;
+
+	/// Observable changes made by each thread during the current sweep.
+	std::vector<VoterArray::Delta> m_deltas;
+
+	/// Worker threads.
+	std::vector<std::thread> m_threads;
+
+	/// Synchronises the workers with each other and with the calling thread.
+	Barrier m_barrier;
+
+	/// Set when the workers should exit.
+	bool m_stop;
+
+	/**
+	 *\brief Loop run by each worker thread.
+	 *\param thread index of the worker.
+	 */
+	void work(int thread);
+
+	/**
+	 *\brief Performs one update per site, or per mobile site if there are stubborn voters, on random sites of a strip.
+	 *\param thread index of the worker doing the updates.
+	 *\param strip index of the strip.
+	 */
+	void updateStrip(int thread, int strip);
+
+public:
+	/**
+	 *\brief Constructor that starts the worker threads.
+	 *
+	 * The number of threads is reduced if the lattice cannot be cut at word boundaries into strips of
+	 * at least 64 sites each.
+	 *
+	 *\param lattice VoterArray reference to be updated.
+	 *\param threadCount requested number of threads.
+	 *\param generator RandomEngine reference the per thread streams are split from, it is left jumped past them.
+	 */
+	ParallelSweeper(VoterArray &lattice, int threadCount, RandomEngine &generator);
+
+	/**
+	 *\brief Destructor that stops and joins the worker threads.
+	 */
+	~ParallelSweeper();
+
+	ParallelSweeper(const ParallelSweeper&) = delete;
+	ParallelSweeper& operator=(const ParallelSweeper&) = delete;
+
+	/**
+	 *\brief Getter for the number of threads actually used.
+	 *\return Integer value representing the number of worker threads.
+	 */
+	int getThreadCount() const;
+
+	/**
+	 *\brief Performs a sweep of the lattice and updates its tracked observables.
+	 */
+	void sweep();
+
+	/**
+	 *\brief Writes the state of the per thread generators so that a run can be continued.
+	 *\param out std::ostream reference that is being written to in binary.
+	 */
+	void saveState(std::ostream &out) const;
+
+	/**
+	 *\brief Restores the per thread generators written by saveState(), must be called between sweeps.
+	 *\param in std::istream reference that is being read from in binary.
+	 *
+	 * Throws std::runtime_error if the state was saved with a different number of threads.
+	 */
+	void loadState(std::istream &in);
+};
+
+#endif /* ParallelSweeper_hpp */
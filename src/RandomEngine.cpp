@@ -0,0 +1,83 @@
+#include "RandomEngine.hpp"
+
+constexpr int Xoshiro256::stateSize;
+
+Xoshiro256::Xoshiro256(std::uint64_t seed)
+{
+	this->seed(seed);
+}
+
+void Xoshiro256::seed(std::uint64_t seed)
+{
+	// Expand the seed with splitmix64 so that similar seeds give unrelated states.
+	for(auto &word : m_state)
+	{
+		std::uint64_t z = (seed += 0x9e3779b97f4a7c15ULL);
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+		word = z ^ (z >> 31);
+	}
+}
+
+void Xoshiro256::getState(std::uint64_t (&state)[stateSize]) const
+{
+	for(int i = 0; i < stateSize; ++i)
+	{
+		state[i] = m_state[i];
+	}
+}
+
+void Xoshiro256::setState(const std::uint64_t (&state)[stateSize])
+{
+	for(int i = 0; i < stateSize; ++i)
+	{
+		m_state[i] = state[i];
+	}
+}
+
+void Xoshiro256::fill(std::uint64_t *out, std::size_t count)
+{
+	for(std::size_t i = 0; i < count; ++i)
+	{
+		out[i] = (*this)();
+	}
+}
+
+void Xoshiro256::jump(const std::uint64_t (&table)[stateSize])
+{
+	std::uint64_t state[stateSize] = {0, 0, 0, 0};
+
+	for(const auto &entry : table)
+	{
+		for(int bit = 0; bit < 64; ++bit)
+		{
+			if(entry & (std::uint64_t(1) << bit))
+			{
+				for(int i = 0; i < stateSize; ++i)
+				{
+					state[i] ^= m_state[i];
+				}
+			}
+			(*this)();
+		}
+	}
+
+	for(int i = 0; i < stateSize; ++i)
+	{
+		m_state[i] = state[i];
+	}
+}
+
+void Xoshiro256::jump()
+{
+	static const std::uint64_t table[stateSize] =
+		{0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL};
+	jump(table);
+}
+
+void Xoshiro256::longJump()
+{
+	static const std::uint64_t table[stateSize] =
+		{0x76e15d3efefdcbbfULL, 0xc5004e441c522fb3ULL, 0x77710069854ee241ULL, 0x39109bb02acbe635ULL};
+	jump(table);
+}
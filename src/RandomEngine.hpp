@@ -0,0 +1,140 @@
+#ifndef RandomEngine_hpp
+#define RandomEngine_hpp
+
+#include <cstdint>
+#include <cstddef>
+#include <limits>
+
+/**
+ *\file
+ *\class Xoshiro256
+ *\brief The xoshiro256** pseudo random number generator.
+ *
+ * A fast generator with 256 bits of state that satisfies the standard uniform random bit generator
+ * requirements, so it can be fed to any standard distribution. The jump methods advance the state by
+ * 2^128 and 2^192 outputs which is how independent streams are handed to threads and replicas.
+ */
+class Xoshiro256
+{
+public:
+	/// Type of the generated values.
+	typedef std::uint64_t result_type;
+
+	/// Number of words of state.
+	static constexpr int stateSize = 4;
+
+private:
+	/// Generator state.
+	std::uint64_t m_state[stateSize];
+
+	/**
+	 *\brief Bitwise left rotation.
+	 */
+	static std::uint64_t rotl(std::uint64_t x, int k)
+	{
+		return (x << k) | (x >> (64 - k));
+	}
+
+	/**
+	 *\brief Advances the state by the polynomial described by the jump table.
+	 */
+	void jump(const std::uint64_t (&table)[stateSize]);
+
+public:
+	/**
+	 *\brief Constructor that seeds the generator.
+	 *\param seed 64-bit seed, expanded to the full state with splitmix64.
+	 */
+	explicit Xoshiro256(std::uint64_t seed = 0);
+
+	/**
+	 *\brief Reseeds the generator.
+	 *\param seed 64-bit seed, expanded to the full state with splitmix64.
+	 */
+	void seed(std::uint64_t seed);
+
+	/// Smallest value the generator produces.
+	static constexpr result_type min() { return 0; }
+
+	/// Largest value the generator produces.
+	static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+	/**
+	 *\brief Generates the next value.
+	 *\return a uniformly distributed 64-bit value.
+	 */
+	result_type operator()()
+	{
+		const std::uint64_t result = rotl(m_state[1] * 5, 7) * 9;
+		const std::uint64_t t = m_state[1] << 17;
+
+		m_state[2] ^= m_state[0];
+		m_state[3] ^= m_state[1];
+		m_state[1] ^= m_state[2];
+		m_state[0] ^= m_state[3];
+		m_state[2] ^= t;
+		m_state[3] = rotl(m_state[3], 45);
+
+		return result;
+	}
+
+	/**
+	 *\brief Fills a buffer with generated values.
+	 *\param out pointer to the first value to write.
+	 *\param count number of values to write.
+	 */
+	void fill(std::uint64_t *out, std::size_t count);
+
+	/**
+	 *\brief Generates a double uniformly distributed in [0,1).
+	 */
+	double uniform()
+	{
+		return ((*this)() >> 11) * (1.0 / 9007199254740992.0);
+	}
+
+	/**
+	 *\brief Getter for the state, so that it can be checkpointed.
+	 *\param state array the state is copied into.
+	 */
+	void getState(std::uint64_t (&state)[stateSize]) const;
+
+	/**
+	 *\brief Setter for the state, so that a checkpointed generator can carry on.
+	 *\param state array the state is copied from.
+	 */
+	void setState(const std::uint64_t (&state)[stateSize]);
+
+	/**
+	 *\brief Equivalent to 2^128 calls to operator(), used to start streams for threads.
+	 */
+	void jump();
+
+	/**
+	 *\brief Equivalent to 2^192 calls to operator(), used to start streams for replicas.
+	 */
+	void longJump();
+};
+
+/// Generator used by the simulation, any class with the Xoshiro256 interface can be substituted.
+typedef Xoshiro256 RandomEngine;
+
+/**
+ *\brief Takes a uniformly distributed integer in [0,range) from the top of a random word.
+ *
+ * The word is replaced by the remaining low bits, which are uniform as well, so several small
+ * integers (a row, a column and a neighbour direction) can be taken from one generated word. The bias
+ * is of the order of the product of the ranges over 2^64.
+ *
+ *\param word random word, overwritten with the unused bits.
+ *\param range number of possible values.
+ *\return integer in [0,range).
+ */
+inline std::uint64_t takeBounded(std::uint64_t &word, std::uint64_t range)
+{
+	unsigned __int128 product = static_cast<unsigned __int128>(word) * range;
+	word = static_cast<std::uint64_t>(product);
+	return static_cast<std::uint64_t>(product >> 64);
+}
+
+#endif /* RandomEngine_hpp */
@@ -0,0 +1,193 @@
+#include "RejectionFreeEngine.hpp"
+#include "BinaryIO.hpp"
+#include <algorithm> // For std::fill.
+#include <stdexcept>
+#include <cmath>
+
+RejectionFreeEngine::RejectionFreeEngine(VoterArray &lattice) :
+	m_lattice(lattice),
+	m_class(static_cast<std::size_t>(lattice.getSize()), 0),
+	m_position(static_cast<std::size_t>(lattice.getSize()), 0),
+	m_time{0}
+{
+	for(int row = 0; row < m_lattice.getRows(); ++row)
+	{
+		for(int col = 0; col < m_lattice.getCols(); ++col)
+		{
+			classify(row, col);
+		}
+	}
+}
+
+int RejectionFreeEngine::disagreeingNeighbours(int row, int col) const
+{
+	VoterArray::State state = m_lattice(row, col);
+	if(state == VoterArray::RepublicanStubborn || state == VoterArray::DemocratStubborn)
+	{
+		return 0;
+	}
+
+	// Compare the opinion bits only, stubborn neighbours count like any other.
+	int opinion = state & 1;
+	return ((m_lattice(row, col + 1) & 1) != opinion) + ((m_lattice(row + 1, col) & 1) != opinion)
+		 + ((m_lattice(row, col - 1) & 1) != opinion) + ((m_lattice(row - 1, col) & 1) != opinion);
+}
+
+void RejectionFreeEngine::classify(int row, int col)
+{
+	row = (row + m_lattice.getRows()) % m_lattice.getRows();
+	col = (col + m_lattice.getCols()) % m_lattice.getCols();
+
+	std::size_t site = static_cast<std::size_t>(col) + static_cast<std::size_t>(row) * m_lattice.getCols();
+	int newClass = disagreeingNeighbours(row, col);
+	int oldClass = m_class[site];
+
+	if(newClass == oldClass)
+	{
+		return;
+	}
+
+	// Remove the site from its old set by moving the last member into its place.
+	if(oldClass)
+	{
+		std::vector<std::size_t> &members = m_members[oldClass];
+		std::size_t last = members.back();
+		members[m_position[site]] = last;
+		m_position[last] = m_position[site];
+		members.pop_back();
+	}
+
+	if(newClass)
+	{
+		m_position[site] = m_members[newClass].size();
+		m_members[newClass].push_back(site);
+	}
+
+	m_class[site] = static_cast<std::uint8_t>(newClass);
+}
+
+double RejectionFreeEngine::totalRate() const
+{
+	double rate = 0;
+	for(int k = 1; k <= 4; ++k)
+	{
+		rate += k * static_cast<double>(m_members[k].size());
+	}
+	return rate / 4;
+}
+
+void RejectionFreeEngine::flip(RandomEngine &generator)
+{
+	// Pick the class with probability proportional to its total rate k * n_k.
+	double target = generator.uniform() * 4 * totalRate();
+	int k = 4;
+	for(int candidate = 1; candidate < 4; ++candidate)
+	{
+		target -= candidate * static_cast<double>(m_members[candidate].size());
+		if(target < 0)
+		{
+			k = candidate;
+			break;
+		}
+	}
+
+	// Rounding can leave the last class chosen while empty, fall back to the highest non-empty one.
+	while(m_members[k].empty())
+	{
+		--k;
+	}
+
+	// Every member of a class has the same rate so pick one uniformly.
+	std::uint64_t word = generator();
+	std::size_t site = m_members[k][takeBounded(word, m_members[k].size())];
+
+	int row = static_cast<int>(site / m_lattice.getCols());
+	int col = static_cast<int>(site % m_lattice.getCols());
+
+	m_lattice.setState(row, col, m_lattice(row, col) == VoterArray::Democrat ? VoterArray::Republican : VoterArray::Democrat);
+
+	// Every event is a flip, the rejected updates of the sequential engine are never made.
+	if(instrumented)
+	{
+		VoterArray::Delta delta;
+		delta.counters.attempts = 1;
+		delta.counters.flips = 1;
+		m_lattice.applyDelta(delta);
+	}
+
+	// Only the flipped site and its neighbours can have changed class.
+	classify(row, col);
+	classify(row, col + 1);
+	classify(row + 1, col);
+	classify(row, col - 1);
+	classify(row - 1, col);
+}
+
+double RejectionFreeEngine::getTime() const
+{
+	return m_time;
+}
+
+std::size_t RejectionFreeEngine::getActiveCount() const
+{
+	return m_members[1].size() + m_members[2].size() + m_members[3].size() + m_members[4].size();
+}
+
+void RejectionFreeEngine::advance(double time, RandomEngine &generator)
+{
+	while(m_time < time)
+	{
+		double rate = totalRate();
+		if(rate == 0)
+		{
+			// Frozen, nothing will ever happen again.
+			return;
+		}
+
+		// Exponential waiting time with the total rate.
+		double next = m_time - std::log1p(-generator.uniform()) / rate;
+		if(next >= time)
+		{
+			m_time = time;
+			return;
+		}
+
+		m_time = next;
+		flip(generator);
+	}
+}
+
+void RejectionFreeEngine::saveState(std::ostream &out) const
+{
+	writeBinary(out, m_time);
+	for(int k = 1; k <= 4; ++k)
+	{
+		writeBinary(out, m_members[k]);
+	}
+}
+
+void RejectionFreeEngine::loadState(std::istream &in)
+{
+	readBinary(in, m_time);
+
+	std::fill(m_class.begin(), m_class.end(), 0);
+	for(int k = 1; k <= 4; ++k)
+	{
+		readBinary(in, m_members[k]);
+		for(std::size_t i = 0; i < m_members[k].size(); ++i)
+		{
+			std::size_t site = m_members[k][i];
+			if(site >= m_class.size())
+			{
+				throw std::runtime_error("rejection free engine state does not fit the lattice");
+			}
+			m_class[site] = static_cast<std::uint8_t>(k);
+			m_position[site] = i;
+		}
+	}
+
+	if(!in)
+	{
+		throw std::runtime_error("truncated rejection free engine state");
+	}
+}
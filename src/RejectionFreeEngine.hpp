@@ -0,0 +1,120 @@
+#ifndef RejectionFreeEngine_hpp
+#define RejectionFreeEngine_hpp
+
+#include <vector>
+#include <cstdint>
+#include <iostream>
+#include <cstddef>
+#include "VoterArray.hpp"
+#include "RandomEngine.hpp"
+
+/**
+ *\file
+ *\class RejectionFreeEngine
+ *\brief Continuous time (n-fold way) update engine for a VoterArray.
+ *
+ * In the random sequential update each site is picked at rate 1 per sweep and copies a random one of
+ * its 4 neighbours, so a non-stubborn site with k disagreeing neighbours flips at rate k/4 and every
+ * other pick does nothing. This engine keeps the active sites, non-stubborn sites with at least one
+ * disagreeing neighbour, in an indexable set for each k. Every event flips a site chosen with
+ * probability proportional to its rate and the time advances by an exponential waiting time with the
+ * total rate, which gives the same dynamics without wasting picks near consensus. Time is measured
+ * in sweeps.
+ */
+class RejectionFreeEngine
+{
+private:
+	/// Lattice being updated.
+	VoterArray &m_lattice;
+
+	/// Number of disagreeing neighbours of each site, 0 for inactive and stubborn sites.
+	std::vector<std::uint8_t> m_class;
+
+	/// Position of each active site in the member list of its class.
+	std::vector<std::size_t> m_position;
+
+	/// Row-major site indices of the active sites, one list for each number of disagreeing neighbours.
+	std::vector<std::size_t> m_members[5];
+
+	/// Current time in sweeps.
+	double m_time;
+
+	/**
+	 *\brief Counts the neighbours of a site whose opinion differs from its own.
+	 *\param row row index of site.
+	 *\param col column index of site.
+	 *\return number of disagreeing neighbours, 0 for a stubborn site.
+	 */
+	int disagreeingNeighbours(int row, int col) const;
+
+	/**
+	 *\brief Moves a site into the set matching its current number of disagreeing neighbours.
+	 *\param row row index of site, periodic boundary conditions are applied.
+	 *\param col column index of site, periodic boundary conditions are applied.
+	 */
+	void classify(int row, int col);
+
+	/**
+	 *\brief Total flip rate of all active sites in flips per sweep.
+	 *\return the total rate.
+	 */
+	double totalRate() const;
+
+	/**
+	 *\brief Flips a site chosen with probability proportional to its rate.
+	 *\param generator RandomEngine reference for random number generation.
+	 */
+	void flip(RandomEngine &generator);
+
+public:
+	/**
+	 *\brief Constructor that builds the active site sets from the current lattice.
+	 *\param lattice VoterArray reference to be updated, it must not be changed by anything else.
+	 */
+	explicit RejectionFreeEngine(VoterArray &lattice);
+
+	/**
+	 *\brief Getter for the time.
+	 *\return floating point value representing the elapsed time in sweeps.
+	 */
+	double getTime() const;
+
+	/**
+	 *\brief Getter for the number of active sites.
+	 *\return number of non-stubborn sites with at least one disagreeing neighbour.
+	 */
+	std::size_t getActiveCount() const;
+
+	/**
+	 *\brief Performs every flip up to the given time.
+	 *
+	 * The waiting time that overshoots the target is discarded, which is exact since the waiting
+	 * times are memoryless. If no site is active the lattice is frozen and the time stays at the last
+	 * flip, the time it froze.
+	 *
+	 *\param time time in sweeps to advance to.
+	 *\param generator RandomEngine reference for random number generation.
+	 */
+	void advance(double time, RandomEngine &generator);
+
+	/**
+	 *\brief Writes the time and the active site sets so that a run can be continued.
+	 *
+	 * The order of the members matters as much as the sets themselves, a rebuilt engine would pick
+	 * different sites from the same random numbers.
+	 *
+	 *\param out std::ostream reference that is being written to in binary.
+	 */
+	void saveState(std::ostream &out) const;
+
+	/**
+	 *\brief Restores the time and the active site sets written by saveState().
+	 *\param in std::istream reference that is being read from in binary.
+	 *
+	 * The lattice must already hold the state it had when saveState() was called. Throws
+	 * std::runtime_error if the state does not fit the lattice.
+	 */
+	void loadState(std::istream &in);
+};
+
+#endif /* RejectionFreeEngine_hpp */
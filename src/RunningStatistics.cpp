@@ -0,0 +1,102 @@
+#include "RunningStatistics.hpp"
+#include <cmath>
+#include <algorithm> // For std::max.
+
+void RunningStatistics::Moments::push(double value)
+{
+	++count;
+	double deviation = value - mean;
+	mean += deviation / count;
+	m2 += deviation * (value - mean);
+}
+
+RunningStatistics::RunningStatistics() : m_levels(1), m_pending(1), m_hasPending(1, false)
+{
+
+}
+
+void RunningStatistics::push(double sample)
+{
+	// Carry the value up the levels for as long as it completes a pair.
+	double value = sample;
+	for(std::size_t level = 0; ; ++level)
+	{
+		if(level == m_levels.size())
+		{
+			m_levels.emplace_back();
+			m_pending.push_back(0);
+			m_hasPending.push_back(false);
+		}
+
+		m_levels[level].push(value);
+		if(!m_hasPending[level])
+		{
+			m_pending[level] = value;
+			m_hasPending[level] = true;
+			return;
+		}
+
+		value = (m_pending[level] + value) / 2;
+		m_hasPending[level] = false;
+	}
+}
+
+long long RunningStatistics::getCount() const
+{
+	return m_levels[0].count;
+}
+
+double RunningStatistics::mean() const
+{
+	return m_levels[0].mean;
+}
+
+double RunningStatistics::variance() const
+{
+	return m_levels[0].m2 / (m_levels[0].count - 1);
+}
+
+double RunningStatistics::error() const
+{
+	return blockError(0);
+}
+
+int RunningStatistics::getLevelCount() const
+{
+	return static_cast<int>(m_levels.size());
+}
+
+long long RunningStatistics::getBlockCount(int level) const
+{
+	return m_levels[level].count;
+}
+
+double RunningStatistics::blockError(int level) const
+{
+	const Moments &moments = m_levels[level];
+	return std::sqrt(moments.m2 / (moments.count - 1) / moments.count);
+}
+
+double RunningStatistics::blockingError(long long minBlocks) const
+{
+	// Fall back to the naive error when there are too few samples for blocking.
+	double error = blockError(0);
+	for(int level = 1; level < getLevelCount() && m_levels[level].count >= minBlocks; ++level)
+	{
+		error = std::max(error, blockError(level));
+	}
+	return error;
+}
+
+double RunningStatistics::autoCorrelationTime(long long minBlocks) const
+{
+	// Constant samples have no error to compare the blocks against, they are taken as uncorrelated.
+	double naiveError = error();
+	if(naiveError == 0)
+	{
+		return 0.5;
+	}
+
+	double ratio = blockingError(minBlocks) / naiveError;
+	return ratio * ratio / 2;
+}
@@ -0,0 +1,124 @@
+#ifndef RunningStatistics_hpp
+#define RunningStatistics_hpp
+
+#include <vector>
+
+/**
+ *\file
+ *\class RunningStatistics
+ *\brief Summarises a stream of samples without storing it.
+ *
+ * The mean and variance are updated one sample at a time with Welford's algorithm, which is stable
+ * however long the stream. Alongside, the samples are averaged in pairs, the pair averages in pairs and
+ * so on, with the same running moments kept for the blocks of 2^k samples at every level k. For
+ * correlated samples the naive error of the mean grows with the block size until the blocks are longer
+ * than the correlation time and then levels off, and that plateau is the true error (the blocking
+ * analysis of Flyvbjerg and Petersen). Memory is O(log N) for N samples.
+ */
+class RunningStatistics
+{
+private:
+	/**
+	 *\struct Moments
+	 *\brief Running count, mean and sum of squared deviations of a stream.
+	 */
+	struct Moments
+	{
+		/// Number of values.
+		long long count = 0;
+		/// Mean of the values.
+		double mean = 0;
+		/// Sum of the squared deviations from the mean.
+		double m2 = 0;
+
+		/**
+		 *\brief Adds a value with Welford's update.
+		 */
+		void push(double value);
+	};
+
+	/// Moments of the block averages at each level, level k holds the averages of blocks of 2^k samples.
+	std::vector<Moments> m_levels;
+
+	/// First half of the block being formed at each level, waiting for its partner.
+	std::vector<double> m_pending;
+
+	/// Whether each level has a first half waiting.
+	std::vector<bool> m_hasPending;
+
+public:
+	/**
+	 *\brief Default constructor for an empty stream.
+	 */
+	RunningStatistics();
+
+	/**
+	 *\brief Adds a sample, O(1) amortised.
+	 *\param sample floating point value to add.
+	 */
+	void push(double sample);
+
+	/**
+	 *\brief Getter for the number of samples.
+	 *\return Integer value representing the number of samples added.
+	 */
+	long long getCount() const;
+
+	/**
+	 *\brief Method to calculate the mean of the samples.
+	 *\return Floating point value representing the mean.
+	 */
+	double mean() const;
+
+	/**
+	 *\brief Method to calculate the unbiased variance of the samples.
+	 *\return Floating point value representing the variance.
+	 */
+	double variance() const;
+
+	/**
+	 *\brief Method to calculate the naive error of the mean, which assumes uncorrelated samples.
+	 *\return Floating point value representing the naive error.
+	 */
+	double error() const;
+
+	/**
+	 *\brief Getter for the number of blocking levels.
+	 *\return Integer value representing the number of levels, level 0 being the samples themselves.
+	 */
+	int getLevelCount() const;
+
+	/**
+	 *\brief Getter for the number of complete blocks at a level.
+	 *\param level blocking level, blocks hold 2^level samples.
+	 *\return Integer value representing the number of blocks.
+	 */
+	long long getBlockCount(int level) const;
+
+	/**
+	 *\brief Method to calculate the error of the mean from the block averages at a level.
+	 *\param level blocking level, blocks hold 2^level samples.
+	 *\return Floating point value representing the error estimate.
+	 */
+	double blockError(int level) const;
+
+	/**
+	 *\brief Method to estimate the error of the mean of correlated samples.
+	 *
+	 * Takes the largest block error over the levels with enough blocks for it to be meaningful, which
+	 * is the plateau once the blocks are longer than the correlation time.
+	 *
+	 *\param minBlocks smallest number of blocks a level needs to be considered.
+	 *\return Floating point value representing the error estimate.
+	 */
+	double blockingError(long long minBlocks = 32) const;
+
+	/**
+	 *\brief Method to estimate the integrated autocorrelation time from the blocking error.
+	 *\param minBlocks smallest number of blocks a level needs to be considered, see blockingError().
+	 *\return Floating point value representing the autocorrelation time in samples, 1/2 for uncorrelated or constant samples.
+	 */
+	double autoCorrelationTime(long long minBlocks = 32) const;
+};
+
+#endif /* RunningStatistics_hpp */
@@ -0,0 +1,160 @@
+#include "ThreadPool.hpp"
+
+namespace
+{
+	/// Pool the calling thread works for, null outside of any pool.
+	thread_local const ThreadPool *currentPool = nullptr;
+
+	/// Index of the calling thread within currentPool.
+	thread_local int currentWorker = 0;
+}
+
+ThreadPool::ThreadPool(int threadCount) : m_queued{0}, m_pending{0}, m_submitted{0}, m_nextQueue{0}, m_stop{false}
+{
+	if(threadCount < 1)
+	{
+		threadCount = 1;
+	}
+
+	for(int thread = 0; thread < threadCount; ++thread)
+	{
+		m_queues.emplace_back(new Queue);
+	}
+
+	for(int thread = 0; thread < threadCount; ++thread)
+	{
+		m_threads.emplace_back(&ThreadPool::work, this, thread);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_taskAvailable.notify_all();
+
+	for(auto &thread : m_threads)
+	{
+		thread.join();
+	}
+}
+
+int ThreadPool::getThreadCount() const
+{
+	return static_cast<int>(m_threads.size());
+}
+
+bool ThreadPool::inWorker()
+{
+	return currentPool != nullptr;
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+	std::size_t queue;
+	{
+		// Count the task before it is visible so that m_queued never falls below the queued tasks.
+		std::lock_guard<std::mutex> lock(m_mutex);
+		++m_queued;
+		++m_pending;
+
+		if(currentPool == this)
+		{
+			queue = static_cast<std::size_t>(currentWorker);
+		}
+		else
+		{
+			queue = m_nextQueue;
+			m_nextQueue = (m_nextQueue + 1) % m_queues.size();
+		}
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_queues[queue]->mutex);
+		m_queues[queue]->tasks.push_back(std::move(task));
+	}
+
+	// Only announce the task once it can be taken.
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		++m_submitted;
+	}
+	m_taskAvailable.notify_one();
+}
+
+void ThreadPool::wait()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_allDone.wait(lock, [this]{ return m_pending == 0; });
+}
+
+bool ThreadPool::take(int worker, std::function<void()> &task)
+{
+	// Start with the worker's own queue and go round the others.
+	for(std::size_t i = 0; i < m_queues.size(); ++i)
+	{
+		Queue &queue = *m_queues[(worker + i) % m_queues.size()];
+
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if(queue.tasks.empty())
+		{
+			continue;
+		}
+		if(i == 0)
+		{
+			task = std::move(queue.tasks.front());
+			queue.tasks.pop_front();
+		}
+		else
+		{
+			task = std::move(queue.tasks.back());
+			queue.tasks.pop_back();
+		}
+		return true;
+	}
+	return false;
+}
+
+void ThreadPool::work(int worker)
+{
+	currentPool = this;
+	currentWorker = worker;
+
+	// Tasks announced before the queues were last looked at, every one of them was in a queue by then.
+	unsigned long long submitted = 0;
+	while(true)
+	{
+		std::function<void()> task;
+		if(!take(worker, task))
+		{
+			// Sleep until a task is announced that the look may have missed, rather than spinning on
+			// one that has been counted but not yet queued or has been taken by another worker.
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_taskAvailable.wait(lock, [&]{ return m_stop || m_submitted != submitted; });
+
+			// Only exit once every queue has been drained.
+			if(m_stop && m_queued == 0)
+			{
+				return;
+			}
+			submitted = m_submitted;
+			continue;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			--m_queued;
+		}
+
+		task();
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if(--m_pending == 0)
+		{
+			m_allDone.notify_all();
+		}
+		submitted = m_submitted;
+	}
+}
@@ -0,0 +1,125 @@
+#ifndef ThreadPool_hpp
+#define ThreadPool_hpp
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+/**
+ *\file
+ *\class ThreadPool
+ *\brief Fixed set of worker threads that run submitted tasks, balanced by work stealing.
+ *
+ * Every worker has its own queue. Tasks submitted from outside the pool are dealt to the queues in
+ * turn and tasks submitted by a running task go to the queue of its worker. A worker takes tasks from
+ * the front of its own queue and, once that is empty, steals from the back of the others, so the owner
+ * and the thief do not contend for the same end. Tasks submitted in order of decreasing cost are still
+ * started roughly in that order by their owners, and a thief takes the small tasks left at the back,
+ * which evens out the finish. Submitting the biggest tasks first keeps a long one from being left to
+ * run alone at the end.
+ *
+ * A worker that finds every queue empty sleeps until another task is submitted.
+ */
+class ThreadPool
+{
+private:
+	/**
+	 *\struct Queue
+	 *\brief Tasks of one worker.
+	 */
+	struct Queue
+	{
+		/// Tasks waiting to run.
+		std::deque<std::function<void()> > tasks;
+		/// Guards the tasks.
+		std::mutex mutex;
+	};
+
+	/// One queue per worker.
+	std::vector<std::unique_ptr<Queue> > m_queues;
+
+	/// Worker threads.
+	std::vector<std::thread> m_threads;
+
+	/// Number of tasks submitted but not yet taken by a worker, never less than the number in the queues.
+	int m_queued;
+
+	/// Number of tasks submitted but not yet finished.
+	int m_pending;
+
+	/// Number of tasks that have been put in a queue, a worker sleeps until it changes.
+	unsigned long long m_submitted;
+
+	/// Queue the next task submitted from outside the pool goes to.
+	std::size_t m_nextQueue;
+
+	/// Set when the workers should exit.
+	bool m_stop;
+
+	/// Guards the counters and flags.
+	std::mutex m_mutex;
+
+	/// Signalled when a task is submitted or the pool is stopping.
+	std::condition_variable m_taskAvailable;
+
+	/// Signalled when the last pending task finishes.
+	std::condition_variable m_allDone;
+
+	/**
+	 *\brief Takes a task from the front of the worker's own queue or, failing that, steals one from the back of another queue.
+	 *\param worker index of the worker.
+	 *\param task the task that is taken.
+	 *\return false if every queue was empty.
+	 */
+	bool take(int worker, std::function<void()> &task);
+
+	/**
+	 *\brief Loop run by each worker thread.
+	 *\param worker index of the worker.
+	 */
+	void work(int worker);
+
+public:
+	/**
+	 *\brief Constructor that starts the worker threads.
+	 *\param threadCount number of worker threads, at least one is started.
+	 */
+	explicit ThreadPool(int threadCount);
+
+	/**
+	 *\brief Destructor that finishes the queued tasks and joins the workers.
+	 */
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	/**
+	 *\brief Getter for the number of worker threads.
+	 *\return Integer value representing the number of workers.
+	 */
+	int getThreadCount() const;
+
+	/**
+	 *\brief Tests whether the calling thread is a worker of any pool.
+	 *\return true inside a task, where starting more threads would oversubscribe the cores.
+	 */
+	static bool inWorker();
+
+	/**
+	 *\brief Queues a task to be run by a worker.
+	 *\param task function to run.
+	 */
+	void submit(std::function<void()> task);
+
+	/**
+	 *\brief Blocks until every submitted task has finished.
+	 */
+	void wait();
+};
+
+#endif /* ThreadPool_hpp */
@@ -0,0 +1,234 @@
+#include "Trajectory.hpp"
+#include <stdexcept>
+#include <limits>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+const std::uint64_t TrajectoryWriter::magic;
+const std::uint64_t TrajectoryWriter::version;
+
+namespace
+{
+	/// Number of words in the header.
+	const std::size_t headerWords = 8;
+
+	/**
+	 *\brief Checks that the header and index of a mapped trajectory only point inside it.
+	 *\return true if every frame lies whole between the header and the index.
+	 */
+	bool isConsistent(const unsigned char *data, std::size_t size)
+	{
+		const std::uint64_t *header = reinterpret_cast<const std::uint64_t*>(data);
+		std::uint64_t rows = header[2];
+		std::uint64_t cols = header[3];
+		std::uint64_t frameBytes = header[4];
+		std::uint64_t frameCount = header[6];
+		std::uint64_t indexOffset = header[7];
+		std::uint64_t headerBytes = headerWords * sizeof(std::uint64_t);
+
+		if(header[0] != TrajectoryWriter::magic || header[1] != TrajectoryWriter::version ||
+		   rows == 0 || rows > std::numeric_limits<int>::max() || cols == 0 || cols > std::numeric_limits<int>::max() ||
+		   frameBytes != (rows * cols + 63) / 64 * 8)
+		{
+			return false;
+		}
+
+		// A zero index offset marks a file that was never closed.
+		if(indexOffset < headerBytes || indexOffset % sizeof(std::uint64_t) || indexOffset > size ||
+		   frameCount > (size - indexOffset) / (2 * sizeof(std::uint64_t)))
+		{
+			return false;
+		}
+
+		const std::uint64_t *index = reinterpret_cast<const std::uint64_t*>(data + indexOffset);
+		for(std::uint64_t frame = 0; frame < frameCount; ++frame)
+		{
+			std::uint64_t offset = index[2 * frame + 1];
+			if(offset < headerBytes || offset % sizeof(std::uint64_t) || offset > indexOffset || frameBytes > indexOffset - offset)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+TrajectoryWriter::TrajectoryWriter(const std::string &fileName, int rows, int cols, int stride) :
+	m_file(fileName, std::ios::out | std::ios::binary | std::ios::trunc),
+	m_rowCount(rows),
+	m_colCount(cols),
+	m_stride(stride)
+{
+	writeHeader(0, 0);
+}
+
+TrajectoryWriter::TrajectoryWriter(const std::string &fileName, int rows, int cols, int stride, const std::vector<std::uint64_t> &index, std::uint64_t byteCount) :
+	m_rowCount(rows),
+	m_colCount(cols),
+	m_stride(stride),
+	m_index(index)
+{
+	struct stat status;
+	if(stat(fileName.c_str(), &status) != 0 || static_cast<std::uint64_t>(status.st_size) < byteCount ||
+	   truncate(fileName.c_str(), static_cast<off_t>(byteCount)) != 0)
+	{
+		throw std::runtime_error("cannot resume trajectory " + fileName);
+	}
+
+	m_file.open(fileName, std::ios::in | std::ios::out | std::ios::binary);
+	writeHeader(0, 0);
+	m_file.seekp(static_cast<std::streamoff>(byteCount));
+}
+
+TrajectoryWriter::~TrajectoryWriter()
+{
+	close();
+}
+
+void TrajectoryWriter::writeHeader(std::uint64_t frameCount, std::uint64_t indexOffset)
+{
+	std::uint64_t frameBytes = (m_rowCount * m_colCount + 63) / 64 * 8;
+	std::uint64_t header[headerWords] = {magic, version, m_rowCount, m_colCount, frameBytes, m_stride, frameCount, indexOffset};
+
+	m_file.seekp(0);
+	m_file.write(reinterpret_cast<const char*>(header), sizeof(header));
+}
+
+void TrajectoryWriter::write(const VoterArray &lattice, std::uint64_t sweep)
+{
+	lattice.packOpinions(m_frame);
+	write(m_frame, sweep);
+}
+
+void TrajectoryWriter::write(const std::vector<std::uint64_t> &frame, std::uint64_t sweep)
+{
+	m_index.push_back(sweep);
+	m_index.push_back(static_cast<std::uint64_t>(m_file.tellp()));
+
+	m_file.write(reinterpret_cast<const char*>(frame.data()), frame.size() * sizeof(std::uint64_t));
+}
+
+void TrajectoryWriter::flush()
+{
+	m_file.flush();
+}
+
+std::uint64_t TrajectoryWriter::getByteCount()
+{
+	return static_cast<std::uint64_t>(m_file.tellp());
+}
+
+const std::vector<std::uint64_t>& TrajectoryWriter::getIndex() const
+{
+	return m_index;
+}
+
+void TrajectoryWriter::close()
+{
+	if(!m_file.is_open())
+	{
+		return;
+	}
+
+	// The index goes after the last frame and the header is completed to point at it.
+	std::uint64_t indexOffset = static_cast<std::uint64_t>(m_file.tellp());
+	m_file.write(reinterpret_cast<const char*>(m_index.data()), m_index.size() * sizeof(std::uint64_t));
+	writeHeader(m_index.size() / 2, indexOffset);
+
+	m_file.close();
+}
+
+TrajectoryReader::TrajectoryReader(const std::string &fileName) : m_data{nullptr}, m_size{0}
+{
+	int descriptor = open(fileName.c_str(), O_RDONLY);
+	if(descriptor < 0)
+	{
+		throw std::runtime_error("cannot open trajectory " + fileName);
+	}
+
+	struct stat status;
+	if(fstat(descriptor, &status) == 0 && static_cast<std::size_t>(status.st_size) >= headerWords * sizeof(std::uint64_t))
+	{
+		m_size = static_cast<std::size_t>(status.st_size);
+		void *mapping = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+		m_data = mapping == MAP_FAILED ? nullptr : static_cast<const unsigned char*>(mapping);
+	}
+	::close(descriptor);
+
+	if(!m_data)
+	{
+		throw std::runtime_error("cannot map trajectory " + fileName);
+	}
+
+	// The words are read in place, so a file from a host of the other byte order cannot be used.
+	m_header = reinterpret_cast<const std::uint64_t*>(m_data);
+	if(m_header[0] == __builtin_bswap64(TrajectoryWriter::magic))
+	{
+		munmap(const_cast<unsigned char*>(m_data), m_size);
+		throw std::runtime_error("trajectory " + fileName + " was written with the other byte order");
+	}
+	if(!isConsistent(m_data, m_size))
+	{
+		munmap(const_cast<unsigned char*>(m_data), m_size);
+		throw std::runtime_error("incomplete, unknown or corrupt trajectory " + fileName);
+	}
+
+	m_index = reinterpret_cast<const std::uint64_t*>(m_data + m_header[7]);
+}
+
+TrajectoryReader::~TrajectoryReader()
+{
+	munmap(const_cast<unsigned char*>(m_data), m_size);
+}
+
+int TrajectoryReader::getRows() const
+{
+	return static_cast<int>(m_header[2]);
+}
+
+int TrajectoryReader::getCols() const
+{
+	return static_cast<int>(m_header[3]);
+}
+
+std::uint64_t TrajectoryReader::getStride() const
+{
+	return m_header[5];
+}
+
+std::size_t TrajectoryReader::getFrameCount() const
+{
+	return static_cast<std::size_t>(m_header[6]);
+}
+
+std::uint64_t TrajectoryReader::getSweep(std::size_t frame) const
+{
+	return m_index[2 * frame];
+}
+
+const std::uint64_t* TrajectoryReader::getFrame(std::size_t frame) const
+{
+	return reinterpret_cast<const std::uint64_t*>(m_data + m_index[2 * frame + 1]);
+}
+
+int TrajectoryReader::getSymbol(std::size_t frame, int row, int col) const
+{
+	std::size_t bit = static_cast<std::size_t>(col) + static_cast<std::size_t>(row) * m_header[3];
+	bool democrat = (getFrame(frame)[bit >> 6] >> (bit & 63)) & 1u;
+	return democrat ? VoterArray::stateSymbols[VoterArray::Democrat] : VoterArray::stateSymbols[VoterArray::Republican];
+}
+
+void TrajectoryReader::printMatrix(std::ostream &out, std::size_t frame) const
+{
+	for(int row = 0; row < getRows(); ++row)
+	{
+		for(int col = 0; col < getCols(); ++col)
+		{
+			out << std::showpos << getSymbol(frame, row, col) << ' ';
+		}
+
+		out << '\n';
+	}
+}
@@ -0,0 +1,224 @@
+#ifndef Trajectory_hpp
+#define Trajectory_hpp
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <fstream>
+#include "VoterArray.hpp"
+
+/**
+ *\file
+ *\brief Binary trajectory files holding packed snapshots of a VoterArray.
+ *
+ * A trajectory file is laid out as follows, every field being a 64-bit unsigned integer in the byte
+ * order of the host that wrote it, so the frames can be mapped and read in place:
+ *
+ * - a header of 8 words: the magic number, the format version, the number of rows, the number of
+ *   columns, the number of bytes in a frame, the sweep stride between frames, the number of frames
+ *   and the byte offset of the index;
+ * - the frames, each the row-major packed opinions (a set bit is a democrat) padded to whole words,
+ *   see VoterArray::packOpinions();
+ * - the index, one pair of words per frame holding the number of sweeps done when the frame was taken
+ *   and the byte offset of the frame.
+ *
+ * The frame count and index offset are only filled in when the writer is closed, a reader treats a
+ * file with a zero index offset as incomplete. A file written on a host of the other byte order reads
+ * back with its magic number byte-swapped and is rejected.
+ */
+
+/**
+ *\class TrajectoryWriter
+ *\brief Appends frames of a VoterArray to a trajectory file.
+ */
+class TrajectoryWriter
+{
+private:
+	/// Output file.
+	std::ofstream m_file;
+
+	/// Number of rows in a frame.
+	std::uint64_t m_rowCount;
+
+	/// Number of columns in a frame.
+	std::uint64_t m_colCount;
+
+	/// Sweeps between frames.
+	std::uint64_t m_stride;
+
+	/// Sweep and byte offset of each frame written so far.
+	std::vector<std::uint64_t> m_index;
+
+	/// Scratch space for packing frames.
+	std::vector<std::uint64_t> m_frame;
+
+	/**
+	 *\brief Writes the header, with the index fields zero until the file is closed.
+	 *\param frameCount number of frames.
+	 *\param indexOffset byte offset of the index.
+	 */
+	void writeHeader(std::uint64_t frameCount, std::uint64_t indexOffset);
+
+public:
+	/// Magic number at the start of every trajectory file, "VOTERTRJ" on a little-endian host.
+	static const std::uint64_t magic = 0x4a52545245544f56ULL;
+
+	/// Version of the file format.
+	static const std::uint64_t version = 1;
+
+	/**
+	 *\brief Constructor that creates the file and writes the header.
+	 *\param fileName name of the trajectory file.
+	 *\param rows number of rows in the lattice.
+	 *\param cols number of columns in the lattice.
+	 *\param stride number of sweeps between frames, recorded in the header.
+	 */
+	TrajectoryWriter(const std::string &fileName, int rows, int cols, int stride);
+
+	/**
+	 *\brief Constructor that reopens a trajectory to carry on appending after a checkpoint.
+	 *
+	 * The file is cut back to the given size, which drops frames written after the checkpoint along
+	 * with any index, and the header is marked incomplete again. Throws std::runtime_error if the file
+	 * is shorter than the given size.
+	 *
+	 *\param fileName name of the trajectory file.
+	 *\param rows number of rows in the lattice.
+	 *\param cols number of columns in the lattice.
+	 *\param stride number of sweeps between frames, recorded in the header.
+	 *\param index index of the frames to keep, as returned by getIndex().
+	 *\param byteCount size of the file to keep, as returned by getByteCount().
+	 */
+	TrajectoryWriter(const std::string &fileName, int rows, int cols, int stride, const std::vector<std::uint64_t> &index, std::uint64_t byteCount);
+
+	/**
+	 *\brief Destructor that closes the file if that has not been done.
+	 */
+	~TrajectoryWriter();
+
+	/**
+	 *\brief Appends a frame of the lattice.
+	 *\param lattice VoterArray to take the frame of, its dimensions must match the file.
+	 *\param sweep number of sweeps done, recorded in the index.
+	 */
+	void write(const VoterArray &lattice, std::uint64_t sweep);
+
+	/**
+	 *\brief Appends an already packed frame.
+	 *\param frame packed opinions as produced by VoterArray::packOpinions().
+	 *\param sweep number of sweeps done, recorded in the index.
+	 */
+	void write(const std::vector<std::uint64_t> &frame, std::uint64_t sweep);
+
+	/**
+	 *\brief Flushes the frames written so far to the file.
+	 */
+	void flush();
+
+	/**
+	 *\brief Getter for the number of bytes written so far, the header and frames without the index.
+	 */
+	std::uint64_t getByteCount();
+
+	/**
+	 *\brief Getter for the index of the frames written so far.
+	 *\return sweep and byte offset of each frame.
+	 */
+	const std::vector<std::uint64_t>& getIndex() const;
+
+	/**
+	 *\brief Writes the index, completes the header and closes the file.
+	 */
+	void close();
+};
+
+/**
+ *\class TrajectoryReader
+ *\brief Memory maps a trajectory file so that any frame can be read without reading the others.
+ */
+class TrajectoryReader
+{
+private:
+	/// Start of the mapping.
+	const unsigned char *m_data;
+
+	/// Size of the mapping in bytes.
+	std::size_t m_size;
+
+	/// Header words.
+	const std::uint64_t *m_header;
+
+	/// Index words, two per frame.
+	const std::uint64_t *m_index;
+
+public:
+	/**
+	 *\brief Constructor that maps the file.
+	 *\param fileName name of the trajectory file.
+	 *
+	 * Throws std::runtime_error if the file cannot be mapped, was written with the other byte order
+	 * or is not a complete trajectory, or if the header or index point at frames that do not lie whole
+	 * inside the file.
+	 */
+	explicit TrajectoryReader(const std::string &fileName);
+
+	/**
+	 *\brief Destructor that unmaps the file.
+	 */
+	~TrajectoryReader();
+
+	TrajectoryReader(const TrajectoryReader&) = delete;
+	TrajectoryReader& operator=(const TrajectoryReader&) = delete;
+
+	/**
+	 *\brief Getter for the number of rows.
+	 */
+	int getRows() const;
+
+	/**
+	 *\brief Getter for the number of columns.
+	 */
+	int getCols() const;
+
+	/**
+	 *\brief Getter for the sweep stride between frames.
+	 */
+	std::uint64_t getStride() const;
+
+	/**
+	 *\brief Getter for the number of frames.
+	 */
+	std::size_t getFrameCount() const;
+
+	/**
+	 *\brief Getter for the number of sweeps done when a frame was taken.
+	 *\param frame index of the frame.
+	 */
+	std::uint64_t getSweep(std::size_t frame) const;
+
+	/**
+	 *\brief Getter for the packed opinions of a frame.
+	 *\param frame index of the frame.
+	 *\return pointer to the first word of the frame inside the mapping.
+	 */
+	const std::uint64_t* getFrame(std::size_t frame) const;
+
+	/**
+	 *\brief Getter for the voter value of a site in a frame.
+	 *\param frame index of the frame.
+	 *\param row row index of site.
+	 *\param col column index of site.
+	 *\return +1 for a republican and -1 for a democrat.
+	 */
+	int getSymbol(std::size_t frame, int row, int col) const;
+
+	/**
+	 *\brief Prints a frame in the matrix format of operator<<(std::ostream&, const VoterArray&).
+	 *\param out std::ostream reference that is being streamed to.
+	 *\param frame index of the frame.
+	 */
+	void printMatrix(std::ostream &out, std::size_t frame) const;
+};
+
+#endif /* Trajectory_hpp */
@@ -1,18 +1,46 @@
 #include "VoterArray.hpp"
+#include "synchronousRow.hpp" // For the row kernel of the synchronous sweep.
+#include <algorithm> // For std::min.
+#include <string> // For parsing layout names.
+#include <limits> // For the change no sweep can make.
 
 constexpr int VoterArray::stateSymbols[];
 
-VoterArray::State& VoterArray::operator()(int row, int col)
+namespace
 {
-    // Take into account periodic boundary conditions.
-    row = (row + m_rowCount) % m_rowCount;
-    col = (col + m_colCount) % m_colCount;
+    /**
+     *\brief Number of bits in a side of the Morton layout, padded to a power of two of at least 8.
+     */
+    int mortonBits(int length)
+    {
+        int bits = 3;
+        while((1LL << bits) < length)
+        {
+            ++bits;
+        }
+        return bits;
+    }
 
-    // Return 1D index of 1D array corresponding to the 2D index.
-    return m_boardData[col + row * m_colCount];
+    /**
+     *\brief Number of bits in the bitplanes of a lattice.
+     */
+    std::size_t planeBits(int rows, int cols, VoterArray::Layout layout)
+    {
+        switch(layout)
+        {
+            case VoterArray::Halo:
+                return (static_cast<std::size_t>(cols) + 2) * (rows + 2);
+            case VoterArray::Tiled:
+                return ((static_cast<std::size_t>(cols) + 7) & ~std::size_t(7)) * ((static_cast<std::size_t>(rows) + 7) & ~std::size_t(7));
+            case VoterArray::Morton:
+                return std::size_t(1) << (mortonBits(rows) + mortonBits(cols));
+            default:
+                return static_cast<std::size_t>(cols) * rows;
+        }
+    }
 }
 
-const VoterArray::State& VoterArray::operator()(int row, int col) const
+std::size_t VoterArray::index(int row, int col) const
 {
     // Take into account periodic boundary conditions we add extra m_rowCount and m_colCount
     // terms here to take into account the fact that the caller may be indexing with -1.
@@ -20,44 +48,341 @@ const VoterArray::State& VoterArray::operator()(int row, int col) const
     col = (col + m_colCount) % m_colCount;
 
     // Return 1D index of 1D array corresponding to the 2D index.
-    return m_boardData[col + row * m_colCount];
+    return site(row,col);
+}
+
+void VoterArray::mirror(int row, int col)
+{
+    if(m_layout != VoterArray::Halo)
+    {
+        return;
+    }
+
+    std::size_t site = m_origin + static_cast<std::size_t>(col) + static_cast<std::size_t>(row) * m_stride;
+    bool democrat = testBit(m_opinion,site);
+
+    // The ghost row below the lattice mirrors row 0 and the one above mirrors the last row.
+    if(row == 0)
+    {
+        assignBit(m_opinion, site + m_rowCount * m_stride, democrat);
+    }
+    if(row == m_rowCount - 1)
+    {
+        assignBit(m_opinion, site - m_rowCount * m_stride, democrat);
+    }
+
+    // Likewise for the ghost columns.
+    if(col == 0)
+    {
+        assignBit(m_opinion, site + m_colCount, democrat);
+    }
+    if(col == m_colCount - 1)
+    {
+        assignBit(m_opinion, site - m_colCount, democrat);
+    }
+}
+
+long long VoterArray::countBits(const Plane &plane, std::size_t begin, std::size_t length)
+{
+    long long count = 0;
+    std::size_t end = begin + length;
+
+    while(begin < end)
+    {
+        // Count up to the end of the current word or of the range, whichever comes first.
+        std::size_t offset = begin & 63;
+        std::size_t bits = std::min<std::size_t>(64 - offset, end - begin);
+        std::uint64_t word = plane[begin >> 6] >> offset;
+        if(bits < 64)
+        {
+            word &= (std::uint64_t(1) << bits) - 1;
+        }
+        count += __builtin_popcountll(word);
+        begin += bits;
+    }
+
+    return count;
+}
+
+std::uint64_t VoterArray::readBits(const Plane &plane, std::size_t begin, std::size_t length)
+{
+    std::size_t word = begin >> 6;
+    std::size_t offset = begin & 63;
+
+    std::uint64_t bits = plane[word] >> offset;
+    if(offset && offset + length > 64)
+    {
+        bits |= plane[word + 1] << (64 - offset);
+    }
+    return length < 64 ? bits & ((std::uint64_t(1) << length) - 1) : bits;
+}
+
+void VoterArray::writeBits(Plane &plane, std::size_t begin, std::size_t length, std::uint64_t bits)
+{
+    std::size_t word = begin >> 6;
+    std::size_t offset = begin & 63;
+    std::uint64_t mask = length < 64 ? (std::uint64_t(1) << length) - 1 : ~std::uint64_t(0);
+
+    plane[word] = (plane[word] & ~(mask << offset)) | ((bits & mask) << offset);
+    if(offset && offset + length > 64)
+    {
+        plane[word + 1] = (plane[word + 1] & ~(mask >> (64 - offset))) | ((bits & mask) >> (64 - offset));
+    }
+}
+
+void VoterArray::alignRows(const Plane &plane, std::uint64_t *rows) const
+{
+    // The rows of a Tiled or Morton lattice are spread over many words, gather them a site at a time.
+    if(m_layout == VoterArray::Tiled || m_layout == VoterArray::Morton)
+    {
+        std::size_t words = (static_cast<std::size_t>(m_colCount) + 63) / 64;
+        std::fill(rows, rows + words * m_rowCount, 0);
+        for(int row = 0; row < m_rowCount; ++row, rows += words)
+        {
+            for(int col = 0; col < m_colCount; ++col)
+            {
+                rows[col >> 6] |= std::uint64_t(testBit(plane, site(row,col))) << (col & 63);
+            }
+        }
+        return;
+    }
+
+    for(int row = 0; row < m_rowCount; ++row)
+    {
+        std::size_t begin = index(row,0);
+        for(int col = 0; col < m_colCount; col += 64)
+        {
+            *rows++ = readBits(plane, begin + col, std::min(64, m_colCount - col));
+        }
+    }
+}
+
+VoterArray::State VoterArray::operator()(int row, int col) const
+{
+    std::size_t bit = index(row,col);
+
+    // The opinion is bit 0 of the state and the stubborn flag is bit 1.
+    return static_cast<VoterArray::State>(testBit(m_opinion,bit) | (testBit(m_stubborn,bit) << 1));
+}
+
+void VoterArray::setState(int row, int col, VoterArray::State state)
+{
+    std::size_t bit = index(row,col);
+
+    // Only the difference in voter value changes the running sum.
+    m_magnetization += stateSymbols[state] - stateSymbols[(*this)(row,col)];
+
+    // A change of stubbornness invalidates the list of mobile sites, and so does a stubborn voter
+    // changing its mind since the frozen bonds are kept with the list.
+    bool stubborn = state & 2;
+    bool democrat = state & 1;
+    bool flipped = democrat != testBit(m_opinion, bit);
+    if(stubborn != testBit(m_stubborn, bit))
+    {
+        m_stubbornCount += stubborn ? 1 : -1;
+        m_mobileStale = true;
+    }
+    else if(stubborn && flipped)
+    {
+        m_mobileStale = true;
+    }
+
+    assignBit(m_opinion, bit, democrat);
+    assignBit(m_stubborn, bit, state & 2);
+
+    row = (row + m_rowCount) % m_rowCount;
+    col = (col + m_colCount) % m_colCount;
+    mirror(row, col);
+
+    // Only the bonds of the site can have changed.
+    if(flipped)
+    {
+        m_activeBonds += bondChange(row, col, bit, democrat);
+    }
+}
+
+long long VoterArray::computeMagnetization() const
+{
+    long long democrats = 0;
+    if(m_layout != VoterArray::Halo)
+    {
+      // Padding bits past the last site or outside the lattice are always clear so they do not contribute.
+      for(auto const& word : m_opinion)
+      {
+        democrats += __builtin_popcountll(word);
+      }
+    }
+    else
+    {
+      // Count each row separately to leave out the ghost sites.
+      for(int row = 0; row < m_rowCount; ++row)
+      {
+        democrats += countBits(m_opinion, index(row,0), m_colCount);
+      }
+    }
+    return static_cast<long long>(m_rowCount)*m_colCount - 2 * democrats;
+}
+
+long long VoterArray::computeActiveBonds() const
+{
+    std::vector<std::uint64_t> rows(((static_cast<std::size_t>(m_colCount) + 63) / 64) * m_rowCount);
+    alignRows(m_opinion, rows.data());
+    return countActiveBonds(rows.data());
+}
+
+long long VoterArray::countActiveBonds(const std::uint64_t *rows, const std::uint64_t *stubbornRows) const
+{
+    std::size_t words = (static_cast<std::size_t>(m_colCount) + 63) / 64;
+    int lastCol = m_colCount - 1;
+
+    // Sites to the right of (or below) a site, the carry from the next word supplying the last bit.
+    auto right = [words](const std::uint64_t *row, std::size_t w)
+    {
+        return (row[w] >> 1) | (w + 1 < words ? row[w + 1] << 63 : 0);
+    };
+    auto bit = [](const std::uint64_t *row, int col)
+    {
+        return (row[col >> 6] >> (col & 63)) & 1;
+    };
+
+    long long count = 0;
+    for(int row = 0; row < m_rowCount; ++row)
+    {
+        std::size_t below = static_cast<std::size_t>(row + 1 == m_rowCount ? 0 : row + 1) * words;
+        const std::uint64_t *centre = rows + row * words;
+        const std::uint64_t *down = rows + below;
+        for(std::size_t w = 0; w < words; ++w)
+        {
+            std::uint64_t horizontal = centre[w] ^ right(centre, w);
+            std::uint64_t vertical = centre[w] ^ down[w];
+            if(stubbornRows)
+            {
+                const std::uint64_t *stubborn = stubbornRows + row * words;
+                horizontal &= stubborn[w] & right(stubborn, w);
+                vertical &= stubborn[w] & stubbornRows[below + w];
+            }
+            if(w + 1 == words)
+            {
+                // Leave out the last column, its right neighbour is across the boundary.
+                horizontal &= lastCol % 64 ? (std::uint64_t(1) << (lastCol % 64)) - 1 : 0;
+            }
+            count += __builtin_popcountll(horizontal) + __builtin_popcountll(vertical);
+        }
+
+        // The bond across the periodic boundary.
+        bool both = !stubbornRows || (bit(stubbornRows + row * words, 0) && bit(stubbornRows + row * words, lastCol));
+        count += both && bit(centre, 0) != bit(centre, lastCol);
+    }
+
+    return count;
 }
 
 
 VoterArray::VoterArray(
-	std::default_random_engine &generator,
+	RandomEngine &generator,
 	int rows,
 	int cols,
-	double initialOrder
+	double initialOrder,
+	Layout layout
 	) : m_rowCount{rows},
 		m_colCount{cols},
-    m_boardData(rows*cols,VoterArray::Democrat)
+    m_layout{layout},
+    m_stride{layout == VoterArray::Halo ? static_cast<std::size_t>(cols) + 2 : static_cast<std::size_t>(cols)},
+    m_origin{layout == VoterArray::Halo ? m_stride + 1 : 0},
+    m_tileColumns{(static_cast<std::size_t>(cols) + 7) / 8},
+    m_mortonBits{std::min(mortonBits(rows), mortonBits(cols))},
+    m_mortonMask{0, 0},
+    m_neighbourOffset{1, static_cast<std::ptrdiff_t>(m_stride), -1, -static_cast<std::ptrdiff_t>(m_stride)},
+    m_magnetization{-static_cast<long long>(rows)*cols},
+    m_activeBonds{0},
+    m_stubbornCount{0},
+    m_mobileStale{false},
+    m_frozenBonds{0},
+    m_freezingUpdate{0},
+    m_sweepUpdates{0}
 {
+  // The interleaved bits alternate column and row, the longer side has every bit above them.
+  if(m_layout == VoterArray::Morton)
+  {
+    int totalBits = mortonBits(rows) + mortonBits(cols);
+    std::uint64_t high = ((std::uint64_t(1) << totalBits) - 1) & ~((std::uint64_t(1) << (2 * m_mortonBits)) - 1);
+    m_mortonMask[0] = spreadBits((std::uint64_t(1) << m_mortonBits) - 1) | (mortonBits(cols) > m_mortonBits ? high : 0);
+    m_mortonMask[1] = (spreadBits((std::uint64_t(1) << m_mortonBits) - 1) << 1) | (mortonBits(rows) > m_mortonBits ? high : 0);
+  }
+
+  // Every voter starts as a democrat, clear the padding bits past the last site. The padding of a
+  // Tiled or Morton lattice is spread through it so its sites are set one at a time instead.
+  // Resizing leaves the planes untouched so that the first write can be shared by the threads.
+  std::size_t siteCount = static_cast<std::size_t>(rows)*cols;
+  std::size_t bitCount = planeBits(rows, cols, layout);
+  bool spreadPadding = m_layout == VoterArray::Tiled || m_layout == VoterArray::Morton;
+  m_opinion.resize((bitCount + 63) / 64);
+  m_stubborn.resize(m_opinion.size());
+  LatticeMemory::fill(m_opinion.data(), m_opinion.size(), spreadPadding ? 0 : ~std::uint64_t(0));
+  LatticeMemory::fill(m_stubborn.data(), m_stubborn.size(), 0);
+  if(spreadPadding)
+  {
+    for(int row = 0; row < rows; ++row)
+    {
+      for(int col = 0; col < cols; ++col)
+      {
+        assignBit(m_opinion, site(row,col), true);
+      }
+    }
+  }
+  else if(bitCount % 64)
+  {
+    m_opinion.back() = (std::uint64_t(1) << (bitCount % 64)) - 1;
+  }
+
   // Map the order parameter onto the interval [0:1].
   initialOrder = (initialOrder+1.0)/2.0;
 
   // Calculate the required number of republican voters.
-  int republicanNumber = std::round(initialOrder*(rows*cols));
+  std::size_t republicanNumber = static_cast<std::size_t>(std::round(initialOrder*siteCount));
 
 
 
-  // Create a distribution for the lattice sites.
-  std::uniform_int_distribution<int> latticeDistribution(0,(rows*cols)-1);
-
   // Choose the correct number of sites and convert them from democrat to republican.
-  int i = 0;
+  std::size_t i = 0;
   while(i < republicanNumber)
   {
     // Generate index for site.
-    int site = latticeDistribution(generator);
-    if(m_boardData[site] != VoterArray::Republican)
+    std::uint64_t word = generator();
+    std::size_t site = takeBounded(word, siteCount);
+    if(m_layout != VoterArray::RowMajor)
     {
-      m_boardData[latticeDistribution(generator)] = VoterArray::Republican;
+      site = index(static_cast<int>(site / cols), static_cast<int>(site % cols));
+    }
+
+    if(testBit(m_opinion,site))
+    {
+      assignBit(m_opinion,site,false);
       ++i;
     }
   }
 
+  // Bring the ghost sites in line with the edges.
+  if(m_layout == VoterArray::Halo)
+  {
+    for(int row = 0; row < rows; ++row)
+    {
+      mirror(row, 0);
+      mirror(row, cols - 1);
+    }
+    for(int col = 0; col < cols; ++col)
+    {
+      mirror(0, col);
+      mirror(rows - 1, col);
+    }
+  }
 
+  // Every conversion took a democrat to a republican so the running sum can be corrected in one go.
+  m_magnetization += 2LL * static_cast<long long>(republicanNumber);
+  assert(m_magnetization == computeMagnetization());
+
+  // The bonds are counted once, from then on every change of state keeps the count up to date.
+  m_activeBonds = computeActiveBonds();
 }
 
 
@@ -72,78 +397,465 @@ int VoterArray::getCols() const
     return m_colCount;
 }
 
-int VoterArray::getSize() const
+std::size_t VoterArray::getSize() const
 {
-    return m_colCount * m_rowCount;
+    return static_cast<std::size_t>(m_rowCount) * m_colCount;
 }
 
+VoterArray::Layout VoterArray::getLayout() const
+{
+    return m_layout;
+}
 
-VoterArray::State VoterArray::update(std::default_random_engine& generator)
+bool VoterArray::separatesWords(int row) const
 {
-	// Create a uniform distribution for the rows and columns remembering to subtract 1 for the closed limits.
-	std::uniform_int_distribution<int> rowDistribution(0,m_rowCount-1);
-	std::uniform_int_distribution<int> colDistribution(0,m_colCount-1);
+    switch(m_layout)
+    {
+        case VoterArray::Tiled:
+            return row % 8 == 0;
+        case VoterArray::Morton:
+        {
+            // A word is 8x8 sites, or when the short side has fewer than 8 its full width and the rest in rows.
+            int rowsPerWord = m_mortonBits >= 3 ? 8 : 1 << (6 - m_mortonBits);
+            return row % rowsPerWord == 0;
+        }
+        case VoterArray::Halo:
+            return (static_cast<std::size_t>(row) + 1) * m_stride % 64 == 0;
+        default:
+            return static_cast<std::size_t>(row) * m_colCount % 64 == 0;
+    }
+}
 
-  int row = rowDistribution(generator);
-  int col = colDistribution(generator);
+std::size_t VoterArray::getStubbornCount() const
+{
+    return m_stubbornCount;
+}
+
+const UpdateCounters& VoterArray::getCounters() const
+{
+    return m_counters;
+}
+
+const std::vector<std::size_t>& VoterArray::mobileSites()
+{
+    if(m_mobileStale)
+    {
+        m_mobile.clear();
+        if(m_stubbornCount)
+        {
+            m_mobile.reserve(static_cast<std::size_t>(m_rowCount) * m_colCount - m_stubbornCount);
+            for(int row = 0; row < m_rowCount; ++row)
+            {
+                for(int col = 0; col < m_colCount; ++col)
+                {
+                    if(!testBit(m_stubborn, index(row,col)))
+                    {
+                        m_mobile.push_back(static_cast<std::size_t>(col) + static_cast<std::size_t>(row) * m_colCount);
+                    }
+                }
+            }
+
+            // The stubborn voters keep their opinions so the bonds between them are counted once.
+            std::size_t words = ((static_cast<std::size_t>(m_colCount) + 63) / 64) * m_rowCount;
+            std::vector<std::uint64_t> rows(words);
+            std::vector<std::uint64_t> stubbornRows(words);
+            alignRows(m_opinion, rows.data());
+            alignRows(m_stubborn, stubbornRows.data());
+            m_frozenBonds = countActiveBonds(rows.data(), stubbornRows.data());
+        }
+        else
+        {
+            // Every site is mobile again, give the memory back.
+            std::vector<std::size_t>().swap(m_mobile);
+            m_frozenBonds = 0;
+        }
+        m_mobileStale = false;
+    }
 
+    return m_mobile;
+}
 
+long long VoterArray::frozenBonds()
+{
+    if(!m_stubbornCount)
+    {
+        return 0;
+    }
+    mobileSites();
+    return m_frozenBonds;
+}
 
-  // Check to see if the selected voter is of the stubborn type and id so return early.
-  if((*this)(row,col) == VoterArray::DemocratStubborn ||  (*this)(row,col) == VoterArray::RepublicanStubborn)
+bool VoterArray::frozen()
+{
+    return m_activeBonds == frozenBonds();
+}
+
+long long VoterArray::freezingChange()
+{
+    // The active bond count can never drop below the frozen bonds, so a frozen lattice stays at a change of 0.
+    long long change = frozenBonds() - m_activeBonds;
+    return change ? change : std::numeric_limits<long long>::min();
+}
+
+double VoterArray::freezingFraction() const
+{
+    return m_freezingUpdate ? static_cast<double>(m_freezingUpdate) / m_sweepUpdates : 1;
+}
+
+void VoterArray::packPlane(const Plane &plane, std::vector<std::uint64_t> &frame) const
+{
+    // A row-major bitplane already is a frame.
+    if(m_layout == VoterArray::RowMajor)
+    {
+        frame.assign(plane.begin(), plane.end());
+        return;
+    }
+
+    std::size_t siteCount = static_cast<std::size_t>(m_rowCount) * m_colCount;
+    frame.assign((siteCount + 63) / 64, 0);
+
+    std::size_t bit = 0;
+    for(int row = 0; row < m_rowCount; ++row)
+    {
+        for(int col = 0; col < m_colCount; ++col, ++bit)
+        {
+            if(testBit(plane, index(row,col)))
+            {
+                frame[bit >> 6] |= std::uint64_t(1) << (bit & 63);
+            }
+        }
+    }
+}
+
+void VoterArray::packOpinions(std::vector<std::uint64_t> &frame) const
+{
+    packPlane(m_opinion, frame);
+}
+
+void VoterArray::packStubborn(std::vector<std::uint64_t> &frame) const
+{
+    packPlane(m_stubborn, frame);
+}
+
+void VoterArray::unpackStates(const std::vector<std::uint64_t> &opinions, const std::vector<std::uint64_t> &stubborn)
+{
+    std::size_t bit = 0;
+    for(int row = 0; row < m_rowCount; ++row)
+    {
+        for(int col = 0; col < m_colCount; ++col, ++bit)
+        {
+            // setState() keeps the running magnetization and the ghost sites up to date.
+            int state = testBit(opinions, bit) | (testBit(stubborn, bit) << 1);
+            setState(row, col, static_cast<VoterArray::State>(state));
+        }
+    }
+    assert(m_magnetization == computeMagnetization());
+    assert(m_activeBonds == computeActiveBonds());
+}
+
+
+VoterArray::State VoterArray::update(RandomEngine& generator)
+{
+  // A single random word supplies the site and the neighbour to copy.
+  std::uint64_t word = generator();
+  int row;
+  int col;
+  if(m_stubbornCount)
   {
-    return (*this)(row,col);
+    const std::vector<std::size_t> &mobile = mobileSites();
+    if(mobile.empty())
+    {
+      return (*this)(0,0);
+    }
+    std::size_t site = mobile[takeBounded(word, mobile.size())];
+    row = static_cast<int>(site / m_colCount);
+    col = static_cast<int>(site % m_colCount);
   }
   else
   {
-    // pick a random nearest neighbour and update the state of the original cell to be this state.
-    std::uniform_int_distribution<int> neighbourDistribution(0,3);
+    row = static_cast<int>(takeBounded(word, m_rowCount));
+    col = static_cast<int>(takeBounded(word, m_colCount));
+  }
+  int direction = static_cast<int>(takeBounded(word, 4));
+
+  Delta delta;
+  VoterArray::State state = updateSite(row,col,direction,delta);
+  applyDelta(delta);
+
+  return state;
+}
+
+void VoterArray::sweep(RandomEngine& generator)
+{
+  // Size of the blocks of random words generated at once.
+  const std::size_t blockSize = 1024;
+  std::uint64_t words[blockSize];
 
-    int neighbourRow = row;
-    int neighbourCol = col;
+  // The update that brings the active bonds down to the frozen ones gives the time the lattice froze.
+  long long freezing = freezingChange();
+  m_freezingUpdate = 0;
 
-    switch (neighbourDistribution(generator))
+  Delta delta;
+  if(m_stubbornCount)
+  {
+    // One update per mobile site, drawn from the mobile sites only.
+    const std::vector<std::size_t> &mobile = mobileSites();
+    m_sweepUpdates = mobile.size();
+    std::size_t remaining = mobile.size();
+    while(remaining)
     {
-      case 0:
-        neighbourCol++;
-        break;
+      std::size_t count = remaining < blockSize ? remaining : blockSize;
+      generator.fill(words, count);
+
+      for(std::size_t i = 0; i < count; ++i)
+      {
+        std::uint64_t word = words[i];
+        std::size_t site = mobile[takeBounded(word, mobile.size())];
+        int row = static_cast<int>(site / m_colCount);
+        int col = static_cast<int>(site % m_colCount);
+        updateSite(row, col, static_cast<int>(takeBounded(word, 4)), delta);
+        if(delta.activeBonds == freezing && !m_freezingUpdate)
+        {
+          m_freezingUpdate = mobile.size() - remaining + i + 1;
+        }
+      }
 
-      case 1:
-        neighbourRow++;
-        break;
+      remaining -= count;
+    }
+    applyDelta(delta);
+    return;
+  }
 
-      case 2:
-        neighbourCol--;
-        break;
+  std::size_t siteCount = static_cast<std::size_t>(m_rowCount) * m_colCount;
+  m_sweepUpdates = siteCount;
+  std::size_t remaining = siteCount;
+  while(remaining)
+  {
+    std::size_t count = remaining < blockSize ? remaining : blockSize;
+    generator.fill(words, count);
 
-      case 3:
-        neighbourRow--;
-        break;
+    for(std::size_t i = 0; i < count; ++i)
+    {
+      std::uint64_t word = words[i];
+      int row = static_cast<int>(takeBounded(word, m_rowCount));
+      int col = static_cast<int>(takeBounded(word, m_colCount));
+      updateSite(row, col, static_cast<int>(takeBounded(word, 4)), delta);
+      if(delta.activeBonds == freezing && !m_freezingUpdate)
+      {
+        m_freezingUpdate = siteCount - remaining + i + 1;
+      }
     }
 
-    if((*this)(neighbourRow,neighbourCol) == VoterArray::Republican
-    || (*this)(neighbourRow,neighbourCol) == VoterArray::RepublicanStubborn)
+    remaining -= count;
+  }
+  applyDelta(delta);
+}
+
+void VoterArray::synchronousSweep(RandomEngine& generator)
+{
+  std::size_t words = (static_cast<std::size_t>(m_colCount) + 63) / 64;
+  std::size_t rowWords = words * m_rowCount;
+
+  // The guard words either side of the current rows let the kernel read one word past each row.
+  m_current.assign(rowWords + 2, 0);
+  m_next.resize(rowWords);
+  m_rowStubborn.assign(rowWords, 0);
+  alignRows(m_opinion, m_current.data() + 1);
+  if(m_stubbornCount)
+  {
+    alignRows(m_stubborn, m_rowStubborn.data());
+  }
+
+  std::vector<std::uint64_t> random(2 * words);
+  const std::uint64_t *current = m_current.data() + 1;
+  int lastCol = m_colCount - 1;
+  std::uint64_t lastMask = m_colCount % 64 ? (std::uint64_t(1) << (m_colCount % 64)) - 1 : ~std::uint64_t(0);
+
+  long long democrats = 0;
+  for(int row = 0; row < m_rowCount; ++row)
+  {
+    const std::uint64_t *centre = current + row * words;
+    const std::uint64_t *up = current + (row ? row - 1 : m_rowCount - 1) * words;
+    const std::uint64_t *down = current + (row + 1 == m_rowCount ? 0 : row + 1) * words;
+    const std::uint64_t *stubborn = m_rowStubborn.data() + row * words;
+    std::uint64_t *next = m_next.data() + row * words;
+
+    generator.fill(random.data(), random.size());
+    const std::uint64_t *high = random.data();
+    const std::uint64_t *low = random.data() + words;
+    synchronousRow(centre, up, down, stubborn, high, low, next, words);
+
+    // The kernel took the bits beyond the row for the first site's left and the last site's right
+    // neighbours, put in the sites across the periodic boundary instead.
+    std::uint64_t firstBit = centre[0] & 1;
+    std::uint64_t lastBit = (centre[lastCol >> 6] >> (lastCol & 63)) & 1;
+    if((high[0] & 1) && !(low[0] & 1) && !(stubborn[0] & 1))
     {
-      (*this)(row,col) = VoterArray::Republican;
+      next[0] = (next[0] & ~std::uint64_t(1)) | lastBit;
     }
-    else
+    std::uint64_t lastSite = std::uint64_t(1) << (lastCol & 63);
+    std::size_t lastWord = lastCol >> 6;
+    if(!(high[lastWord] & lastSite) && !(low[lastWord] & lastSite) && !(stubborn[lastWord] & lastSite))
     {
-      (*this)(row,col) = VoterArray::Democrat;
+      next[lastWord] = (next[lastWord] & ~lastSite) | (firstBit << (lastCol & 63));
     }
+    next[words - 1] &= lastMask;
 
-    return (*this)(row,col);
+    for(std::size_t w = 0; w < words; ++w)
+    {
+      democrats += __builtin_popcountll(next[w]);
+    }
+    if(instrumented)
+    {
+      for(std::size_t w = 0; w < words; ++w)
+      {
+        m_counters.flips += __builtin_popcountll(next[w] ^ centre[w]);
+      }
+    }
+  }
+
+  // Every site is updated, the stubborn ones to their own opinion.
+  if(instrumented)
+  {
+    m_counters.attempts += static_cast<unsigned long long>(m_rowCount) * m_colCount;
+    m_counters.stubbornHits += m_stubbornCount;
+  }
+
+  // Write the new configuration back, bringing the ghost sites in line with the edges.
+  for(int row = 0; row < m_rowCount; ++row)
+  {
+    const std::uint64_t *next = m_next.data() + row * words;
+    if(m_layout == VoterArray::Tiled || m_layout == VoterArray::Morton)
+    {
+      for(int col = 0; col < m_colCount; ++col)
+      {
+        assignBit(m_opinion, site(row,col), (next[col >> 6] >> (col & 63)) & 1);
+      }
+      continue;
+    }
+
+    std::size_t begin = index(row,0);
+    for(int col = 0; col < m_colCount; col += 64)
+    {
+      writeBits(m_opinion, begin + col, std::min(64, m_colCount - col), next[col >> 6]);
+    }
+  }
+  if(m_layout == VoterArray::Halo)
+  {
+    for(int row = 0; row < m_rowCount; ++row)
+    {
+      mirror(row, 0);
+      mirror(row, m_colCount - 1);
+    }
+    for(int col = 0; col < m_colCount; ++col)
+    {
+      mirror(0, col);
+      mirror(m_rowCount - 1, col);
+    }
   }
 
+  m_magnetization = static_cast<long long>(m_rowCount) * m_colCount - 2 * democrats;
+  assert(m_magnetization == computeMagnetization());
+
+  // Every site may have changed so the bonds are recounted, a word at a time as the sweep itself.
+  m_activeBonds = countActiveBonds(m_next.data());
 }
 
-double VoterArray::orderParameter() const
+VoterArray::State VoterArray::updateSite(int row, int col, int direction, Delta &delta)
 {
-  double sum = 0;
-    for(auto const& voter : m_boardData)
+  std::size_t site = this->site(row,col);
+
+  // Check to see if the selected voter is of the stubborn type and id so return early.
+  if(testBit(m_stubborn,site))
+  {
+    if(instrumented)
     {
-      sum += static_cast<int>(stateSymbols[voter]);
+      ++delta.counters.attempts;
+      ++delta.counters.stubbornHits;
     }
-  return sum/(m_rowCount*m_colCount);
+    return (*this)(row,col);
+  }
+
+  // With ghost sites around the lattice every neighbour is a fixed offset away.
+  if(m_layout == VoterArray::Halo)
+  {
+    bool democrat = copyOpinion(row,col,site,site + m_neighbourOffset[direction],delta);
+    mirror(row,col);
+
+    return democrat ? VoterArray::Democrat : VoterArray::Republican;
+  }
+
+  if(m_layout == VoterArray::Morton)
+  {
+    bool democrat = copyOpinion(row,col,site,mortonNeighbour(row,col,site,direction),delta);
+
+    return democrat ? VoterArray::Democrat : VoterArray::Republican;
+  }
+
+  // The Tiled neighbours are cheap to index directly once the step is wrapped without a division.
+  if(m_layout == VoterArray::Tiled)
+  {
+    bool democrat = copyOpinion(row,col,site,neighbour(row,col,site,direction),delta);
+
+    return democrat ? VoterArray::Democrat : VoterArray::Republican;
+  }
+
+  int neighbourRow = row;
+  int neighbourCol = col;
+
+  switch (direction)
+  {
+    case 0:
+      neighbourCol++;
+      break;
+
+    case 1:
+      neighbourRow++;
+      break;
+
+    case 2:
+      neighbourCol--;
+      break;
+
+    case 3:
+      neighbourRow--;
+      break;
+  }
+
+  // Copy the opinion bit of the neighbour, stubborn or not.
+  bool democrat = copyOpinion(row,col,site,index(neighbourRow,neighbourCol),delta);
+
+  return democrat ? VoterArray::Democrat : VoterArray::Republican;
+}
+
+void VoterArray::applyDelta(const Delta &delta)
+{
+  m_magnetization += delta.magnetization;
+  m_activeBonds += delta.activeBonds;
+  if(instrumented)
+  {
+    m_counters += delta.counters;
+  }
+}
+
+double VoterArray::orderParameter() const
+{
+  return static_cast<double>(magnetization())/getSize();
+}
+
+long long VoterArray::magnetization() const
+{
+  // Debug builds compare the running sum against a full pass over the lattice.
+  assert(m_magnetization == computeMagnetization());
+
+  return m_magnetization;
+}
+
+double VoterArray::activeBondDensity() const
+{
+  assert(m_activeBonds == computeActiveBonds());
+
+  return static_cast<double>(m_activeBonds)/(2.0*getSize());
 }
 
 
@@ -166,3 +878,48 @@ std::ostream& operator<<(std::ostream& out, const VoterArray &board)
 
     return out;
 }
+
+std::ostream& operator<<(std::ostream& out, VoterArray::Layout layout)
+{
+    switch(layout)
+    {
+        case VoterArray::RowMajor:
+            return out << "row-major";
+        case VoterArray::Halo:
+            return out << "halo";
+        case VoterArray::Tiled:
+            return out << "tiled";
+        case VoterArray::Morton:
+            return out << "morton";
+    }
+    return out;
+}
+
+std::istream& operator>>(std::istream& in, VoterArray::Layout &layout)
+{
+    std::string name;
+    in >> name;
+
+    if(name == "row-major")
+    {
+        layout = VoterArray::RowMajor;
+    }
+    else if(name == "halo")
+    {
+        layout = VoterArray::Halo;
+    }
+    else if(name == "tiled")
+    {
+        layout = VoterArray::Tiled;
+    }
+    else if(name == "morton")
+    {
+        layout = VoterArray::Morton;
+    }
+    else
+    {
+        in.setstate(std::ios::failbit);
+    }
+
+    return in;
+}
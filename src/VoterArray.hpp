@@ -2,10 +2,15 @@
 #define VoterArray_hpp
 
 #include <vector> // For holding the data in the array.
-#include <random> // For generating random numbers.
+#include "RandomEngine.hpp" // For generating random numbers.
 #include <iostream> // For outputting board.
 #include <utility> // For std::pair.
 #include <cmath> // For round.
+#include <cassert> // For debug consistency checks.
+#include <cstdint> // For fixed width words in the bitplanes.
+#include <cstddef> // For std::size_t.
+#include "Instrumentation.hpp" // For counting what the updates do.
+#include "LatticeMemory.hpp" // For the bitplanes of large lattices.
 
 /**
  * \file
@@ -18,6 +23,9 @@ public:
     /**
      * \enum State
      * \brief Enumeration type to hold the state of the cell, dead or alive.
+     *
+     * The values are chosen so that bit 0 is the opinion (set for a democrat) and bit 1 is the
+     * stubborn flag, which is exactly how a site is stored in the bitplanes.
      */
     enum State
     {
@@ -31,41 +39,460 @@ public:
     /// Look-up table for voter values.
     static constexpr int stateSymbols[MAXSTATE] = {+1,-1,+1,-1};
 
-private:
+    /**
+     * \enum Layout
+     * \brief How the sites are laid out in the bitplanes.
+     *
+     * RowMajor packs the sites with no gaps and applies the periodic boundaries with % on every
+     * neighbour lookup. Halo surrounds the lattice with ghost rows and columns that mirror the opposite
+     * edge, so a neighbour is always a fixed offset away and the lookup is a single indexed load; the
+     * price is refreshing a ghost whenever an edge site is written.
+     *
+     * The last two are for lattices whose rows no longer fit in cache, where a vertical neighbour a whole
+     * row away costs a cache miss and often a TLB miss of its own. Tiled stores each 8x8 block of sites
+     * in one 64-bit word, bit (row%8)*8 + col%8, with the blocks in row-major order, so 7 in 8 vertical
+     * neighbours share the word; the dimensions are padded to multiples of 8. Morton numbers the sites
+     * along a Z-order curve, interleaving the bits of the row and column, which also puts an 8x8 block in
+     * each word and keeps nearby blocks close in memory at every scale; the dimensions are padded to
+     * powers of two of at least 8.
+     */
+    enum Layout
+    {
+        RowMajor,
+        Halo,
+        Tiled,
+        Morton,
+    };
+
+    /**
+     *\struct Delta
+     *\brief Changes to the tracked observables made by a run of site updates.
+     *
+     * Updates made through updateSite() record their changes here instead of in the lattice so that
+     * several threads can update disjoint parts of the lattice and merge their changes afterwards.
+     */
+    struct Delta
+    {
+        /// Change in the sum of the voter values.
+        long long magnetization = 0;
+
+        /// Change in the number of bonds joining opposite opinions.
+        long long activeBonds = 0;
+
+        /// What the updates did, only counted with -DVOTER_INSTRUMENTATION.
+        UpdateCounters counters;
+    };
+
+protected:
+    /// A bitplane, in huge pages once it is large, see LatticeMemory.
+    typedef std::vector<std::uint64_t, LatticeAllocator<std::uint64_t> > Plane;
+
     /// Member variable that holds number of rows in lattice.
     int m_rowCount;
 
     /// Member variable that holds number of columns in lattice.
     int m_colCount;
 
-    /// Member variable that holds the actual data in the lattice.
-    std::vector<State> m_boardData;
+    /// Layout of the sites in the bitplanes.
+    Layout m_layout;
+
+    /// Distance in bits between vertically adjacent sites.
+    std::size_t m_stride;
+
+    /// Bit index of site (0,0).
+    std::size_t m_origin;
+
+    /// Number of 8x8 blocks in a row of blocks in the Tiled layout.
+    std::size_t m_tileColumns;
+
+    /// Number of low bits of the row and column that are interleaved in the Morton layout.
+    int m_mortonBits;
+
+    /// Bits of a Morton index that hold the column and the row, for stepping between neighbours.
+    std::uint64_t m_mortonMask[2];
+
+    /// Bit offsets of the neighbours right, down, left and up, only valid in the Halo layout.
+    std::ptrdiff_t m_neighbourOffset[4];
+
+    /// Opinion bitplane, one bit per site, a set bit is a democrat.
+    Plane m_opinion;
+
+    /// Stubborn bitplane, one bit per site, a set bit is a stubborn voter.
+    Plane m_stubborn;
+
+    /// Running sum of the voter values (stateSymbols) over the whole lattice.
+    long long m_magnetization;
+
+    /// Running count of the nearest neighbour bonds joining opposite opinions, out of 2 * rows * cols.
+    long long m_activeBonds;
+
+    /// Number of stubborn voters.
+    std::size_t m_stubbornCount;
+
+    /// Running counts of what the updates did, only kept with -DVOTER_INSTRUMENTATION.
+    UpdateCounters m_counters;
+
+    /// Row-major numbers (col + row * cols) of the non-stubborn sites in increasing order, see mobileSites().
+    std::vector<std::size_t> m_mobile;
+
+    /// Set when the stubborn flags have changed since m_mobile was built.
+    bool m_mobileStale;
+
+    /// Active bonds between two stubborn voters, built with m_mobile, see frozenBonds().
+    long long m_frozenBonds;
+
+    /// Update of the last sweep() that left the lattice frozen, counted from 1, 0 if none did.
+    std::size_t m_freezingUpdate;
+
+    /// Number of updates in the last sweep().
+    std::size_t m_sweepUpdates;
+
+    /// Opinions read by synchronousSweep(), rows padded to whole words with a guard word at either end.
+    std::vector<std::uint64_t> m_current;
+
+    /// Opinions written by synchronousSweep(), laid out as m_current without the guard words.
+    std::vector<std::uint64_t> m_next;
+
+    /// Stubborn flags for synchronousSweep(), laid out as m_next.
+    std::vector<std::uint64_t> m_rowStubborn;
+
+    /**
+     *\brief Change in the active bonds over a sweep that leaves the lattice frozen(), see freezingFraction().
+     *\return frozenBonds() less the active bonds, or a change no sweep can make if the lattice is already frozen.
+     */
+    long long freezingChange();
+
+    /**
+     *\brief Sums the voter values of every site in the lattice.
+     *
+     * This is the full recomputation that the running sum m_magnetization replaces, it popcounts
+     * the opinion bitplane and is used to initialise the running sum and to check it in debug builds.
+     *
+     *\return the sum of the voter values over the lattice.
+     */
+    long long computeMagnetization() const;
+
+    /**
+     *\brief Counts the bonds joining opposite opinions in the whole lattice.
+     *
+     * The full recomputation that the running count m_activeBonds replaces, a word at a time on the
+     * opinions gathered into rows. Each site contributes the bonds to its right and lower neighbours.
+     *
+     *\return the number of active bonds.
+     */
+    long long computeActiveBonds() const;
+
+    /**
+     *\brief Counts the bonds joining opposite opinions in rows padded to whole words, see alignRows().
+     *\param rows the opinions, (cols + 63)/64 words per row with the bits past the last column clear.
+     *\param stubbornRows the stubborn flags laid out as the rows, to count only the bonds between two
+     * stubborn voters, or nullptr to count every bond.
+     *\return the number of active bonds.
+     */
+    long long countActiveBonds(const std::uint64_t *rows, const std::uint64_t *stubbornRows = nullptr) const;
+
+    /**
+     *\brief Spreads the bits of a number out to the even bit positions.
+     *\param bits the number.
+     *\return the number with bit k moved to bit 2k.
+     */
+    static std::uint64_t spreadBits(std::uint64_t bits)
+    {
+        bits = (bits | (bits << 16)) & 0x0000FFFF0000FFFFull;
+        bits = (bits | (bits << 8))  & 0x00FF00FF00FF00FFull;
+        bits = (bits | (bits << 4))  & 0x0F0F0F0F0F0F0F0Full;
+        bits = (bits | (bits << 2))  & 0x3333333333333333ull;
+        bits = (bits | (bits << 1))  & 0x5555555555555555ull;
+        return bits;
+    }
+
+    /**
+     *\brief Converts an in range 2D index into a bit index in the bitplanes.
+     *
+     * In the Morton layout the low m_mortonBits bits of the column go to the even bits and those of the
+     * row to the odd bits, and the high bits of the longer side, if it is longer, go above them. Only
+     * shifts and masks are needed for the Tiled and Morton layouts.
+     *
+     *\param row row index of site, must be in range.
+     *\param col column index of site, must be in range.
+     *\return bit index of the site.
+     */
+    std::size_t site(int row, int col) const
+    {
+        if(m_layout == VoterArray::Tiled)
+        {
+            std::size_t block = static_cast<std::size_t>(row >> 3) * m_tileColumns + static_cast<std::size_t>(col >> 3);
+            return (block << 6) | static_cast<std::size_t>(((row & 7) << 3) | (col & 7));
+        }
+        if(m_layout == VoterArray::Morton)
+        {
+            std::uint64_t mask = (std::uint64_t(1) << m_mortonBits) - 1;
+            std::uint64_t high = (static_cast<std::uint64_t>(row) | static_cast<std::uint64_t>(col)) >> m_mortonBits;
+            return static_cast<std::size_t>(spreadBits(col & mask) | (spreadBits(row & mask) << 1) | (high << (2 * m_mortonBits)));
+        }
+        return m_origin + static_cast<std::size_t>(col) + static_cast<std::size_t>(row) * m_stride;
+    }
+
+    /**
+     *\brief Finds a neighbour of a site in the Morton layout without recomputing its index.
+     *
+     * Adding or subtracting one from the column (or row) bits of a Morton index alone is done by filling
+     * the other bits with ones (or zeros) so the carry (or borrow) passes straight through them. Steps
+     * across the periodic boundary are the only ones that need the full index of the neighbour.
+     *
+     *\param row row index of site, must be in range.
+     *\param col column index of site, must be in range.
+     *\param site bit index of the site.
+     *\param direction neighbour to find, 0 right, 1 down, 2 left and 3 up.
+     *\return bit index of the neighbour.
+     */
+    std::size_t mortonNeighbour(int row, int col, std::size_t site, int direction) const
+    {
+        // Directions 0 and 2 step the column, 1 and 3 the row.
+        std::uint64_t mask = m_mortonMask[direction & 1];
+        std::uint64_t rest = site & ~mask;
+        switch(direction)
+        {
+            case 0:
+                return col + 1 == m_colCount ? this->site(row, 0) : static_cast<std::size_t>((((site | ~mask) + 1) & mask) | rest);
+            case 1:
+                return row + 1 == m_rowCount ? this->site(0, col) : static_cast<std::size_t>((((site | ~mask) + 1) & mask) | rest);
+            case 2:
+                return col == 0 ? this->site(row, m_colCount - 1) : static_cast<std::size_t>((((site & mask) - 1) & mask) | rest);
+            default:
+                return row == 0 ? this->site(m_rowCount - 1, col) : static_cast<std::size_t>((((site & mask) - 1) & mask) | rest);
+        }
+    }
+
+    /**
+     *\brief Finds a neighbour of a site in any layout.
+     *\param row row index of site, must be in range.
+     *\param col column index of site, must be in range.
+     *\param site bit index of the site.
+     *\param direction neighbour to find, 0 right, 1 down, 2 left and 3 up.
+     *\return bit index of the neighbour.
+     */
+    std::size_t neighbour(int row, int col, std::size_t site, int direction) const
+    {
+        if(m_layout == VoterArray::Halo)
+        {
+            return site + m_neighbourOffset[direction];
+        }
+        if(m_layout == VoterArray::Morton)
+        {
+            return mortonNeighbour(row, col, site, direction);
+        }
+        switch(direction)
+        {
+            case 0:
+                return this->site(row, col + 1 == m_colCount ? 0 : col + 1);
+            case 1:
+                return this->site(row + 1 == m_rowCount ? 0 : row + 1, col);
+            case 2:
+                return this->site(row, col ? col - 1 : m_colCount - 1);
+            default:
+                return this->site(row ? row - 1 : m_rowCount - 1, col);
+        }
+    }
+
+    /**
+     *\brief Change in the number of active bonds when a site has just taken a new opinion.
+     *
+     * Only the 4 bonds of the site change: those to neighbours sharing the new opinion stop being
+     * active and the rest become active. On a lattice one site wide or high the site is its own
+     * neighbour and the bonds to itself never are active.
+     *
+     *\param row row index of site, must be in range.
+     *\param col column index of site, must be in range.
+     *\param site bit index of the site.
+     *\param democrat the new opinion of the site.
+     *\return the change in the number of active bonds.
+     */
+    int bondChange(int row, int col, std::size_t site, bool democrat) const
+    {
+        std::size_t right;
+        std::size_t down;
+        std::size_t left;
+        std::size_t up;
+        if(m_layout == VoterArray::RowMajor)
+        {
+            // Stepping along the row stays in the row, stepping off the top or bottom wraps to the other edge.
+            std::size_t rowStart = site - col;
+            std::size_t wrap = static_cast<std::size_t>(m_rowCount - 1) * m_stride;
+            right = rowStart + (col + 1 == m_colCount ? 0 : col + 1);
+            left = rowStart + (col ? col - 1 : m_colCount - 1);
+            down = row + 1 == m_rowCount ? site - wrap : site + m_stride;
+            up = row ? site - m_stride : site + wrap;
+        }
+        else if(m_layout == VoterArray::Halo)
+        {
+            right = site + m_neighbourOffset[0];
+            down = site + m_neighbourOffset[1];
+            left = site + m_neighbourOffset[2];
+            up = site + m_neighbourOffset[3];
+        }
+        else
+        {
+            right = neighbour(row, col, site, 0);
+            down = neighbour(row, col, site, 1);
+            left = neighbour(row, col, site, 2);
+            up = neighbour(row, col, site, 3);
+        }
+
+        // The ghost copies of a site are only brought up to date after it changes, so use the site itself.
+        int selfBonds = 0;
+        if(m_colCount == 1)
+        {
+            right = left = site;
+            selfBonds += 2;
+        }
+        if(m_rowCount == 1)
+        {
+            down = up = site;
+            selfBonds += 2;
+        }
+
+        int agreeing = (testBit(m_opinion, right) == democrat) + (testBit(m_opinion, down) == democrat)
+                     + (testBit(m_opinion, left) == democrat) + (testBit(m_opinion, up) == democrat);
+        return 4 - 2 * agreeing + selfBonds;
+    }
+
+    /**
+     *\brief Converts a (possibly out of range) 2D index into a bit index in the bitplanes.
+     *\param row row index of site, periodic boundary conditions are applied.
+     *\param col column index of site, periodic boundary conditions are applied.
+     *\return bit index of the site.
+     */
+    std::size_t index(int row, int col) const;
+
+    /**
+     *\brief Copies the opinion of an edge site into the ghost sites that mirror it.
+     *
+     * Does nothing for sites away from the edges or in the RowMajor layout.
+     *
+     *\param row row index of site, must be in range.
+     *\param col column index of site, must be in range.
+     */
+    void mirror(int row, int col);
+
+    /**
+     *\brief Copies a bitplane into a packed row-major frame, see packOpinions().
+     */
+    void packPlane(const Plane &plane, std::vector<std::uint64_t> &frame) const;
+
+    /**
+     *\brief Counts the set bits in a range of a bitplane.
+     *\param plane the bitplane to count.
+     *\param begin first bit of the range.
+     *\param length number of bits in the range.
+     *\return the number of set bits.
+     */
+    static long long countBits(const Plane &plane, std::size_t begin, std::size_t length);
+
+    /**
+     *\brief Reads up to 64 consecutive bits of a bitplane.
+     *\param plane the bitplane to read.
+     *\param begin first bit to read.
+     *\param length number of bits to read, at most 64.
+     *\return the bits, bit begin in bit 0 and the bits past length clear.
+     */
+    static std::uint64_t readBits(const Plane &plane, std::size_t begin, std::size_t length);
+
+    /**
+     *\brief Overwrites up to 64 consecutive bits of a bitplane.
+     *\param plane the bitplane to write.
+     *\param begin first bit to write.
+     *\param length number of bits to write, at most 64.
+     *\param bits the new bits, bit 0 going to bit begin.
+     */
+    static void writeBits(Plane &plane, std::size_t begin, std::size_t length, std::uint64_t bits);
+
+    /**
+     *\brief Copies a bitplane into rows padded to whole words.
+     *\param plane the bitplane to copy.
+     *\param rows the rows are written from here on, (cols + 63)/64 words per row.
+     */
+    void alignRows(const Plane &plane, std::uint64_t *rows) const;
+
+    /**
+     *\brief Reads a single bit from a bitplane or a packed frame.
+     *\param plane the bitplane to read.
+     *\param bit the bit index.
+     *\return true if the bit is set.
+     */
+    template<class Words>
+    static bool testBit(const Words &plane, std::size_t bit)
+    {
+        return (plane[bit >> 6] >> (bit & 63)) & 1u;
+    }
+
+    /**
+     *\brief Writes a single bit of a bitplane.
+     *\param plane the bitplane to write.
+     *\param bit the bit index.
+     *\param value the new value of the bit.
+     */
+    static void assignBit(Plane &plane, std::size_t bit, bool value)
+    {
+        const std::uint64_t mask = std::uint64_t(1) << (bit & 63);
+        plane[bit >> 6] = value ? (plane[bit >> 6] | mask) : (plane[bit >> 6] & ~mask);
+    }
+
+    /**
+     *\brief Copies the opinion of one site to a non-stubborn site.
+     *\param row row index of the site being updated, must be in range.
+     *\param col column index of the site being updated, must be in range.
+     *\param site bit index of the site being updated, it must not be stubborn.
+     *\param neighbour bit index of the site whose opinion is copied.
+     *\param delta accumulator for the changes to the tracked observables.
+     *\return true if the site is now a democrat.
+     */
+    bool copyOpinion(int row, int col, std::size_t site, std::size_t neighbour, Delta &delta)
+    {
+        bool democrat = testBit(m_opinion,neighbour);
+        if(instrumented)
+        {
+            ++delta.counters.attempts;
+        }
+        if(democrat != testBit(m_opinion,site))
+        {
+            if(instrumented)
+            {
+                ++delta.counters.flips;
+            }
+            delta.magnetization += democrat ? -2 : +2;
+            assignBit(m_opinion,site,democrat);
+            delta.activeBonds += bondChange(row,col,site,democrat);
+        }
+        return democrat;
+    }
 
 public:
     /**
      *\brief operator overload for getting the state at a site.
      *
-     * This method is implemented since the states are stored internally as a 1D vector, hence
+     * This method is implemented since the states are stored internally as two packed bitplanes, hence
      * they need to be indexed in a special way in order to get the site that would correspond to
      * the (i,j) site in matrix notation. This function allows the caller to treat the lattice as a
      * 2D matrix without having to worry about the internal implementation.
      *
      *\param row row index of site.
      *\param col column index of site.
-     *\return reference to state stored at site so called can use it or set it.
+     *\return the state stored at site.
      */
-    VoterArray::State& operator()(int row, int col);
+    VoterArray::State operator()(int row, int col) const;
 
     /**
-     *\brief constant version of non-constant counterpart for use with constant VoterArray object.
+     *\brief Sets the state at a site.
      *
-     * See non-constant version for description.
+     * All writes to the lattice go through this method so that the running magnetization is kept
+     * in step with the lattice.
      *
      *\param row row index of site.
      *\param col column index of site.
-     *\return constant reference to state stored at site so called can use it only.
+     *\param state the new state of the site.
      */
-    const VoterArray::State& operator()(int row, int col) const;
+    void setState(int row, int col, VoterArray::State state);
 
     /**
      *\brief Constructor that randomises lattice to an even mix of states.
@@ -74,16 +501,23 @@ public:
      *\param probSI probability of going from susceptible to infected state if cell is in contact with infected cell.
      *\param probIR probability of infected site going from infected to recovered.
      *\param probRS probability of recovered site becoming susceptible again.
-     *\param generator std::default_random_engine reference for generating random numbers.
+     *\param generator RandomEngine reference for generating random numbers.
      *\param immuneFraction floating point instance representing the fraction of the population who are completely immune to the infection.
+     *\param layout layout of the sites in memory.
      */
     VoterArray(
-        std::default_random_engine &generator,
+        RandomEngine &generator,
     	int rows = 50,
     	int cols = 50,
-    	double initalOrder = 0.5
+    	double initalOrder = 0.5,
+    	Layout layout = RowMajor
     	);
 
+    /**
+     *\brief Virtual destructor so specialised lattices can be held through a VoterArray pointer.
+     */
+    virtual ~VoterArray() = default;
+
 
     /**
      *\brief Getter for the number of rows.
@@ -99,19 +533,187 @@ public:
 
     /**
      *\brief Getter for size of lattice #rows * #columns.
-     *\return Integer value representing the size of the lattice.
+     *\return number of sites, which can be more than an int holds.
+     */
+    std::size_t getSize() const;
+
+    /**
+     *\brief Getter for the layout of the sites in memory.
+     *\return the layout.
+     */
+    Layout getLayout() const;
+
+    /**
+     *\brief Tests whether a row starts a new word of the planes.
+     *
+     * Threads writing to strips of rows cut at such rows never write to the same word, see ParallelSweeper.
+     *
+     *\param row row index, in [1, rows).
+     *\return true if no word holds sites, ghost sites included, of both the rows above and the rows from this one on.
      */
-    int getSize() const;
+    bool separatesWords(int row) const;
+
+    /**
+     *\brief Getter for the number of stubborn voters.
+     *\return the number of sites whose opinion never changes.
+     */
+    std::size_t getStubbornCount() const;
+
+    /**
+     *\brief Getter for the counts of what the updates have done since the lattice was made.
+     *\return the counts, all 0 without -DVOTER_INSTRUMENTATION.
+     */
+    const UpdateCounters& getCounters() const;
+
+    /**
+     *\brief Getter for the dense list of non-stubborn sites that the updates are drawn from.
+     *
+     * The list is rebuilt here if the stubborn flags have changed, so it must not be called while
+     * other threads are updating the lattice. It is empty when there are no stubborn voters, in which
+     * case every site is mobile and the updates draw from the whole lattice.
+     *
+     *\return row-major numbers (col + row * cols) of the non-stubborn sites in increasing order.
+     */
+    const std::vector<std::size_t>& mobileSites();
+
+    /**
+     *\brief Getter for the number of active bonds that no update can remove.
+     *
+     * A bond between two stubborn voters of opposite opinions stays active for good, every other active
+     * bond has a mobile end that some update can flip. The count only depends on the stubborn voters so
+     * it is kept with the mobile sites and rebuilt when they change.
+     *
+     *\return the number of active bonds between two stubborn voters.
+     */
+    long long frozenBonds();
+
+    /**
+     *\brief Tests whether the lattice is in an absorbing state, where no update can change it.
+     *
+     * Without stubborn voters that is consensus. With them it is every mobile voter agreeing with all
+     * its neighbours, which is consensus if the stubborn voters all share an opinion and otherwise a
+     * mix held in place by walls of stubborn voters. O(1) from the running count of active bonds.
+     *
+     *\return true if the only active bonds are between stubborn voters.
+     */
+    bool frozen();
+
+    /**
+     *\brief Copies the opinions into a packed row-major frame.
+     *
+     * Site (row,col) goes to bit col + row * cols of the frame, with a set bit for a democrat, whatever
+     * the layout of the lattice. Bits past the last site are cleared.
+     *
+     *\param frame vector resized to (rows*cols + 63)/64 words and overwritten with the opinions.
+     */
+    void packOpinions(std::vector<std::uint64_t> &frame) const;
+
+    /**
+     *\brief Copies the stubborn flags into a packed row-major frame laid out as in packOpinions().
+     *\param frame vector resized to (rows*cols + 63)/64 words and overwritten with the stubborn flags.
+     */
+    void packStubborn(std::vector<std::uint64_t> &frame) const;
+
+    /**
+     *\brief Overwrites every site from packed row-major frames, the inverse of packOpinions() and packStubborn().
+     *\param opinions frame with a set bit for each democrat.
+     *\param stubborn frame with a set bit for each stubborn voter.
+     */
+    void unpackStates(const std::vector<std::uint64_t> &opinions, const std::vector<std::uint64_t> &stubborn);
 
     /**
      *\brief Updates a random cell in the grid.
-     *\param std::default_random_engine reference for random number generation.
+     *
+     * Only non-stubborn sites are drawn, so every call can change the lattice.
+     *
+     *\param generator RandomEngine reference for random number generation.
+     *\return the new updated state of the cell.
+     */
+    VoterArray::State update(RandomEngine& generator);
+
+    /**
+     *\brief Performs a sweep, one update per site on average, of random sequential updates.
+     *
+     * The random words for the updates are generated in bulk a block at a time and each word supplies
+     * the row, column and neighbour direction of one update. With stubborn voters present the sites are
+     * drawn from the mobile sites only and a sweep is one update per mobile site, so each voter that can
+     * change is still updated once per sweep on average and the time scale is that of drawing from the
+     * whole lattice, without spending updates on stubborn voters.
+     *
+     * The sweep always makes all its updates, but it notes the one that left the lattice frozen(), if
+     * any, for freezingFraction().
+     *
+     *\param generator RandomEngine reference for random number generation.
+     */
+    virtual void sweep(RandomEngine& generator);
+
+    /**
+     *\brief Getter for how far into the last sweep() the lattice froze.
+     *\return (index + 1) / updates for the update that left the lattice frozen(), 1 if none of them did.
+     */
+    double freezingFraction() const;
+
+    /**
+     *\brief Performs a synchronous sweep, every site copying a random neighbour at once.
+     *
+     * The sites all read the configuration before the sweep and all write the new one, so the update
+     * is double buffered: the lattice is copied into rows padded to whole words, the new rows are built
+     * 64 sites per word from two random words that give every site its direction, and copied back. The
+     * rows are handed to synchronousRow(), which uses AVX-512 or AVX2 where available. Stubborn voters
+     * keep their opinion.
+     *
+     *\param generator RandomEngine reference for random number generation.
+     */
+    void synchronousSweep(RandomEngine& generator);
+
+    /**
+     *\brief Updates the given site by copying the opinion of one of its nearest neighbours.
+     *
+     * Changes to the tracked observables are accumulated in delta rather than applied to the lattice,
+     * they must be handed back with applyDelta(). Threads may call this concurrently as long as no
+     * two of them write to the same 64-bit word of the lattice at the same time.
+     *
+     *\param row row index of site, must be in range.
+     *\param col column index of site, must be in range.
+     *\param direction neighbour to copy, 0 right, 1 down, 2 left and 3 up.
+     *\param delta accumulator for the changes to the tracked observables.
      *\return the new updated state of the cell.
      */
-    VoterArray::State update(std::default_random_engine& generator);
+    VoterArray::State updateSite(int row, int col, int direction, Delta &delta);
+
+    /**
+     *\brief Applies the observable changes accumulated by updateSite().
+     *\param delta accumulated changes.
+     */
+    void applyDelta(const Delta &delta);
 
+    /**
+     *\brief Getter for the order parameter (mean voter value) of the lattice.
+     *
+     * The value is read from a running sum that is updated on every change of state so this is
+     * O(1) and may be called between single updates. Debug builds check it against a full
+     * recomputation.
+     *
+     *\return floating point value in [-1,1] representing the order parameter.
+     */
     double orderParameter() const;
 
+    /**
+     *\brief Getter for the magnetization, the sum of the voter values, read from the running sum.
+     *\return the number of sites with one opinion less the number with the other.
+     */
+    long long magnetization() const;
+
+    /**
+     *\brief Method to calculate the density of active bonds, the nearest neighbour bonds joining opposite opinions.
+     *
+     * Like orderParameter() this reads a running count, kept up to date by looking at the 4 bonds of
+     * every site that changes, so it is O(1). Debug builds check it against a full recomputation.
+     *
+     *\return floating point value in [0,1], the fraction of the 2 * rows * cols bonds that are active.
+     */
+    double activeBondDensity() const;
+
     /**
      *\brief streams the board to an output stream in a nicely formatted way
      *\param out std::ostream reference that is being streamed to
@@ -122,4 +724,20 @@ public:
 
 };
 
+/**
+ *\brief streams the name of a layout, row-major, halo, tiled or morton.
+ *\param out std::ostream reference that is being streamed to.
+ *\param layout the layout to print.
+ *\return std::ostream reference to output can be chained.
+ */
+std::ostream& operator<<(std::ostream& out, VoterArray::Layout layout);
+
+/**
+ *\brief reads the name of a layout, row-major, halo, tiled or morton, setting the failbit for any other name.
+ *\param in std::istream reference that is being read from.
+ *\param layout the layout that is read.
+ *\return std::istream reference so input can be chained.
+ */
+std::istream& operator>>(std::istream& in, VoterArray::Layout &layout);
+
 #endif /* VoterArray_hpp */
@@ -0,0 +1,304 @@
+#include "VoterGraph.hpp"
+#include <cmath> // For std::round.
+#include <stdexcept>
+
+VoterGraph::VoterGraph(const Graph &graph, RandomEngine &generator, double initialOrder) :
+	m_graph(graph),
+	m_opinion((graph.getVertexCount() + 63) / 64, ~std::uint64_t(0)),
+	m_stubborn(m_opinion.size(), 0),
+	m_magnetization{-static_cast<long long>(graph.getVertexCount())},
+	m_activeEdges{0},
+	m_frozenEdges{0},
+	m_mobileStale{true}
+{
+	// Every voter starts as a democrat, clear the padding bits past the last vertex.
+	std::size_t vertexCount = graph.getVertexCount();
+	if(vertexCount % 64)
+	{
+		m_opinion.back() = (std::uint64_t(1) << (vertexCount % 64)) - 1;
+	}
+
+	// Convert the number of republicans the order parameter asks for, as VoterArray does.
+	long long republicanNumber = std::llround((initialOrder + 1.0) / 2.0 * vertexCount);
+	long long converted = 0;
+	while(converted < republicanNumber)
+	{
+		std::uint64_t word = generator();
+		std::uint32_t vertex = static_cast<std::uint32_t>(takeBounded(word, vertexCount));
+		if(testBit(m_opinion, vertex))
+		{
+			m_opinion[vertex >> 6] &= ~(std::uint64_t(1) << (vertex & 63));
+			++converted;
+		}
+	}
+
+	m_magnetization += 2 * republicanNumber;
+	assert(m_magnetization == computeMagnetization());
+	m_activeEdges = computeActiveEdges();
+}
+
+long long VoterGraph::computeMagnetization() const
+{
+	long long democrats = 0;
+	for(auto const& word : m_opinion)
+	{
+		democrats += __builtin_popcountll(word);
+	}
+	return static_cast<long long>(getSize()) - 2 * democrats;
+}
+
+long long VoterGraph::computeActiveEdges() const
+{
+	// Each edge is counted from its lower end.
+	long long count = 0;
+	for(std::uint32_t vertex = 0; vertex < getSize(); ++vertex)
+	{
+		const std::uint32_t *neighbours = m_graph.neighbours(vertex);
+		bool democrat = testBit(m_opinion, vertex);
+		for(std::size_t i = 0; i < m_graph.getDegree(vertex); ++i)
+		{
+			count += neighbours[i] > vertex && testBit(m_opinion, neighbours[i]) != democrat;
+		}
+	}
+	return count;
+}
+
+const Graph& VoterGraph::getGraph() const
+{
+	return m_graph;
+}
+
+std::size_t VoterGraph::getSize() const
+{
+	return m_graph.getVertexCount();
+}
+
+const UpdateCounters& VoterGraph::getCounters() const
+{
+	return m_counters;
+}
+
+VoterArray::State VoterGraph::operator()(std::uint32_t vertex) const
+{
+	return static_cast<VoterArray::State>(testBit(m_opinion, vertex) | (testBit(m_stubborn, vertex) << 1));
+}
+
+void VoterGraph::setState(std::uint32_t vertex, VoterArray::State state)
+{
+	m_magnetization += VoterArray::stateSymbols[state] - VoterArray::stateSymbols[(*this)(vertex)];
+
+	// The frozen edges are kept with the mobile vertices, so a stubborn voter changing its mind
+	// invalidates them as well.
+	bool flipped = bool(state & 1) != testBit(m_opinion, vertex);
+	if(bool(state & 2) != testBit(m_stubborn, vertex) || (flipped && (state & 2)))
+	{
+		m_mobileStale = true;
+	}
+
+	std::uint64_t mask = std::uint64_t(1) << (vertex & 63);
+	m_opinion[vertex >> 6] = (state & 1) ? (m_opinion[vertex >> 6] | mask) : (m_opinion[vertex >> 6] & ~mask);
+	m_stubborn[vertex >> 6] = (state & 2) ? (m_stubborn[vertex >> 6] | mask) : (m_stubborn[vertex >> 6] & ~mask);
+	if(flipped)
+	{
+		m_activeEdges += edgeChange(vertex, state & 1);
+	}
+}
+
+void VoterGraph::placeStubborn(StubbornPlacement placement, std::size_t count, RandomEngine &generator)
+{
+	if(count == 0)
+	{
+		return;
+	}
+	if(placement == MaskStubborn)
+	{
+		throw std::runtime_error("stubborn masks are for lattices, use the random or clustered placement on a graph");
+	}
+	if(count > getSize())
+	{
+		throw std::runtime_error("more stubborn voters than vertices");
+	}
+
+	std::size_t placed = 0;
+	auto makeStubborn = [&](std::uint32_t vertex)
+	{
+		VoterArray::State state = (*this)(vertex);
+		if(!(state & 2))
+		{
+			setState(vertex, static_cast<VoterArray::State>(state | 2));
+			++placed;
+		}
+	};
+
+	if(placement == RandomStubborn)
+	{
+		while(placed < count)
+		{
+			std::uint64_t word = generator();
+			makeStubborn(static_cast<std::uint32_t>(takeBounded(word, getSize())));
+		}
+		return;
+	}
+
+	// Grow a breadth first ball around a random vertex, carrying on from further random vertices if its
+	// component is too small.
+	std::vector<bool> visited(getSize(), false);
+	std::vector<std::uint32_t> queue;
+	while(placed < count)
+	{
+		std::uint64_t word = generator();
+		std::uint32_t centre = static_cast<std::uint32_t>(takeBounded(word, getSize()));
+		if(visited[centre])
+		{
+			continue;
+		}
+
+		visited[centre] = true;
+		queue.assign(1, centre);
+		for(std::size_t head = 0; head < queue.size() && placed < count; ++head)
+		{
+			std::uint32_t vertex = queue[head];
+			makeStubborn(vertex);
+			for(std::size_t i = 0; i < m_graph.getDegree(vertex); ++i)
+			{
+				std::uint32_t neighbour = m_graph.neighbours(vertex)[i];
+				if(!visited[neighbour])
+				{
+					visited[neighbour] = true;
+					queue.push_back(neighbour);
+				}
+			}
+		}
+	}
+}
+
+const std::vector<std::uint32_t>& VoterGraph::mobileVertices()
+{
+	if(m_mobileStale)
+	{
+		m_mobile.clear();
+		for(std::size_t vertex = 0; vertex < getSize(); ++vertex)
+		{
+			std::uint32_t v = static_cast<std::uint32_t>(vertex);
+			if(!testBit(m_stubborn, v) && m_graph.getDegree(v))
+			{
+				m_mobile.push_back(v);
+			}
+		}
+
+		// Count the active edges between stubborn voters from their lower ends.
+		m_frozenEdges = 0;
+		for(std::uint32_t vertex = 0; vertex < getSize(); ++vertex)
+		{
+			if(!testBit(m_stubborn, vertex))
+			{
+				continue;
+			}
+			const std::uint32_t *neighbours = m_graph.neighbours(vertex);
+			bool democrat = testBit(m_opinion, vertex);
+			for(std::size_t i = 0; i < m_graph.getDegree(vertex); ++i)
+			{
+				std::uint32_t neighbour = neighbours[i];
+				m_frozenEdges += neighbour > vertex && testBit(m_stubborn, neighbour) && testBit(m_opinion, neighbour) != democrat;
+			}
+		}
+		m_mobileStale = false;
+	}
+	return m_mobile;
+}
+
+long long VoterGraph::frozenEdges()
+{
+	mobileVertices();
+	return m_frozenEdges;
+}
+
+bool VoterGraph::frozen()
+{
+	return m_activeEdges == frozenEdges();
+}
+
+void VoterGraph::update(RandomEngine &generator)
+{
+	const std::vector<std::uint32_t> &mobile = mobileVertices();
+	if(mobile.empty())
+	{
+		return;
+	}
+
+	// One word picks the vertex and then the neighbour.
+	std::uint64_t word = generator();
+	std::uint32_t vertex = mobile[takeBounded(word, mobile.size())];
+	updateVertex(vertex, word);
+}
+
+void VoterGraph::sweep(RandomEngine &generator)
+{
+	const std::vector<std::uint32_t> &mobile = mobileVertices();
+
+	// When every vertex is mobile the list is the identity and the lookup can be skipped.
+	bool everyVertex = mobile.size() == getSize();
+
+	// Size of the blocks of random words generated at once, and how far ahead of the updates the
+	// adjacency of the vertices is prefetched. The vertices are spread over the whole graph so each
+	// update would otherwise wait on a cache miss for its offset and another for its neighbours.
+	const std::size_t blockSize = 1024;
+	const std::size_t offsetDistance = 16;
+	const std::size_t neighbourDistance = 8;
+	std::uint64_t words[blockSize];
+	std::uint32_t vertices[blockSize];
+
+	std::size_t remaining = mobile.size();
+	while(remaining)
+	{
+		std::size_t count = remaining < blockSize ? remaining : blockSize;
+		generator.fill(words, count);
+
+		for(std::size_t i = 0; i < count; ++i)
+		{
+			std::size_t pick = takeBounded(words[i], mobile.size());
+			vertices[i] = everyVertex ? static_cast<std::uint32_t>(pick) : mobile[pick];
+		}
+
+		for(std::size_t i = 0; i < count; ++i)
+		{
+			if(i + offsetDistance < count)
+			{
+				m_graph.prefetchOffset(vertices[i + offsetDistance]);
+			}
+			if(i + neighbourDistance < count)
+			{
+				__builtin_prefetch(m_graph.neighbours(vertices[i + neighbourDistance]));
+			}
+			updateVertex(vertices[i], words[i]);
+		}
+
+		remaining -= count;
+	}
+}
+
+double VoterGraph::orderParameter() const
+{
+	// Debug builds compare the running sum against a full pass over the voters.
+	assert(m_magnetization == computeMagnetization());
+
+	return static_cast<double>(m_magnetization) / getSize();
+}
+
+double VoterGraph::activeBondDensity() const
+{
+	assert(m_activeEdges == computeActiveEdges());
+
+	std::size_t edges = m_graph.getEdgeCount();
+	return edges ? static_cast<double>(m_activeEdges) / edges : 0;
+}
+
+void VoterGraph::packOpinions(std::vector<std::uint64_t> &frame) const
+{
+	frame.assign(m_opinion.size(), 0);
+	for(std::size_t vertex = 0; vertex < getSize(); ++vertex)
+	{
+		std::uint32_t label = m_graph.getLabel(static_cast<std::uint32_t>(vertex));
+		frame[label >> 6] |= std::uint64_t(testBit(m_opinion, static_cast<std::uint32_t>(vertex))) << (label & 63);
+	}
+}
@@ -0,0 +1,233 @@
+#ifndef VoterGraph_hpp
+#define VoterGraph_hpp
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cassert>
+#include "Graph.hpp"
+#include "VoterArray.hpp"
+#include "RandomEngine.hpp"
+#include "placeStubborn.hpp"
+
+/**
+ *\file
+ *\class VoterGraph
+ *\brief Voter model on the vertices of an arbitrary Graph.
+ *
+ * The counterpart of VoterArray for networks: an update picks a random voter that is not stubborn and
+ * copies the opinion of a random one of its neighbours, which are read from the CSR arrays of the graph.
+ * The opinions and stubborn flags are bitplanes indexed by vertex and the sum of the voter values is kept
+ * as a running sum, as in VoterArray, and the states are the VoterArray states. Relabelling the graph
+ * with Graph::reorder() before the voters are put on it keeps the neighbour reads of a vertex close
+ * together in the bitplanes.
+ */
+class VoterGraph
+{
+private:
+	/// Graph the voters live on.
+	Graph m_graph;
+
+	/// Opinion bitplane, one bit per vertex, a set bit is a democrat.
+	std::vector<std::uint64_t> m_opinion;
+
+	/// Stubborn bitplane, one bit per vertex, a set bit is a stubborn voter.
+	std::vector<std::uint64_t> m_stubborn;
+
+	/// Running sum of the voter values over the graph.
+	long long m_magnetization;
+
+	/// Running count of the edges joining opposite opinions.
+	long long m_activeEdges;
+
+	/// Running counts of what the updates did, only kept with -DVOTER_INSTRUMENTATION.
+	UpdateCounters m_counters;
+
+	/// Vertices that are not stubborn and have at least one neighbour, the ones the updates draw from.
+	std::vector<std::uint32_t> m_mobile;
+
+	/// Active edges between two stubborn voters, built with m_mobile, see frozenEdges().
+	long long m_frozenEdges;
+
+	/// Set when the stubborn voters have changed since m_mobile was built.
+	bool m_mobileStale;
+
+	/**
+	 *\brief Sums the voter values of every vertex, see VoterArray::computeMagnetization().
+	 *\return the sum of the voter values.
+	 */
+	long long computeMagnetization() const;
+
+	/**
+	 *\brief Counts the edges joining opposite opinions, the full recomputation of m_activeEdges.
+	 *\return the number of active edges.
+	 */
+	long long computeActiveEdges() const;
+
+	/**
+	 *\brief Change in the number of active edges when a vertex has just taken a new opinion.
+	 *\param vertex the vertex.
+	 *\param democrat its new opinion.
+	 *\return the change, found from the opinions of its neighbours.
+	 */
+	long long edgeChange(std::uint32_t vertex, bool democrat) const
+	{
+		const std::uint32_t *neighbours = m_graph.neighbours(vertex);
+		std::size_t degree = m_graph.getDegree(vertex);
+		long long agreeing = 0;
+		for(std::size_t i = 0; i < degree; ++i)
+		{
+			agreeing += testBit(m_opinion, neighbours[i]) == democrat;
+		}
+		return static_cast<long long>(degree) - 2 * agreeing;
+	}
+
+	/**
+	 *\brief Reads the bit of a vertex from a bitplane.
+	 */
+	static bool testBit(const std::vector<std::uint64_t> &plane, std::uint32_t vertex)
+	{
+		return (plane[vertex >> 6] >> (vertex & 63)) & 1u;
+	}
+
+	/**
+	 *\brief Updates a vertex by copying the opinion of one of its neighbours.
+	 *\param vertex the vertex, it must be mobile.
+	 *\param word random word whose top bits pick the neighbour.
+	 */
+	void updateVertex(std::uint32_t vertex, std::uint64_t word)
+	{
+		const std::uint32_t *neighbours = m_graph.neighbours(vertex);
+		std::uint32_t neighbour = neighbours[takeBounded(word, m_graph.getDegree(vertex))];
+
+		std::uint64_t mask = std::uint64_t(1) << (vertex & 63);
+		bool democrat = testBit(m_opinion, neighbour);
+		if(instrumented)
+		{
+			++m_counters.attempts;
+		}
+		if(democrat != testBit(m_opinion, vertex))
+		{
+			if(instrumented)
+			{
+				++m_counters.flips;
+			}
+			m_magnetization += democrat ? -2 : +2;
+			m_opinion[vertex >> 6] ^= mask;
+			m_activeEdges += edgeChange(vertex, democrat);
+		}
+	}
+
+public:
+	/**
+	 *\brief Constructor that randomises the opinions as VoterArray does.
+	 *\param graph the graph, already reordered if it is to be.
+	 *\param generator RandomEngine reference for generating random numbers.
+	 *\param initialOrder initial value of the order parameter.
+	 */
+	VoterGraph(const Graph &graph, RandomEngine &generator, double initialOrder = 0.0);
+
+	/**
+	 *\brief Getter for the graph.
+	 *\return the graph the voters live on.
+	 */
+	const Graph& getGraph() const;
+
+	/**
+	 *\brief Getter for the number of voters.
+	 *\return the number of vertices.
+	 */
+	std::size_t getSize() const;
+
+	/**
+	 *\brief Getter for the counts of what the updates have done, see VoterArray::getCounters().
+	 *\return the counts, all 0 without -DVOTER_INSTRUMENTATION. Stubborn voters are never picked.
+	 */
+	const UpdateCounters& getCounters() const;
+
+	/**
+	 *\brief Getter for the state of a vertex.
+	 *\param vertex the vertex.
+	 *\return the state of the vertex.
+	 */
+	VoterArray::State operator()(std::uint32_t vertex) const;
+
+	/**
+	 *\brief Sets the state of a vertex, keeping the running sum up to date.
+	 *\param vertex the vertex.
+	 *\param state the new state.
+	 */
+	void setState(std::uint32_t vertex, VoterArray::State state);
+
+	/**
+	 *\brief Makes some of the voters stubborn with the opinions they have.
+	 *
+	 * The random placement picks vertices uniformly, the clustered placement takes the vertices closest
+	 * to a random vertex in breadth first order, the graph's counterpart of a disk. Masks are for
+	 * lattices only.
+	 *
+	 *\param placement where the stubborn voters go.
+	 *\param count number of stubborn voters.
+	 *\param generator RandomEngine reference for choosing the vertices.
+	 *\throws std::runtime_error if they cannot be placed.
+	 */
+	void placeStubborn(StubbornPlacement placement, std::size_t count, RandomEngine &generator);
+
+	/**
+	 *\brief Getter for the vertices the updates draw from.
+	 *\return the vertices that are not stubborn and have a neighbour, in increasing order.
+	 */
+	const std::vector<std::uint32_t>& mobileVertices();
+
+	/**
+	 *\brief Getter for the number of active edges that no update can remove, see VoterArray::frozenBonds().
+	 *\return the number of active edges between two stubborn voters.
+	 */
+	long long frozenEdges();
+
+	/**
+	 *\brief Tests whether the voters are in an absorbing state, see VoterArray::frozen().
+	 *\return true if the only active edges are between stubborn voters.
+	 */
+	bool frozen();
+
+	/**
+	 *\brief Updates a random voter that can change.
+	 *\param generator RandomEngine reference for random number generation.
+	 */
+	void update(RandomEngine &generator);
+
+	/**
+	 *\brief Performs a sweep, one update per voter that can change.
+	 *\param generator RandomEngine reference for random number generation.
+	 */
+	void sweep(RandomEngine &generator);
+
+	/**
+	 *\brief Getter for the order parameter (mean voter value).
+	 *\return floating point value in [-1,1] representing the order parameter.
+	 */
+	double orderParameter() const;
+
+	/**
+	 *\brief Getter for the density of active edges, those joining opposite opinions.
+	 *
+	 * Read from a running count that a flip updates by looking at the edges of the vertex, so it costs
+	 * the degree of the flipped vertex rather than the 4 of the lattice.
+	 *
+	 *\return floating point value in [0,1], the fraction of the edges that are active, 0 without edges.
+	 */
+	double activeBondDensity() const;
+
+	/**
+	 *\brief Copies the opinions into a packed frame in the original vertex labels.
+	 *
+	 * Vertex v as labelled before any reordering goes to bit v, so the frames of a run can be compared
+	 * whatever ordering was used.
+	 *
+	 *\param frame vector resized to (vertices + 63)/64 words and overwritten with the opinions.
+	 */
+	void packOpinions(std::vector<std::uint64_t> &frame) const;
+};
+
+#endif /* VoterGraph_hpp */
@@ -8,7 +8,22 @@ std::ostream& operator<<(std::ostream& out, const VoterInputParameters& params)
     out << std::setw(outputColumnWidth) << std::setfill(' ') << std::left << "Columns: " << std::right << params.colCount << '\n';
     out << std::setw(outputColumnWidth) << std::setfill(' ') << std::left << "Inital-Order: " << std::right << params.initialOrder << '\n';
     out << std::setw(outputColumnWidth) << std::setfill(' ') << std::left << "Sweeps: " << std::right << params.sweeps << '\n';
+    out << std::setw(outputColumnWidth) << std::setfill(' ') << std::left << "Seed: " << std::right << params.seed << '\n';
+    out << std::setw(outputColumnWidth) << std::setfill(' ') << std::left << "Threads: " << std::right << params.threadCount << '\n';
+    out << std::setw(outputColumnWidth) << std::setfill(' ') << std::left << "Replicas: " << std::right << params.replicaCount << '\n';
+    out << std::setw(outputColumnWidth) << std::setfill(' ') << std::left << "Layout: " << std::right << params.layout << '\n';
+    out << std::setw(outputColumnWidth) << std::setfill(' ') << std::left << "Engine: " << std::right << params.engine << '\n';
     out << std::setw(outputColumnWidth) << std::setfill(' ') << std::left << "Stubborn-Number: " << std::right << params.stubbornNumber << '\n';
+    out << std::setw(outputColumnWidth) << std::setfill(' ') << std::left << "Stubborn-Placement: " << std::right << params.stubbornPlacement << '\n';
+    if(params.stubbornPlacement == MaskStubborn)
+    {
+        out << std::setw(outputColumnWidth) << std::setfill(' ') << std::left << "Stubborn-Mask: " << std::right << params.stubbornMask << '\n';
+    }
+    if(!params.graph.empty())
+    {
+        out << std::setw(outputColumnWidth) << std::setfill(' ') << std::left << "Graph: " << std::right << params.graph << '\n';
+        out << std::setw(outputColumnWidth) << std::setfill(' ') << std::left << "Vertex-Ordering: " << std::right << params.vertexOrdering << '\n';
+    }
 	out << std::setw(outputColumnWidth) << std::setfill(' ') << std::left << "Output-Directory: " << std::right << params.outputDirectory << '\n';
     return out;
 }
@@ -3,6 +3,9 @@
 #include <iostream>
 #include <iomanip>
 #include <string>
+#include "VoterArray.hpp"
+#include "placeStubborn.hpp"
+#include "Graph.hpp"
 /**
  *\file
  *\class VoterInputParameters
@@ -23,10 +26,28 @@ public:
 	double initialOrder;
 
 	/// Total number of sweeps in the simulation.
-	int sweeps;
-	int stubbornNumber;
+	long long sweeps;
+	/// Seed of the random number generator.
+	unsigned long long seed;
+	/// Number of threads used for each sweep.
+	int threadCount;
+	/// Number of independent replicas.
+	int replicaCount;
+	/// Layout of the lattice in memory.
+	VoterArray::Layout layout;
+	/// Name of the update engine.
+	std::string engine;
+	long long stubbornNumber;
+	/// Where the stubborn voters are put.
+	StubbornPlacement stubbornPlacement;
+	/// File the stubborn voters are read from for the mask placement.
+	std::string stubbornMask;
 	/// Output directory.
 	std::string outputDirectory;
+	/// Description of the graph the voters live on, empty for the square lattice.
+	std::string graph;
+	/// How the vertices of the graph are ordered in memory.
+	Graph::Ordering vertexOrdering;
 
 
 
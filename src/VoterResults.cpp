@@ -3,10 +3,32 @@
 std::ostream& operator<<(std::ostream &out, const VoterResults &results)
 {
 	int outputColumnWidth = 30;
-	/*out << "Results..." << '\n';
-   	out << std::setw(outputColumnWidth) << std::setfill(' ') << std::left << "Order-Parameter: " <<
-   	std::right << results.orderParameter << " +/- " << results.orderParameterError << '\n';
-   	out << std::setw(outputColumnWidth) << std::setfill(' ') << std::left << "Susceptibility: " <<
-   	std::right << results.susceptibility << " +/- " << results.susceptibilityError << '\n';
-	return out;*/
+	out << "Results..." << '\n';
+	out << std::setw(outputColumnWidth) << std::setfill(' ') << std::left << "Order-Parameter: " <<
+	std::right << results.orderParameter << " +/- " << results.orderParameterError << '\n';
+	out << std::setw(outputColumnWidth) << std::setfill(' ') << std::left << "Absolute-Order-Parameter: " <<
+	std::right << results.absoluteOrderParameter << " +/- " << results.absoluteOrderParameterError << '\n';
+	out << std::setw(outputColumnWidth) << std::setfill(' ') << std::left << "Square-Order-Parameter: " <<
+	std::right << results.squareOrderParameter << '\n';
+	if(results.replicaCount > 0)
+	{
+		out << std::setw(outputColumnWidth) << std::setfill(' ') << std::left << "Absorbed-Replicas: " <<
+		std::right << results.absorbedCount << '/' << results.replicaCount << '\n';
+		if(results.absorbed)
+		{
+			out << std::setw(outputColumnWidth) << std::setfill(' ') << std::left << "Consensus-Time(sweeps): " <<
+			std::right << results.consensusTime << " +/- " << results.consensusTimeError << '\n';
+		}
+	}
+	else if(results.absorbed)
+	{
+		// Every digit of the double, the fraction of the last sweep places the freezing update and the
+		// default 6 digits would round it away once the run is a few sweeps long.
+		std::streamsize precision = out.precision();
+		out << std::setw(outputColumnWidth) << std::setfill(' ') << std::left << "Consensus-Time(sweeps): " <<
+		std::right << std::setprecision(17) << results.consensusTime << std::setprecision(precision) << '\n';
+		out << std::setw(outputColumnWidth) << std::setfill(' ') << std::left << "Winner: " <<
+		std::right << (results.winner > 0 ? "republican" : results.winner < 0 ? "democrat" : "none (frozen by stubborn voters)") << '\n';
+	}
+	return out;
 }
@@ -16,6 +16,26 @@ class VoterResults
 public:
 	/// Order parameter.
 	double orderParameter;
+	/// Error in the order parameter.
+	double orderParameterError;
+	/// Absolute value of the order parameter.
+	double absoluteOrderParameter;
+	/// Error in the absolute value of the order parameter.
+	double absoluteOrderParameterError;
+	/// Square of the order parameter.
+	double squareOrderParameter;
+	/// Whether the lattice reached an absorbing state, where no update can change it.
+	bool absorbed = false;
+	/// Time it did in sweeps, to the update for random sequential sweeps, or the continuous time of the rejection free engine.
+	double consensusTime = 0;
+	/// Winning voter value, +1 for republicans, -1 for democrats and 0 for a mix held by stubborn voters.
+	int winner = 0;
+	/// Number of replicas summarised, 0 for a single run.
+	int replicaCount = 0;
+	/// Number of replicas that were absorbed, consensusTime is then their mean and there is no winner.
+	int absorbedCount = 0;
+	/// Error in the mean consensus time of the absorbed replicas.
+	double consensusTimeError = 0;
 
 	/**
 	 *\brief operator<< overload for outputting the results.
@@ -23,7 +43,9 @@ public:
 	 *\param results constant VoterResults instance to be output.
 	 *\return std::ostream reference so the operator can be chained.
 	 *
-	 * Results will be output in a formatted table for easy viewing in the command line or a file.
+	 * Results will be output in a formatted table for easy viewing in the command line or a file, with
+	 * the consensus time and winner only when the lattice was absorbed. For an ensemble the number of
+	 * absorbed replicas is given instead of the winner.
 	 */
 	friend std::ostream& operator<<(std::ostream& out, const VoterResults &results);
 };
@@ -1,19 +1,41 @@
 #include "VoterArray.hpp"
+#include "FixedVoterArray.hpp"
 #include "getTimeStamp.hpp"
 #include "makeDirectory.hpp"
 #include "VoterInputParameters.hpp"
 #include "DataArray.hpp"
 #include "VoterResults.hpp"
 #include "Timer.hpp"
+#include "ParallelSweeper.hpp"
+#include "RejectionFreeEngine.hpp"
+#include "ThreadPool.hpp"
+#include "Ensemble.hpp"
+#include "Batch.hpp"
+#include "RandomEngine.hpp"
+#include "Trajectory.hpp"
+#include "OutputWriter.hpp"
+#include "Checkpoint.hpp"
+#include "placeStubborn.hpp"
+#include "Graph.hpp"
+#include "VoterGraph.hpp"
+#include "RunningStatistics.hpp"
+#include "Instrumentation.hpp"
+#include "LatticeMemory.hpp"
 #include <random>
 #include <iostream>
 #include <algorithm>
 #include <thread>
 #include <chrono>
 #include <boost/program_options.hpp>
+#include <boost/filesystem.hpp>
 #include <fstream>
+#include <sstream>
 #include <iomanip>
 #include <string>
+#include <memory>
+#include <limits>
+#include <cmath>
+#include <stdexcept>
 
 int main(int argc, char const *argv[])
 {
@@ -24,18 +46,29 @@ int main(int argc, char const *argv[])
     // Start the clock so execution time can be calculated.
     Timer timer;
 
-    // Seed the pseudo random number generator using the system clock.
-    unsigned int seed = static_cast<unsigned int>(std::chrono::system_clock::now().time_since_epoch().count());
-
-    // Create a generator that can be fed to any distribution to produce pseudo random numbers according to that distribution.
-    std::default_random_engine generator(seed);
-
     // Input parameters.
     int rowCount;
     int colCount;
     double initialOrder;
-    int totalSweeps;
-    int stubbornNumber;
+    long long totalSweeps;
+    unsigned long long seed;
+    int threadCount;
+    int replicaCount;
+    int frameStride;
+    int outputQueue;
+    int checkpointInterval;
+    std::string resumeName;
+    std::string batchName;
+    OutputWriter::Policy outputPolicy;
+    VoterArray::Layout layout;
+    long long stubbornNumber;
+    StubbornPlacement stubbornPlacement;
+    std::string stubbornMask;
+    std::string graphName;
+    Graph::Ordering vertexOrdering;
+    double progressInterval;
+    int clusterInterval;
+    LatticeMemory::Mode latticeMemory;
     std::string outputName;
 
     // Set up optional command line arguments.
@@ -47,10 +80,32 @@ int main(int argc, char const *argv[])
         ("column-count,c", boost::program_options::value<int>(&rowCount)->default_value(50), "The number of rows in the lattice.")
         ("row-count,r", boost::program_options::value<int>(&colCount)->default_value(50), "The number of columns in the lattice.")
         ("initail-order,i", boost::program_options::value<double>(&initialOrder)->default_value(0.0), "Initial value of order parameter.")
-        ("sweeps,s", boost::program_options::value<int>(&totalSweeps)->default_value(10000), "The number of sweeps in the simulation.")
-        ("stubborn-number,n", boost::program_options::value<int>(&stubbornNumber)->default_value(0), "The number of Stubborn boters in the population.")
+        ("sweeps,s", boost::program_options::value<long long>(&totalSweeps)->default_value(10000), "The number of sweeps in the simulation.")
+        ("seed", boost::program_options::value<unsigned long long>(&seed), "Seed for the random number generator, taken from the system clock if not given.")
+        ("threads,t", boost::program_options::value<int>(&threadCount)->default_value(1), "The number of threads to split each sweep over, more than one selects the domain decomposed parallel sweep.")
+        ("replicas,R", boost::program_options::value<int>(&replicaCount)->default_value(1), "The number of independent replicas, more than one runs them on the threads and writes a single ensemble summary.")
+        ("layout,l", boost::program_options::value<VoterArray::Layout>(&layout)->default_value(VoterArray::RowMajor), "Memory layout of the lattice, row-major, halo, tiled (8x8 blocks of sites per word) or morton (the blocks along a Z-order curve), the last two for very large lattices.")
+        ("stubborn-number,n", boost::program_options::value<long long>(&stubbornNumber)->default_value(0), "The number of Stubborn boters in the population.")
+        ("stubborn-placement", boost::program_options::value<StubbornPlacement>(&stubbornPlacement)->default_value(RandomStubborn), "Where the stubborn voters go, random sites or a clustered disk around a random site, keeping the opinions they start with.")
+        ("stubborn-mask", boost::program_options::value<std::string>(&stubbornMask), "File with a value per site, row after row, +1 for a stubborn republican, -1 for a stubborn democrat and 0 for a free voter. Replaces the stubborn number and placement.")
         ("output,o",boost::program_options::value<std::string>(&outputName)->default_value(getTimeStamp()), "Name of output directory to save output files into.")
-        ("animate,a","Animate the program by printing the current state of the lattice to an output file during simulation")
+        ("rejection-free,f", "Use the rejection free continuous time engine that only picks sites that can change.")
+        ("synchronous", "Update every site at once from the previous sweep's configuration instead of one random site at a time.")
+        ("multi-spin,m", "Run the replicas of an ensemble 64 at a time, one bit of every site word per replica, the lanes sharing the sequence of updated sites.")
+        ("animate,a","Animate the program by writing the state of the lattice to the binary trajectory during the simulation, convert frames for animate.gp with trajectoryToMatrix")
+        ("frame-stride", boost::program_options::value<int>(&frameStride)->default_value(1), "The number of sweeps between frames of the trajectory when animating.")
+        ("output-queue", boost::program_options::value<int>(&outputQueue)->default_value(8), "The number of batches of records and snapshots that can wait for the output thread.")
+        ("output-policy", boost::program_options::value<OutputWriter::Policy>(&outputPolicy)->default_value(OutputWriter::Block), "What to do with a snapshot when the output queue is full, block or drop.")
+        ("checkpoint-interval", boost::program_options::value<int>(&checkpointInterval)->default_value(0), "The number of sweeps between checkpoints of a single simulation, 0 for none.")
+        ("resume", boost::program_options::value<std::string>(&resumeName), "Continue the simulation checkpointed in this output directory, the input parameters are taken from the checkpoint apart from a larger number of sweeps and the checkpoint interval.")
+        ("batch", boost::program_options::value<std::string>(&batchName), "Run every replica of every point of the parameter grid in this file on the threads, appending to Batch.dat in the output directory. Rerunning with the same output directory skips the finished jobs.")
+        ("graph", boost::program_options::value<std::string>(&graphName), "Put the voters on a graph instead of the square lattice: regular:N:k, small-world:N:k:p, scale-free:N:m, cubic:L or file:edges.txt with two vertex labels per line.")
+        ("vertex-ordering", boost::program_options::value<Graph::Ordering>(&vertexOrdering)->default_value(Graph::RcmOrdering), "Order of the vertices of a graph in memory, none, bfs or rcm (reverse Cuthill-McKee).")
+        ("keep-running", "Keep sweeping after the lattice reaches an absorbing state, consensus or a mix frozen by stubborn voters, instead of stopping there.")
+        ("cluster-interval", boost::program_options::value<int>(&clusterInterval)->default_value(0), "The number of sweeps between analyses of the domains of a single simulation on the lattice, written to Clusters.dat as the number of domains, the fraction of sites in the largest and a histogram of their sizes, 0 for none.")
+        ("cluster-background", "Analyse the domains on the output thread from a copy of the lattice, so the simulation only waits for the copy.")
+        ("lattice-memory", boost::program_options::value<LatticeMemory::Mode>(&latticeMemory)->default_value(LatticeMemory::Transparent), "Where lattices of millions of sites are kept, heap, transparent or explicit huge pages (from /proc/sys/vm/nr_hugepages), or file to map them from unlinked files in the output directory when they are larger than memory.")
+        ("progress-interval", boost::program_options::value<double>(&progressInterval)->default_value(0), "The number of seconds between lines on the standard error with the sweep rate and the estimated time left, 0 for none.")
         ("help,h", "Produce help message");
 
     // Make arguments available to program.
@@ -65,14 +120,369 @@ int main(int argc, char const *argv[])
         return 1;
     }
 
+    if(vm.count("stubborn-mask"))
+    {
+      stubbornPlacement = MaskStubborn;
+    }
+
+    bool rejectionFreeEngine = vm.count("rejection-free");
+    bool synchronousEngine = vm.count("synchronous");
+    bool animate = vm.count("animate") && frameStride > 0;
+
+    // Multi-spin coding only pays off across replicas and has no continuous time version.
+    if(vm.count("multi-spin") && (rejectionFreeEngine || synchronousEngine || replicaCount < 2 || vm.count("batch") || vm.count("resume")))
+    {
+      std::cerr << "the multi-spin engine needs an ensemble of replicas and no other engine\n";
+      return 1;
+    }
+    if(outputQueue < 0)
+    {
+      std::cerr << "the output queue cannot be negative\n";
+      return 1;
+    }
+    if(rejectionFreeEngine && synchronousEngine)
+    {
+      std::cerr << "choose either the rejection free or the synchronous engine\n";
+      return 1;
+    }
+
+    // When continuing a checkpointed simulation every input parameter comes from the checkpoint, only the
+    // number of sweeps can be raised to extend a run and the checkpoint interval changed.
+    Checkpoint checkpoint;
+    bool resume = vm.count("resume");
+    if(resume)
+    {
+      try
+      {
+        checkpoint.load(resumeName+"/Checkpoint.bin");
+      }
+      catch(const std::exception &error)
+      {
+        std::cerr << error.what() << '\n';
+        return 1;
+      }
+
+      rowCount = checkpoint.parameters.rowCount;
+      colCount = checkpoint.parameters.colCount;
+      initialOrder = checkpoint.parameters.initialOrder;
+      if(vm["sweeps"].defaulted() || totalSweeps < checkpoint.sweep)
+      {
+        totalSweeps = checkpoint.parameters.sweeps;
+      }
+      seed = checkpoint.parameters.seed;
+      threadCount = checkpoint.parameters.threadCount;
+      replicaCount = checkpoint.parameters.replicaCount;
+      layout = checkpoint.parameters.layout;
+      stubbornNumber = checkpoint.parameters.stubbornNumber;
+      stubbornPlacement = checkpoint.parameters.stubbornPlacement;
+      stubbornMask = checkpoint.parameters.stubbornMask;
+      outputName = resumeName;
+      rejectionFreeEngine = checkpoint.parameters.engine == "rejection-free";
+      synchronousEngine = checkpoint.parameters.engine == "synchronous";
+      animate = checkpoint.frameStride > 0;
+      frameStride = animate ? checkpoint.frameStride : 1;
+      if(vm["checkpoint-interval"].defaulted())
+      {
+        checkpointInterval = checkpoint.checkpointInterval;
+      }
+    }
+
+    // The domains are found on the square lattice of a single simulation.
+    if(clusterInterval > 0 && (replicaCount > 1 || vm.count("batch") || !graphName.empty()))
+    {
+      std::cerr << "the cluster analysis is for a single simulation on the lattice\n";
+      return 1;
+    }
+
+    // Seed the pseudo random number generator using the system clock unless the user gave a seed, it is
+    // recorded with the input parameters so the run can be reproduced.
+    if(!vm.count("seed") && !resume)
+    {
+      seed = static_cast<unsigned long long>(std::chrono::system_clock::now().time_since_epoch().count());
+    }
+
+    // Create a generator that can be fed to any distribution to produce pseudo random numbers according to that distribution.
+    RandomEngine generator(seed);
+
+    // Summaries of the order parameter trace of a single simulation for Results.txt, the errors from the
+    // blocking analysis since successive sweeps are correlated.
+    RunningStatistics orderParameterStatistics;
+    RunningStatistics absoluteOrderParameterStatistics;
+    double squareOrderParameterSum = 0;
+    auto addOrderParameter = [&](double orderParameter)
+    {
+      orderParameterStatistics.push(orderParameter);
+      absoluteOrderParameterStatistics.push(std::abs(orderParameter));
+      squareOrderParameterSum += orderParameter * orderParameter;
+    };
+    auto summariseOrderParameter = [&]()
+    {
+      VoterResults results;
+      results.orderParameter              = orderParameterStatistics.mean();
+      results.orderParameterError         = orderParameterStatistics.blockingError();
+      results.absoluteOrderParameter      = absoluteOrderParameterStatistics.mean();
+      results.absoluteOrderParameterError = absoluteOrderParameterStatistics.blockingError();
+      results.squareOrderParameter        = orderParameterStatistics.getCount() ? squareOrderParameterSum / orderParameterStatistics.getCount() : 0;
+      return results;
+    };
+
+    // Run a grid of simulations, an existing output directory is reused so that the batch can be restarted.
+    if(vm.count("batch"))
+    {
+      try
+      {
+        Batch batch(batchName, seed);
+        if(!boost::filesystem::exists(outputName))
+        {
+          makeDirectory(outputName);
+        }
+
+        ThreadPool pool(threadCount);
+        std::size_t jobCount = batch.run(pool, outputName+"/Batch.dat");
+        std::cout << "Ran " << jobCount << " of the " << batch.getJobCount() << " jobs of " << batch.getPoints().size()
+                  << " grid points into " << outputName << "/Batch.dat\n";
+      }
+      catch(const std::exception &error)
+      {
+        std::cerr << error.what() << '\n';
+        return 1;
+      }
+
+      std::cout << std::setw(30) << std::setfill(' ') << std::left << "Time take to execute(s) =    " <<
+      std::right << timer.elapsed() << '\n';
+
+      return 0;
+    }
+
     // Create an output directory from either the default time stamp or the user defined string.
-    makeDirectory(outputName);
+    if(!resume)
+    {
+      makeDirectory(outputName);
+    }
+
+    // Large lattices are first written by the threads that will sweep them, see LatticeMemory.hpp.
+    LatticeMemory::configure(latticeMemory, outputName, threadCount);
+
+    // Run a single simulation on a graph instead of the lattice, with the same order parameter output
+    // and a trajectory of one row holding the vertices in their original labels.
+    if(!graphName.empty())
+    {
+      if(replicaCount > 1 || threadCount > 1 || rejectionFreeEngine || synchronousEngine || vm.count("multi-spin") || checkpointInterval > 0 || resume)
+      {
+        std::cerr << "a graph runs a single random sequential simulation without checkpoints\n";
+        return 1;
+      }
+
+      std::unique_ptr<VoterGraph> votersPointer;
+      try
+      {
+        Graph graph = Graph::make(graphName, generator);
+        if(graph.getVertexCount() > static_cast<std::size_t>(std::numeric_limits<int>::max()))
+        {
+          throw std::runtime_error("too many vertices for the trajectory");
+        }
+        graph.reorder(vertexOrdering);
+        votersPointer.reset(new VoterGraph(graph, generator, initialOrder));
+        if(stubbornNumber < 0)
+        {
+          throw std::runtime_error("negative number of stubborn voters");
+        }
+        votersPointer->placeStubborn(stubbornPlacement, stubbornNumber, generator);
+      }
+      catch(const std::exception &error)
+      {
+        std::cerr << error.what() << '\n';
+        return 1;
+      }
+      VoterGraph &voters = *votersPointer;
+      int vertexCount = static_cast<int>(voters.getSize());
+
+      VoterInputParameters inputParameters
+      {
+        1,
+        vertexCount,
+        initialOrder,
+        totalSweeps,
+        seed,
+        1,
+        1,
+        layout,
+        "sequential",
+        stubbornNumber,
+        stubbornPlacement,
+        stubbornMask,
+        outputName,
+        graphName,
+        vertexOrdering
+      };
+
+      std::fstream inputParametersOutput(outputName+"/Input.txt", std::ios::out);
+      std::fstream resultsOutput(outputName+"/Results.txt", std::ios::out);
+      std::cout << inputParameters << '\n';
+      inputParametersOutput << inputParameters << '\n';
+
+      std::vector<std::uint64_t> frame;
+      TrajectoryWriter latticeOutput(outputName+"/Trajectory.bin", 1, vertexCount, animate ? frameStride : 0);
+      voters.packOpinions(frame);
+      latticeOutput.write(frame, 0);
+
+      // Sweep of the last frame handed to the output thread, a dropped one is not in the trajectory.
+      long long lastFrame = 0;
+
+      // Stop at an absorbing state as the lattice does.
+      bool keepRunning = vm.count("keep-running");
+      bool absorbed = voters.frozen();
+      double consensusTime = 0;
+      long long lastSweep = absorbed && !keepRunning ? 0 : totalSweeps;
+
+      Instrumentation instrumentation(0, totalSweeps, progressInterval);
+      {
+        OutputWriter output(outputName+"/OrderParameter.dat", latticeOutput, outputQueue, outputPolicy);
+        for(long long sweep = 0; sweep < lastSweep; ++sweep)
+        {
+          {
+            Instrumentation::Scope scope(instrumentation, Instrumentation::Updates);
+            voters.sweep(generator);
+          }
+
+          if(!absorbed && voters.frozen())
+          {
+            absorbed = true;
+            consensusTime = sweep + 1;
+            if(!keepRunning)
+            {
+              lastSweep = sweep + 1;
+            }
+          }
+
+          double orderParameter;
+          double activeBondDensity;
+          {
+            Instrumentation::Scope scope(instrumentation, Instrumentation::Observables);
+            orderParameter = voters.orderParameter();
+            activeBondDensity = voters.activeBondDensity();
+            addOrderParameter(orderParameter);
+          }
+
+          {
+            Instrumentation::Scope scope(instrumentation, Instrumentation::Output);
+            output.record({sweep, orderParameter, activeBondDensity});
+
+            if(animate && (sweep + 1) % frameStride == 0)
+            {
+              if(output.snapshot(voters, sweep + 1))
+              {
+                lastFrame = sweep + 1;
+              }
+            }
+          }
+
+          instrumentation.progress(sweep + 1, std::cerr);
+        }
+
+        Instrumentation::Scope scope(instrumentation, Instrumentation::Output);
+        output.flush();
+      }
+      instrumentation.setCounters(voters.getCounters());
 
-    // Create an output file for the lattice so it can be animated.
-    std::fstream latticeOutput(outputName+"/Lattice.dat", std::ios::out);
+      if(!animate || lastFrame != lastSweep)
+      {
+        voters.packOpinions(frame);
+        latticeOutput.write(frame, lastSweep);
+      }
+      latticeOutput.close();
 
-    // Create an output file for the order parameter which in this case is the fraction of infected states.
-    std::fstream orderParameterOutput(outputName+"/OrderParameter.dat", std::ios::out);
+      VoterResults results = summariseOrderParameter();
+      if(absorbed)
+      {
+        double orderParameter = voters.orderParameter();
+        results.absorbed = true;
+        results.consensusTime = consensusTime;
+        results.winner = orderParameter == 1 ? 1 : orderParameter == -1 ? -1 : 0;
+      }
+      std::cout << results << '\n' << instrumentation << '\n';
+      resultsOutput << results << '\n' << instrumentation << '\n';
+
+      std::cout << std::setw(30) << std::setfill(' ') << std::left << "Time take to execute(s) =    " <<
+      std::right << timer.elapsed() << '\n';
+
+      return 0;
+    }
+
+    // Run an ensemble of independent replicas on a thread pool instead of a single simulation.
+    if(replicaCount > 1)
+    {
+      // The replicas place their stubborn voters on the pool, so catch what can be caught up front.
+      if(stubbornPlacement == MaskStubborn)
+      {
+        try
+        {
+          checkStubbornMask(stubbornMask, rowCount, colCount);
+        }
+        catch(const std::exception &error)
+        {
+          std::cerr << error.what() << '\n';
+          return 1;
+        }
+      }
+      else if(stubbornNumber < 0 || stubbornNumber > static_cast<long long>(rowCount) * colCount)
+      {
+        std::cerr << "cannot place the stubborn voters\n";
+        return 1;
+      }
+
+      ThreadPool pool(threadCount);
+
+      VoterInputParameters inputParameters
+      {
+        rowCount,
+        colCount,
+        initialOrder,
+        totalSweeps,
+        seed,
+        pool.getThreadCount(),
+        replicaCount,
+        layout,
+        vm.count("multi-spin") ? "multi-spin" : rejectionFreeEngine ? "rejection-free" : synchronousEngine ? "synchronous" : "sequential",
+        stubbornNumber,
+        stubbornPlacement,
+        stubbornMask,
+        outputName,
+        "",
+        Graph::NoOrdering
+      };
+
+      std::fstream inputParametersOutput(outputName+"/Input.txt", std::ios::out);
+      std::cout << inputParameters << '\n';
+      inputParametersOutput << inputParameters << '\n';
+
+      Ensemble ensemble(inputParameters, replicaCount, generator);
+      try
+      {
+        ensemble.run(pool);
+      }
+      catch(const std::exception &error)
+      {
+        std::cerr << error.what() << '\n';
+        return 1;
+      }
+
+      // One summary of the per sweep moments and the final results replaces the per replica files.
+      std::fstream ensembleOutput(outputName+"/Ensemble.dat", std::ios::out);
+      ensembleOutput << ensemble;
+      std::fstream replicaOutput(outputName+"/Replicas.dat", std::ios::out);
+      ensemble.writeReplicas(replicaOutput);
+
+      VoterResults results = ensemble.results();
+      std::fstream resultsOutput(outputName+"/Results.txt", std::ios::out);
+      std::cout << results << '\n';
+      resultsOutput << results << '\n';
+
+      std::cout << std::setw(30) << std::setfill(' ') << std::left << "Time take to execute(s) =    " <<
+      std::right << timer.elapsed() << '\n';
+
+      return 0;
+    }
 
     // Create an output file for the input parameters.
     std::fstream inputParametersOutput(outputName+"/Input.txt", std::ios::out);
@@ -80,13 +490,135 @@ int main(int argc, char const *argv[])
     // Create an output file for the results.
     std::fstream resultsOutput(outputName+"/Results.txt", std::ios::out);
 
-    // Create a Voter lattice that will be used in the simulation.
-    VoterArray lattice(generator,rowCount, colCount, initialOrder);
+    // Create a Voter lattice that will be used in the simulation, specialised for its size if possible.
+    std::unique_ptr<VoterArray> latticePointer = makeVoterArray(generator, rowCount, colCount, initialOrder, layout);
+    VoterArray &lattice = *latticePointer;
+    if(resume)
+    {
+      lattice.unpackStates(checkpoint.opinions, checkpoint.stubborn);
+    }
+
+    // Make the correct number of voters stubborn, a resumed lattice already has them.
+    if(!resume)
+    {
+      try
+      {
+        placeStubborn(lattice, stubbornPlacement, stubbornNumber, stubbornMask, generator);
+      }
+      catch(const std::exception &error)
+      {
+        std::cerr << error.what() << '\n';
+        return 1;
+      }
+    }
+    stubbornNumber = static_cast<long long>(lattice.getStubbornCount());
+
+    // Set up the requested update engine, the random sequential update is used if there is no other.
+    std::string engine = "sequential";
+    std::unique_ptr<ParallelSweeper> sweeper;
+    std::unique_ptr<RejectionFreeEngine> rejectionFree;
+    if(rejectionFreeEngine)
+    {
+      rejectionFree.reset(new RejectionFreeEngine(lattice));
+      engine = "rejection-free";
+      threadCount = 1;
+    }
+    else if(synchronousEngine)
+    {
+      engine = "synchronous";
+      threadCount = 1;
+    }
+    else if(threadCount > 1)
+    {
+      // Start the worker threads.
+      sweeper.reset(new ParallelSweeper(lattice, threadCount, generator));
+      threadCount = sweeper->getThreadCount();
+      engine = "parallel";
+    }
+
+    // Put the generators back where they were, the engines are set up so that they would draw the same
+    // numbers from the main generator as in the checkpointed run.
+    if(resume)
+    {
+      generator.setState(checkpoint.generator);
+
+      std::istringstream engineState(checkpoint.engineState, std::ios::in | std::ios::binary);
+      if(rejectionFree)
+      {
+        rejectionFree->loadState(engineState);
+      }
+      else if(sweeper)
+      {
+        sweeper->loadState(engineState);
+      }
+    }
+
+    // Create a binary trajectory for the lattice so it can be animated, without animation it only holds the
+    // initial and final lattices and the stride is recorded as 0.
+    // When resuming both files are cut back to what they held at the checkpoint and appended to.
+    std::unique_ptr<TrajectoryWriter> trajectoryPointer;
+    if(resume)
+    {
+      trajectoryPointer.reset(new TrajectoryWriter(outputName+"/Trajectory.bin", lattice.getRows(), lattice.getCols(),
+        animate ? frameStride : 0, checkpoint.trajectoryIndex, checkpoint.trajectoryBytes));
+      boost::filesystem::resize_file(outputName+"/OrderParameter.dat", checkpoint.orderParameterBytes);
+
+      // The summaries for Results.txt cover the whole run, so start them from the trace so far.
+      std::ifstream orderParameterInput(outputName+"/OrderParameter.dat");
+      std::string line;
+      while(std::getline(orderParameterInput, line))
+      {
+        std::istringstream fields(line);
+        long long sweep;
+        double orderParameter;
+        if(fields >> sweep >> orderParameter)
+        {
+          addOrderParameter(orderParameter);
+        }
+      }
+    }
+    else
+    {
+      trajectoryPointer.reset(new TrajectoryWriter(outputName+"/Trajectory.bin", lattice.getRows(), lattice.getCols(), animate ? frameStride : 0));
+
+      // Print the initial lattice to the trajectory.
+      trajectoryPointer->write(lattice, 0);
+    }
+    TrajectoryWriter &latticeOutput = *trajectoryPointer;
+
+    // Hand the order parameter file and the rest of the trajectory to the output thread.
+    OutputWriter output(outputName+"/OrderParameter.dat", latticeOutput, outputQueue, outputPolicy, resume);
 
-    // Make the correct number of voters stubborn.
+    // Analyse the domains every few sweeps into a histogram per line. When resuming the lines after the
+    // checkpoint are dropped, they are written again.
+    std::string clusterFile = outputName+"/Clusters.dat";
+    if(clusterInterval > 0)
+    {
+      bool append = resume && boost::filesystem::exists(clusterFile);
+      if(append)
+      {
+        std::ifstream clusterInput(clusterFile);
+        std::ostringstream kept;
+        std::string line;
+        while(std::getline(clusterInput, line))
+        {
+          std::istringstream fields(line);
+          long long sweep;
+          if(line.empty() || line[0] == '#' || (fields >> sweep && sweep <= checkpoint.sweep))
+          {
+            kept << line << '\n';
+          }
+        }
+        clusterInput.close();
+        std::ofstream(clusterFile) << kept.str();
+      }
 
-    // Print the initial lattice to an output file.
-    latticeOutput << lattice;
+      output.enableClusters(clusterFile, lattice.getRows(), lattice.getCols(), vm.count("cluster-background"), append);
+      if(!resume)
+      {
+        output.clusters(lattice, 0);
+      }
+    }
 
     // Create an object to hold the input parameters.
     VoterInputParameters inputParameters
@@ -95,43 +627,210 @@ int main(int argc, char const *argv[])
       colCount,
       initialOrder,
       totalSweeps,
+      seed,
+      threadCount,
+      replicaCount,
+      layout,
+      engine,
       stubbornNumber,
-      outputName
+      stubbornPlacement,
+      stubbornMask,
+      outputName,
+      "",
+      Graph::NoOrdering
     };
 
     // Print the input parameters to the command line and to the output file.
     std::cout << inputParameters << '\n';
     inputParametersOutput << inputParameters << '\n';
 
+    // The time the lattice froze is found to the sweep, or to the flip for the rejection free engine,
+    // which keeps its own clock. A resumed run takes it from the checkpoint.
+    bool keepRunning = vm.count("keep-running");
+    bool absorbed = resume ? checkpoint.absorbed : lattice.frozen();
+    double consensusTime = resume ? checkpoint.consensusTime : 0;
 
+    // Write everything needed to continue from the given number of sweeps, a failure is reported but
+    // does not stop the simulation.
+    auto saveCheckpoint = [&](long long sweepsDone)
+    {
+      // Once the output thread has caught up the files hold exactly the output up to this sweep.
+      output.flush();
+
+      checkpoint.parameters = inputParameters;
+      checkpoint.frameStride = animate ? frameStride : 0;
+      checkpoint.checkpointInterval = checkpointInterval;
+      checkpoint.sweep = sweepsDone;
+      checkpoint.absorbed = absorbed;
+      checkpoint.consensusTime = consensusTime;
+      generator.getState(checkpoint.generator);
+      lattice.packOpinions(checkpoint.opinions);
+      lattice.packStubborn(checkpoint.stubborn);
+
+      std::ostringstream engineState(std::ios::out | std::ios::binary);
+      if(rejectionFree)
+      {
+        rejectionFree->saveState(engineState);
+      }
+      else if(sweeper)
+      {
+        sweeper->saveState(engineState);
+      }
+      checkpoint.engineState = engineState.str();
+
+      checkpoint.trajectoryBytes = latticeOutput.getByteCount();
+      checkpoint.trajectoryIndex = latticeOutput.getIndex();
+
+      try
+      {
+        checkpoint.orderParameterBytes = boost::filesystem::file_size(outputName+"/OrderParameter.dat");
+        Checkpoint::syncFile(outputName+"/OrderParameter.dat");
+        Checkpoint::syncFile(outputName+"/Trajectory.bin");
+        if(clusterInterval > 0)
+        {
+          Checkpoint::syncFile(clusterFile);
+        }
+        checkpoint.save(outputName+"/Checkpoint.bin");
+      }
+      catch(const std::exception &error)
+      {
+        std::cerr << "Checkpoint at sweep " << sweepsDone << " failed: " << error.what() << '\n';
+      }
+    };
 
 /*************************************************************************************************************************
 ************************************************* Main Loop *************************************************************
 *************************************************************************************************************************/
 
 
-   for(int sweep = 0; sweep < totalSweeps; ++sweep )
+   // Time spent in each phase of the loop and the progress lines, see Instrumentation.hpp.
+   long long firstSweep = resume ? checkpoint.sweep : 0;
+   Instrumentation instrumentation(firstSweep, totalSweeps, progressInterval);
+
+   // Once no update can change the lattice the run stops, a resumed run that had already frozen stops
+   // straight away.
+   long long lastSweep = absorbed && !keepRunning ? firstSweep : totalSweeps;
+
+   // Sweep of the last frame in the trajectory, so the final lattice is added if its snapshot was dropped.
+   long long lastFrame = resume && !checkpoint.trajectoryIndex.empty() ? static_cast<long long>(checkpoint.trajectoryIndex[checkpoint.trajectoryIndex.size() - 2]) : 0;
+
+   for(long long sweep = firstSweep; sweep < lastSweep; ++sweep )
    {
-      // Update the lattice by performing row*col sweeps.
-      for(int i = 0; i < lattice.getSize(); ++i)
       {
-        lattice.update(generator);
+        Instrumentation::Scope scope(instrumentation, Instrumentation::Updates);
+
+        // Update the lattice by performing row*col updates, split over the threads if there are any.
+        if(rejectionFree)
+        {
+          rejectionFree->advance(sweep + 1, generator);
+        }
+        else if(sweeper)
+        {
+          sweeper->sweep();
+        }
+        else if(synchronousEngine)
+        {
+          lattice.synchronousSweep(generator);
+        }
+        else
+        {
+          lattice.sweep(generator);
+        }
       }
 
-        // Calculate the fraction of infected sites on this sweep.
-        double orderParameter = lattice.orderParameter();
-
-        // Output the fraction of infected states and the current sweep.
-        orderParameterOutput << sweep << ' ' <<  orderParameter << '\n';
+      // The running active bond count makes the test O(1).
+      bool stopping = false;
+      if(!absorbed && lattice.frozen())
+      {
+        absorbed = true;
+        // The random sequential sweep knows the update that froze the lattice, the others only the sweep.
+        if(rejectionFree)
+        {
+          consensusTime = rejectionFree->getTime();
+        }
+        else if(sweeper || synchronousEngine)
+        {
+          consensusTime = sweep + 1;
+        }
+        else
+        {
+          consensusTime = sweep + lattice.freezingFraction();
+        }
+        if(!keepRunning)
+        {
+          lastSweep = sweep + 1;
+          stopping = true;
+        }
+      }
 
-      if(vm.count("animate"))
+      double orderParameter;
+      double activeBondDensity;
       {
-        // Move to the top of the file.
-      latticeOutput.seekg(0,std::ios::beg);
+        Instrumentation::Scope scope(instrumentation, Instrumentation::Observables);
+
+        // Calculate the fraction of infected sites on this sweep and the fraction of bonds across an interface.
+        orderParameter = lattice.orderParameter();
+        activeBondDensity = lattice.activeBondDensity();
+        addOrderParameter(orderParameter);
+
+        // Find the domains, or only copy the lattice for the output thread to do so.
+        if(clusterInterval > 0 && (sweep + 1) % clusterInterval == 0)
+        {
+          output.clusters(lattice, sweep + 1);
+        }
+      }
 
-      // Output the current state of the lattice.
-      latticeOutput << lattice << std::flush;
+      {
+        Instrumentation::Scope scope(instrumentation, Instrumentation::Output);
+
+        // Output the fraction of infected states and of active bonds and the current sweep.
+        output.record({sweep, orderParameter, activeBondDensity});
+
+        // Append a frame labelled with the number of sweeps done.
+        if(animate && (sweep + 1) % frameStride == 0)
+        {
+          if(output.snapshot(lattice, sweep + 1))
+          {
+            lastFrame = sweep + 1;
+          }
+        }
+
+        // Checkpoint periodically and at the end, so that a finished run can be extended.
+        if(checkpointInterval > 0 && ((sweep + 1) % checkpointInterval == 0 || sweep + 1 == totalSweeps || stopping))
+        {
+          saveCheckpoint(sweep + 1);
+        }
       }
+
+      instrumentation.progress(sweep + 1, std::cerr);
+   }
+
+   // Analyse the final lattice too, unless that has been done or no sweep was run.
+   if(clusterInterval > 0 && lastSweep > firstSweep && lastSweep % clusterInterval != 0)
+   {
+     Instrumentation::Scope scope(instrumentation, Instrumentation::Observables);
+     output.clusters(lattice, lastSweep);
+   }
+
+   // Wait for the output thread to catch up, after which the trajectory can be written to directly.
+   {
+     Instrumentation::Scope scope(instrumentation, Instrumentation::Output);
+     output.flush();
+   }
+   instrumentation.setCounters(lattice.getCounters());
+   if(output.getDroppedCount())
+   {
+     std::cout << "Snapshots dropped by the output queue: " << output.getDroppedCount() << '\n';
+   }
+
+   // Make sure the final lattice is in the trajectory.
+   {
+     Instrumentation::Scope scope(instrumentation, Instrumentation::Output);
+     if(!animate || lastFrame != lastSweep)
+     {
+       latticeOutput.write(lattice, lastSweep);
+     }
+     latticeOutput.close();
    }
 
 
@@ -139,11 +838,21 @@ int main(int argc, char const *argv[])
 ******************************************** Output/Clean Up *************************************************************
 **************************************************************************************************************************/
 
-   // Output the results to the command line.
-   //std::cout << results << '\n';
+   // Summarise the order parameter trace, and the absorbing state if there was one.
+   VoterResults results = summariseOrderParameter();
+   if(absorbed)
+   {
+     double orderParameter = lattice.orderParameter();
+     results.absorbed = true;
+     results.consensusTime = consensusTime;
+     results.winner = orderParameter == 1 ? 1 : orderParameter == -1 ? -1 : 0;
+   }
+
+   // Output the results and where the time went to the command line.
+   std::cout << results << '\n' << instrumentation << '\n';
 
-   // Output the results to the output file.
-   //resultsOutput << results << '\n';
+   // Output the results and where the time went to the output file.
+   resultsOutput << results << '\n' << instrumentation << '\n';
 
    // Report how long the program took to execute.
    std::cout << std::setw(30) << std::setfill(' ') << std::left << "Time take to execute(s) =    " <<
@@ -0,0 +1,209 @@
+#include "placeStubborn.hpp"
+#include <vector>
+#include <fstream>
+#include <algorithm> // For std::stable_sort and std::min.
+#include <cmath> // For std::sqrt and std::ceil.
+#include <stdexcept>
+
+namespace
+{
+	/**
+	 *\brief Makes the voter at a site stubborn with the opinion it has.
+	 *\return false if it already was stubborn.
+	 */
+	bool makeStubborn(VoterArray &lattice, int row, int col)
+	{
+		VoterArray::State state = lattice(row, col);
+		if(state & 2)
+		{
+			return false;
+		}
+		lattice.setState(row, col, static_cast<VoterArray::State>(state | 2));
+		return true;
+	}
+
+	void placeRandom(VoterArray &lattice, long long count, RandomEngine &generator)
+	{
+		long long placed = 0;
+		while(placed < count)
+		{
+			std::uint64_t word = generator();
+			int row = static_cast<int>(takeBounded(word, lattice.getRows()));
+			int col = static_cast<int>(takeBounded(word, lattice.getCols()));
+			placed += makeStubborn(lattice, row, col);
+		}
+	}
+
+	void placeClustered(VoterArray &lattice, long long count, RandomEngine &generator)
+	{
+		int rows = lattice.getRows();
+		int cols = lattice.getCols();
+
+		std::uint64_t word = generator();
+		int centreRow = static_cast<int>(takeBounded(word, rows));
+		int centreCol = static_cast<int>(takeBounded(word, cols));
+
+		// Offsets in a box around the centre, clipped so that no two wrap onto the same site, grown until
+		// it holds enough sites.
+		std::vector<std::pair<int,int> > offsets;
+		int radius = static_cast<int>(std::ceil(std::sqrt(count / 3.14159265358979))) + 1;
+		while(true)
+		{
+			int rowLow = -std::min(radius, (rows - 1) / 2);
+			int rowHigh = std::min(radius, rows / 2);
+			int colLow = -std::min(radius, (cols - 1) / 2);
+			int colHigh = std::min(radius, cols / 2);
+
+			if(static_cast<long long>(rowHigh - rowLow + 1) * (colHigh - colLow + 1) >= count)
+			{
+				for(int dr = rowLow; dr <= rowHigh; ++dr)
+				{
+					for(int dc = colLow; dc <= colHigh; ++dc)
+					{
+						offsets.emplace_back(dr, dc);
+					}
+				}
+				break;
+			}
+			radius *= 2;
+		}
+
+		// Nearest sites first, ties keep the scan order so the cluster is reproducible.
+		std::stable_sort(offsets.begin(), offsets.end(), [](const std::pair<int,int> &a, const std::pair<int,int> &b)
+		{
+			return a.first * a.first + a.second * a.second < b.first * b.first + b.second * b.second;
+		});
+
+		for(long long i = 0; i < count; ++i)
+		{
+			makeStubborn(lattice, centreRow + offsets[i].first, centreCol + offsets[i].second);
+		}
+	}
+
+	void placeMask(VoterArray &lattice, const std::string &maskFile)
+	{
+		std::ifstream in(maskFile);
+		if(!in)
+		{
+			throw std::runtime_error("cannot open stubborn mask " + maskFile);
+		}
+
+		for(int row = 0; row < lattice.getRows(); ++row)
+		{
+			for(int col = 0; col < lattice.getCols(); ++col)
+			{
+				int value;
+				if(!(in >> value))
+				{
+					throw std::runtime_error("stubborn mask " + maskFile + " has fewer values than sites");
+				}
+
+				if(value > 0)
+				{
+					lattice.setState(row, col, VoterArray::RepublicanStubborn);
+				}
+				else if(value < 0)
+				{
+					lattice.setState(row, col, VoterArray::DemocratStubborn);
+				}
+			}
+		}
+
+		std::string rest;
+		if(in >> rest)
+		{
+			throw std::runtime_error("stubborn mask " + maskFile + " has more values than sites");
+		}
+	}
+}
+
+void checkStubbornMask(const std::string &maskFile, int rows, int cols)
+{
+	std::ifstream in(maskFile);
+	if(!in)
+	{
+		throw std::runtime_error("cannot open stubborn mask " + maskFile);
+	}
+
+	long long siteCount = static_cast<long long>(rows) * cols;
+	long long valueCount = 0;
+	int value;
+	while(valueCount < siteCount && in >> value)
+	{
+		++valueCount;
+	}
+	if(valueCount < siteCount)
+	{
+		throw std::runtime_error("stubborn mask " + maskFile + " has fewer values than sites");
+	}
+
+	std::string rest;
+	if(in >> rest)
+	{
+		throw std::runtime_error("stubborn mask " + maskFile + " has more values than sites");
+	}
+}
+
+void placeStubborn(VoterArray &lattice, StubbornPlacement placement, long long count, const std::string &maskFile, RandomEngine &generator)
+{
+	if(placement == MaskStubborn)
+	{
+		placeMask(lattice, maskFile);
+		return;
+	}
+
+	// Only sites that are not stubborn yet can be chosen.
+	long long available = static_cast<long long>(lattice.getSize()) - static_cast<long long>(lattice.getStubbornCount());
+	if(count < 0 || count > available)
+	{
+		throw std::runtime_error("number of stubborn voters exceeds the number of sites");
+	}
+
+	if(placement == ClusteredStubborn)
+	{
+		placeClustered(lattice, count, generator);
+	}
+	else
+	{
+		placeRandom(lattice, count, generator);
+	}
+}
+
+std::ostream& operator<<(std::ostream& out, StubbornPlacement placement)
+{
+	switch(placement)
+	{
+		case RandomStubborn:
+			return out << "random";
+		case ClusteredStubborn:
+			return out << "clustered";
+		case MaskStubborn:
+			return out << "mask";
+	}
+	return out;
+}
+
+std::istream& operator>>(std::istream& in, StubbornPlacement &placement)
+{
+	std::string name;
+	in >> name;
+
+	if(name == "random")
+	{
+		placement = RandomStubborn;
+	}
+	else if(name == "clustered")
+	{
+		placement = ClusteredStubborn;
+	}
+	else if(name == "mask")
+	{
+		placement = MaskStubborn;
+	}
+	else
+	{
+		in.setstate(std::ios::failbit);
+	}
+
+	return in;
+}
@@ -0,0 +1,67 @@
+#ifndef placeStubborn_hpp
+#define placeStubborn_hpp
+
+#include <iostream>
+#include <string>
+#include "VoterArray.hpp"
+#include "RandomEngine.hpp"
+
+/**
+ * \enum StubbornPlacement
+ * \brief Where the stubborn voters are put in the lattice.
+ *
+ * RandomStubborn picks sites uniformly at random, ClusteredStubborn fills the disk of sites closest to
+ * a random centre (wrapping around the periodic boundaries) and MaskStubborn reads them from a file.
+ */
+enum StubbornPlacement
+{
+	RandomStubborn,
+	ClusteredStubborn,
+	MaskStubborn,
+};
+
+/**
+ *\file
+ *\brief function to make some of the voters in a lattice stubborn.
+ *\param lattice VoterArray reference whose voters are made stubborn.
+ *\param placement where the stubborn voters go.
+ *\param count number of stubborn voters, ignored for a mask.
+ *\param maskFile name of the mask file, only used for a mask.
+ *\param generator RandomEngine reference for choosing the sites.
+ *
+ * Random and clustered voters keep the opinion they had. A mask file holds one whitespace separated
+ * value per site, row after row: 0 leaves the site as it is, +1 makes it a stubborn republican and -1 a
+ * stubborn democrat, the symbols of operator<<(std::ostream&, const VoterArray&). Throws
+ * std::runtime_error if the count exceeds the number of sites or the mask cannot be read or has the
+ * wrong number of values.
+ */
+void placeStubborn(VoterArray &lattice, StubbornPlacement placement, long long count, const std::string &maskFile, RandomEngine &generator);
+
+/**
+ *\brief Checks that a mask file fits a lattice before any voter is placed from it.
+ *\param maskFile name of the mask file.
+ *\param rows number of rows in the lattice.
+ *\param cols number of columns in the lattice.
+ *
+ * Throws std::runtime_error, with the message placeStubborn() would give, if the mask cannot be read
+ * or does not hold exactly one value per site.
+ */
+void checkStubbornMask(const std::string &maskFile, int rows, int cols);
+
+/**
+ *\brief streams the name of a placement, random, clustered or mask.
+ *\param out std::ostream reference that is being streamed to.
+ *\param placement the placement to print.
+ *\return std::ostream reference to output can be chained.
+ */
+std::ostream& operator<<(std::ostream& out, StubbornPlacement placement);
+
+/**
+ *\brief reads the name of a placement, random, clustered or mask, setting the failbit for any other name.
+ *\param in std::istream reference that is being read from.
+ *\param placement the placement that is read.
+ *\return std::istream reference so input can be chained.
+ */
+std::istream& operator>>(std::istream& in, StubbornPlacement &placement);
+
+#endif /* placeStubborn_hpp */
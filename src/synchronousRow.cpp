@@ -0,0 +1,183 @@
+#include "synchronousRow.hpp"
+#include <cstring> // For std::strcmp.
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h> // For the AVX2 and AVX-512 intrinsics.
+#define SYNCHRONOUS_ROW_X86
+#endif
+
+namespace
+{
+	/// Signature shared by the kernels.
+	typedef void (*Kernel)(const std::uint64_t*, const std::uint64_t*, const std::uint64_t*, const std::uint64_t*,
+		const std::uint64_t*, const std::uint64_t*, std::uint64_t*, std::size_t, std::size_t);
+
+	/**
+	 *\brief Updates words [begin,words) of a row one word at a time, see synchronousRow().
+	 */
+	void scalarRow(const std::uint64_t *row, const std::uint64_t *up, const std::uint64_t *down, const std::uint64_t *stubborn,
+		const std::uint64_t *high, const std::uint64_t *low, std::uint64_t *next, std::size_t begin, std::size_t words)
+	{
+		for(std::size_t w = begin; w < words; ++w)
+		{
+			// Bit c of right holds site c+1 and bit c of left site c-1.
+			std::uint64_t right = (row[w] >> 1) | (row[w + 1] << 63);
+			std::uint64_t left  = (row[w] << 1) | (row[w - 1] >> 63);
+
+			std::uint64_t chosen = (~high[w] & ((~low[w] & right) | (low[w] & down[w]))) |
+			                       ( high[w] & ((~low[w] & left)  | (low[w] & up[w])));
+			next[w] = (row[w] & stubborn[w]) | (chosen & ~stubborn[w]);
+		}
+	}
+
+#ifdef SYNCHRONOUS_ROW_X86
+	/**
+	 *\brief Updates a row four words at a time with AVX2, see synchronousRow().
+	 */
+	__attribute__((target("avx2")))
+	void avx2Row(const std::uint64_t *row, const std::uint64_t *up, const std::uint64_t *down, const std::uint64_t *stubborn,
+		const std::uint64_t *high, const std::uint64_t *low, std::uint64_t *next, std::size_t, std::size_t words)
+	{
+		std::size_t w = 0;
+		for(; w + 4 <= words; w += 4)
+		{
+			// The neighbouring words come from unaligned loads one word either side.
+			__m256i centre   = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + w));
+			__m256i after    = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + w + 1));
+			__m256i before   = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + w - 1));
+			__m256i right    = _mm256_or_si256(_mm256_srli_epi64(centre, 1), _mm256_slli_epi64(after, 63));
+			__m256i left     = _mm256_or_si256(_mm256_slli_epi64(centre, 1), _mm256_srli_epi64(before, 63));
+			__m256i highBits = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(high + w));
+			__m256i lowBits  = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(low + w));
+			__m256i upBits   = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(up + w));
+			__m256i downBits = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(down + w));
+			__m256i fixed    = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(stubborn + w));
+
+			// andnot(a,b) is ~a & b, so each select is an andnot and an and.
+			__m256i horizontal = _mm256_or_si256(_mm256_andnot_si256(lowBits, right), _mm256_and_si256(lowBits, downBits));
+			__m256i vertical   = _mm256_or_si256(_mm256_andnot_si256(lowBits, left), _mm256_and_si256(lowBits, upBits));
+			__m256i chosen     = _mm256_or_si256(_mm256_andnot_si256(highBits, horizontal), _mm256_and_si256(highBits, vertical));
+
+			// Blend the stubborn sites back in.
+			__m256i result = _mm256_or_si256(_mm256_and_si256(fixed, centre), _mm256_andnot_si256(fixed, chosen));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(next + w), result);
+		}
+		scalarRow(row, up, down, stubborn, high, low, next, w, words);
+	}
+
+	/**
+	 *\brief Updates a row eight words at a time with AVX-512, see synchronousRow().
+	 */
+	__attribute__((target("avx512f")))
+	void avx512Row(const std::uint64_t *row, const std::uint64_t *up, const std::uint64_t *down, const std::uint64_t *stubborn,
+		const std::uint64_t *high, const std::uint64_t *low, std::uint64_t *next, std::size_t, std::size_t words)
+	{
+		std::size_t w = 0;
+		for(; w + 8 <= words; w += 8)
+		{
+			__m512i centre   = _mm512_loadu_si512(row + w);
+			__m512i after    = _mm512_loadu_si512(row + w + 1);
+			__m512i before   = _mm512_loadu_si512(row + w - 1);
+			__m512i right    = _mm512_or_si512(_mm512_srli_epi64(centre, 1), _mm512_slli_epi64(after, 63));
+			__m512i left     = _mm512_or_si512(_mm512_slli_epi64(centre, 1), _mm512_srli_epi64(before, 63));
+			__m512i highBits = _mm512_loadu_si512(high + w);
+			__m512i lowBits  = _mm512_loadu_si512(low + w);
+			__m512i upBits   = _mm512_loadu_si512(up + w);
+			__m512i downBits = _mm512_loadu_si512(down + w);
+			__m512i fixed    = _mm512_loadu_si512(stubborn + w);
+
+			// Each select is a single ternary logic instruction, 0xCA being a ? b : c bit by bit.
+			__m512i horizontal = _mm512_ternarylogic_epi64(lowBits, downBits, right, 0xCA);
+			__m512i vertical   = _mm512_ternarylogic_epi64(lowBits, upBits, left, 0xCA);
+			__m512i chosen     = _mm512_ternarylogic_epi64(highBits, vertical, horizontal, 0xCA);
+			_mm512_storeu_si512(next + w, _mm512_ternarylogic_epi64(fixed, centre, chosen, 0xCA));
+		}
+		scalarRow(row, up, down, stubborn, high, low, next, w, words);
+	}
+#endif
+
+	/**
+	 *\brief Picks the widest kernel the processor supports.
+	 *\param name set to the name of the kernel.
+	 *\return the kernel.
+	 */
+	Kernel selectKernel(const char *&name)
+	{
+#ifdef SYNCHRONOUS_ROW_X86
+		__builtin_cpu_init();
+		if(__builtin_cpu_supports("avx512f"))
+		{
+			name = "avx512";
+			return avx512Row;
+		}
+		if(__builtin_cpu_supports("avx2"))
+		{
+			name = "avx2";
+			return avx2Row;
+		}
+#endif
+		name = "scalar";
+		return scalarRow;
+	}
+
+	/// Name of the kernel in use.
+	const char *kernelName = "";
+
+	/// The kernel in use, chosen once before main() runs.
+	const Kernel kernel = selectKernel(kernelName);
+}
+
+void synchronousRow(
+	const std::uint64_t *row,
+	const std::uint64_t *up,
+	const std::uint64_t *down,
+	const std::uint64_t *stubborn,
+	const std::uint64_t *high,
+	const std::uint64_t *low,
+	std::uint64_t *next,
+	std::size_t words
+	)
+{
+	kernel(row, up, down, stubborn, high, low, next, 0, words);
+}
+
+bool synchronousRowWith(
+	const char *name,
+	const std::uint64_t *row,
+	const std::uint64_t *up,
+	const std::uint64_t *down,
+	const std::uint64_t *stubborn,
+	const std::uint64_t *high,
+	const std::uint64_t *low,
+	std::uint64_t *next,
+	std::size_t words
+	)
+{
+	Kernel named = nullptr;
+	if(std::strcmp(name, "scalar") == 0)
+	{
+		named = scalarRow;
+	}
+#ifdef SYNCHRONOUS_ROW_X86
+	else if(std::strcmp(name, "avx2") == 0 && __builtin_cpu_supports("avx2"))
+	{
+		named = avx2Row;
+	}
+	else if(std::strcmp(name, "avx512") == 0 && __builtin_cpu_supports("avx512f"))
+	{
+		named = avx512Row;
+	}
+#endif
+
+	if(!named)
+	{
+		return false;
+	}
+	named(row, up, down, stubborn, high, low, next, 0, words);
+	return true;
+}
+
+const char* synchronousRowKernel()
+{
+	return kernelName;
+}
@@ -0,0 +1,63 @@
+#ifndef synchronousRow_hpp
+#define synchronousRow_hpp
+
+#include <cstdint>
+#include <cstddef>
+
+/**
+ *\file
+ *\brief function to update a whole row of a row aligned bitplane synchronously.
+ *
+ * Every site of the row copies the opinion of the neighbour picked by its bits in high and low, 0 0 right,
+ * 0 1 down, 1 0 left and 1 1 up as in VoterArray::updateSite(), while the stubborn sites keep their own.
+ * The right and left neighbours are the next and previous bits of the row, so the first and last sites
+ * of the row get the bit beyond the row and must be put right by the caller when their neighbour is
+ * across the periodic boundary.
+ *
+ * The row is processed with AVX-512 or AVX2 when the processor has them and 64 sites at a time
+ * otherwise, all of which give the same bits.
+ *
+ *\param row current opinions of the row, row[-1] and row[words] must be readable.
+ *\param up current opinions of the row above.
+ *\param down current opinions of the row below.
+ *\param stubborn stubborn flags of the row.
+ *\param high high bits of the directions.
+ *\param low low bits of the directions.
+ *\param next the new opinions of the row are written here.
+ *\param words number of words in the row.
+ */
+void synchronousRow(
+	const std::uint64_t *row,
+	const std::uint64_t *up,
+	const std::uint64_t *down,
+	const std::uint64_t *stubborn,
+	const std::uint64_t *high,
+	const std::uint64_t *low,
+	std::uint64_t *next,
+	std::size_t words
+	);
+
+/**
+ *\brief Updates a row as synchronousRow() does with a named kernel, so the kernels can be checked against each other.
+ *\param kernel avx512, avx2 or scalar.
+ *\return false, leaving next unchanged, if the processor cannot run the kernel.
+ */
+bool synchronousRowWith(
+	const char *kernel,
+	const std::uint64_t *row,
+	const std::uint64_t *up,
+	const std::uint64_t *down,
+	const std::uint64_t *stubborn,
+	const std::uint64_t *high,
+	const std::uint64_t *low,
+	std::uint64_t *next,
+	std::size_t words
+	);
+
+/**
+ *\brief Getter for the name of the instruction set synchronousRow() uses on this processor.
+ *\return avx512, avx2 or scalar.
+ */
+const char* synchronousRowKernel();
+
+#endif /* synchronousRow_hpp */
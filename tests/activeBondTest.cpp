@@ -0,0 +1,118 @@
+#include "VoterArray.hpp"
+#include "FixedVoterArray.hpp"
+#include "ParallelSweeper.hpp"
+#include "RejectionFreeEngine.hpp"
+#include "RandomEngine.hpp"
+#include "check.hpp"
+#include <memory>
+#include <string>
+
+/**
+ *\file
+ *\brief Checks the running magnetization and active bond count against a recount of the lattice.
+ *
+ * Every engine that changes the lattice keeps the counts up to date as it goes: single site updates,
+ * sequential, synchronous and parallel sweeps and the rejection free engine. After each round of
+ * changes the counts are recounted site by site, with stubborn voters present so that both kinds of
+ * site are covered, and must agree exactly.
+ */
+namespace
+{
+	/**
+	 *\brief Checks the order parameter, active bond density and frozen flag against a recount.
+	 */
+	void checkCounts(VoterArray &lattice, const std::string &what)
+	{
+		int rows = lattice.getRows();
+		int cols = lattice.getCols();
+		long long magnetization = 0;
+		long long activeBonds = 0;
+		long long mobileActiveBonds = 0;
+		for(int row = 0; row < rows; ++row)
+		{
+			for(int col = 0; col < cols; ++col)
+			{
+				VoterArray::State state = lattice(row, col);
+				magnetization += VoterArray::stateSymbols[state];
+
+				// Each site owns the bonds to its right and below.
+				VoterArray::State neighbours[2] = {lattice(row, (col + 1) % cols), lattice((row + 1) % rows, col)};
+				for(VoterArray::State neighbour : neighbours)
+				{
+					if((state & 1) != (neighbour & 1))
+					{
+						++activeBonds;
+						mobileActiveBonds += !((state >> 1) & 1) || !((neighbour >> 1) & 1);
+					}
+				}
+			}
+		}
+
+		double siteCount = static_cast<double>(rows) * cols;
+		if(!CHECK(lattice.orderParameter() == magnetization / siteCount &&
+		          lattice.activeBondDensity() == activeBonds / (2 * siteCount) &&
+		          lattice.frozen() == (mobileActiveBonds == 0)))
+		{
+			std::cerr << "  " << rows << 'x' << cols << " lattice after " << what << '\n';
+		}
+	}
+}
+
+int main()
+{
+	const int shapes[][2] = {{1, 9}, {7, 13}, {64, 64}, {40, 100}};
+	const VoterArray::Layout layouts[] = {VoterArray::RowMajor, VoterArray::Halo, VoterArray::Tiled, VoterArray::Morton};
+
+	for(const auto &shape : shapes)
+	{
+		for(auto layout : layouts)
+		{
+			RandomEngine generator(6);
+			std::unique_ptr<VoterArray> latticePointer = makeVoterArray(generator, shape[0], shape[1], 0.1, layout);
+			VoterArray &lattice = *latticePointer;
+			checkCounts(lattice, "construction");
+
+			for(int count = 0; count < shape[0] * shape[1] / 20; ++count)
+			{
+				std::uint64_t word = generator();
+				int row = static_cast<int>(takeBounded(word, shape[0]));
+				int col = static_cast<int>(takeBounded(word, shape[1]));
+				lattice.setState(row, col, takeBounded(word, 2) ? VoterArray::DemocratStubborn : VoterArray::RepublicanStubborn);
+			}
+			checkCounts(lattice, "placing stubborn voters");
+
+			for(int round = 0; round < 5; ++round)
+			{
+				for(int update = 0; update < shape[0] * shape[1]; ++update)
+				{
+					lattice.update(generator);
+				}
+				checkCounts(lattice, "single updates");
+
+				lattice.sweep(generator);
+				checkCounts(lattice, "a sweep");
+
+				lattice.synchronousSweep(generator);
+				checkCounts(lattice, "a synchronous sweep");
+			}
+
+			{
+				ParallelSweeper sweeper(lattice, 2, generator);
+				for(int round = 0; round < 5; ++round)
+				{
+					sweeper.sweep();
+					checkCounts(lattice, "a parallel sweep");
+				}
+			}
+
+			RejectionFreeEngine engine(lattice);
+			for(int round = 0; round < 5; ++round)
+			{
+				engine.advance(round + 1, generator);
+				checkCounts(lattice, "a rejection free sweep");
+			}
+		}
+	}
+
+	return checkResult();
+}
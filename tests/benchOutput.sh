@@ -0,0 +1,37 @@
+#!/bin/sh
+# Checks that a short run of the microbenchmarks gives every benchmark at every size, each with a
+# positive number of operations and a positive, finite time per operation. Run from the top directory
+# after make bench or make check has built voterBenchmark.
+
+work=$(mktemp -d) || exit 1
+trap 'rm -rf "$work"' EXIT
+
+if ! ./voterBenchmark 0.01 16 32 > "$work/bench.json" 2> /dev/null
+then
+	echo "  voterBenchmark failed"
+	exit 1
+fi
+
+# Seven benchmarks at each of the two sizes.
+awk -F'[:,] *' '
+	/"name"/ {
+		++count
+		for(field = 1; field < NF; ++field)
+		{
+			if($field ~ /"operations"$/) operations = $(field + 1)
+			if($field ~ /"nanosecondsPerOperation"$/) time = $(field + 1)
+		}
+		if(!(operations + 0 > 0) || !(time + 0 > 0) || time ~ /inf|nan/)
+		{
+			print "  degenerate result: " $0
+			bad = 1
+		}
+	}
+	END {
+		if(count != 14)
+		{
+			print "  expected 14 results, found " count
+			bad = 1
+		}
+		exit bad
+	}' "$work/bench.json"
@@ -0,0 +1,52 @@
+#ifndef check_hpp
+#define check_hpp
+
+#include <iostream>
+
+/**
+ *\file
+ *\brief Checks for the test programs in tests/, which make check builds and runs.
+ *
+ * A failed CHECK prints the condition and where it is and is counted, the program carries on so one
+ * run shows every failure. Each test returns checkResult() from main().
+ */
+
+/**
+ *\brief Number of failed checks so far.
+ */
+inline int& checkFailures()
+{
+	static int failures = 0;
+	return failures;
+}
+
+/**
+ *\brief Reports a failed check.
+ *\return whether the check passed.
+ */
+inline bool reportCheck(bool passed, const char *condition, const char *file, int line)
+{
+	if(!passed)
+	{
+		std::cerr << file << ':' << line << ": check failed: " << condition << '\n';
+		++checkFailures();
+	}
+	return passed;
+}
+
+/**
+ *\brief Exit status of a test, non zero if any check failed.
+ */
+inline int checkResult()
+{
+	if(checkFailures())
+	{
+		std::cerr << checkFailures() << " checks failed\n";
+		return 1;
+	}
+	return 0;
+}
+
+#define CHECK(condition) reportCheck((condition), #condition, __FILE__, __LINE__)
+
+#endif /* check_hpp */
@@ -0,0 +1,37 @@
+#!/bin/sh
+# Checks that a run stopped at a checkpoint and resumed writes the same order parameters and trajectory
+# as one that ran straight through, for each engine. Output appended after the checkpoint, as a crash
+# would leave, must be dropped on resume. Run from the top directory after make.
+
+voting=./voting
+work=$(mktemp -d) || exit 1
+trap 'rm -rf "$work"' EXIT
+
+status=0
+check()
+{
+	name=$1
+	shift
+	$voting -r 96 -c 64 -s 700 --seed 7 -a --frame-stride 50 --keep-running -o "$work/full_$name" "$@" > /dev/null || { echo "  $name: full run failed"; status=1; return; }
+	$voting -r 96 -c 64 -s 300 --seed 7 -a --frame-stride 50 --keep-running --checkpoint-interval 100 -o "$work/part_$name" "$@" > /dev/null || { echo "  $name: first part failed"; status=1; return; }
+	echo "garbage" >> "$work/part_$name/OrderParameter.dat"
+	$voting --resume "$work/part_$name" -s 700 > /dev/null || { echo "  $name: resume failed"; status=1; return; }
+
+	for file in OrderParameter.dat Trajectory.bin
+	do
+		if ! cmp -s "$work/full_$name/$file" "$work/part_$name/$file"
+		then
+			echo "  $name: $file differs after resuming"
+			status=1
+		fi
+	done
+}
+
+check sequential
+check halo -l halo
+check parallel -t 3
+check rejection-free -f
+check synchronous --synchronous
+check stubborn -n 300
+
+exit $status
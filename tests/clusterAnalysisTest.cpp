@@ -0,0 +1,105 @@
+#include "ClusterAnalysis.hpp"
+#include "RandomEngine.hpp"
+#include "check.hpp"
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+/**
+ *\file
+ *\brief Checks ClusterAnalysis against a flood fill of the same lattices.
+ *
+ * Random lattices of many shapes and densities, thin ones and those whose rows are not whole words
+ * included, are analysed both ways and must give the same number of domains, largest domain and
+ * histogram.
+ */
+namespace
+{
+	/**
+	 *\brief Finds the domains of a periodic lattice one site at a time with a flood fill.
+	 */
+	ClusterAnalysis::Result floodFill(const std::vector<int> &opinions, int rows, int cols, std::size_t binCount)
+	{
+		ClusterAnalysis::Result result;
+		result.histogram.assign(binCount, 0);
+
+		std::size_t siteCount = opinions.size();
+		std::vector<bool> seen(siteCount, false);
+		std::vector<std::size_t> stack;
+		for(std::size_t start = 0; start < siteCount; ++start)
+		{
+			if(seen[start])
+			{
+				continue;
+			}
+
+			std::size_t size = 0;
+			seen[start] = true;
+			stack.assign(1, start);
+			while(!stack.empty())
+			{
+				std::size_t site = stack.back();
+				stack.pop_back();
+				++size;
+
+				std::size_t row = site / cols;
+				std::size_t col = site % cols;
+				std::size_t neighbours[4] = {
+					row * cols + (col + 1) % cols,
+					row * cols + (col + cols - 1) % cols,
+					(row + 1) % rows * cols + col,
+					(row + rows - 1) % rows * cols + col};
+				for(std::size_t neighbour : neighbours)
+				{
+					if(!seen[neighbour] && opinions[neighbour] == opinions[start])
+					{
+						seen[neighbour] = true;
+						stack.push_back(neighbour);
+					}
+				}
+			}
+
+			++result.clusterCount;
+			++result.histogram[63 - __builtin_clzll(size)];
+			result.largest = std::max(result.largest, size);
+		}
+		return result;
+	}
+}
+
+int main()
+{
+	RandomEngine generator(1);
+	const int shapes[][2] = {{1, 1}, {1, 5}, {5, 1}, {2, 2}, {3, 3}, {7, 64}, {64, 7}, {65, 65}, {13, 130}, {100, 200}, {2, 129}, {1, 200}, {200, 1}};
+	for(const auto &shape : shapes)
+	{
+		int rows = shape[0];
+		int cols = shape[1];
+		std::size_t siteCount = static_cast<std::size_t>(rows) * cols;
+		ClusterAnalysis analysis(rows, cols);
+
+		for(int trial = 0; trial < 50; ++trial)
+		{
+			// Densities from all of one opinion to all of the other, through the percolation threshold.
+			double density = trial / 49.0;
+			std::vector<int> opinions(siteCount);
+			std::vector<std::uint64_t> frame((siteCount + 63) / 64, 0);
+			for(std::size_t site = 0; site < siteCount; ++site)
+			{
+				opinions[site] = generator.uniform() < density;
+				frame[site >> 6] |= static_cast<std::uint64_t>(opinions[site]) << (site & 63);
+			}
+
+			ClusterAnalysis::Result result;
+			analysis.analyse(frame, result);
+			ClusterAnalysis::Result expected = floodFill(opinions, rows, cols, analysis.getBinCount());
+
+			if(!CHECK(result.clusterCount == expected.clusterCount && result.largest == expected.largest && result.histogram == expected.histogram))
+			{
+				std::cerr << "  " << rows << 'x' << cols << " lattice at density " << density << '\n';
+			}
+		}
+	}
+
+	return checkResult();
+}
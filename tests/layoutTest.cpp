@@ -0,0 +1,133 @@
+#include "VoterArray.hpp"
+#include "FixedVoterArray.hpp"
+#include "RandomEngine.hpp"
+#include "check.hpp"
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+/**
+ *\file
+ *\brief Checks the neighbour indexing of every layout against a plain periodic grid.
+ *
+ * Each layout starts from the same random lattice and is given the same updates, whose outcome is
+ * worked out on a grid of opinions with the periodic boundaries applied by hand. The shapes include
+ * sides below, at and above the 8 site blocks of the Tiled and Morton layouts, and a row-major
+ * 64x64 lattice, which makeVoterArray() gives its fixed size specialisation.
+ */
+namespace
+{
+	const VoterArray::Layout layouts[] = {VoterArray::RowMajor, VoterArray::Halo, VoterArray::Tiled, VoterArray::Morton};
+	const char *layoutNames[] = {"row-major", "halo", "tiled", "morton"};
+
+	/**
+	 *\brief Checks a lattice against the grid of opinions and stubborn flags, row-major.
+	 */
+	bool matches(const VoterArray &lattice, const std::vector<int> &opinions, const std::vector<int> &stubborn)
+	{
+		int cols = lattice.getCols();
+		for(int row = 0; row < lattice.getRows(); ++row)
+		{
+			for(int col = 0; col < cols; ++col)
+			{
+				VoterArray::State state = lattice(row, col);
+				std::size_t site = static_cast<std::size_t>(row) * cols + col;
+				if((state & 1) != opinions[site] || ((state >> 1) & 1) != stubborn[site])
+				{
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+}
+
+int main()
+{
+	const int shapes[][2] = {{1, 9}, {3, 5}, {8, 8}, {9, 17}, {17, 9}, {2, 70}, {70, 2}, {33, 100}, {100, 33}, {64, 64}};
+	for(const auto &shape : shapes)
+	{
+		int rows = shape[0];
+		int cols = shape[1];
+		std::size_t siteCount = static_cast<std::size_t>(rows) * cols;
+
+		std::vector<std::unique_ptr<VoterArray>> lattices;
+		for(auto layout : layouts)
+		{
+			RandomEngine generator(3);
+			lattices.push_back(makeVoterArray(generator, rows, cols, 0.2, layout));
+		}
+
+		// The grid starts from the row-major lattice, with a few stubborn voters added to every layout.
+		RandomEngine generator(4);
+		std::vector<int> opinions(siteCount), stubborn(siteCount, 0);
+		for(std::size_t site = 0; site < siteCount; ++site)
+		{
+			opinions[site] = (*lattices[0])(static_cast<int>(site / cols), static_cast<int>(site % cols)) & 1;
+		}
+		for(int count = 0; count < rows * cols / 10; ++count)
+		{
+			std::uint64_t word = generator();
+			std::size_t site = takeBounded(word, siteCount);
+			stubborn[site] = 1;
+			for(auto &lattice : lattices)
+			{
+				lattice->setState(static_cast<int>(site / cols), static_cast<int>(site % cols), opinions[site] ? VoterArray::DemocratStubborn : VoterArray::RepublicanStubborn);
+			}
+		}
+
+		for(int round = 0; round < 20; ++round)
+		{
+			for(std::size_t update = 0; update < siteCount; ++update)
+			{
+				std::uint64_t word = generator();
+				int row = static_cast<int>(takeBounded(word, rows));
+				int col = static_cast<int>(takeBounded(word, cols));
+				int direction = static_cast<int>(takeBounded(word, 4));
+
+				for(auto &lattice : lattices)
+				{
+					VoterArray::Delta delta;
+					lattice->updateSite(row, col, direction, delta);
+					lattice->applyDelta(delta);
+				}
+
+				// 0 right, 1 down, 2 left and 3 up.
+				int neighbourRow = (row + (direction == 1) - (direction == 3) + rows) % rows;
+				int neighbourCol = (col + (direction == 0) - (direction == 2) + cols) % cols;
+				std::size_t site = static_cast<std::size_t>(row) * cols + col;
+				if(!stubborn[site])
+				{
+					opinions[site] = opinions[static_cast<std::size_t>(neighbourRow) * cols + neighbourCol];
+				}
+			}
+
+			// Sweeps draw the same random numbers whatever the layout, so the lattices stay equal.
+			for(auto &lattice : lattices)
+			{
+				RandomEngine sweepGenerator(5 + round);
+				lattice->sweep(sweepGenerator);
+			}
+			for(std::size_t site = 0; site < siteCount; ++site)
+			{
+				opinions[site] = (*lattices[0])(static_cast<int>(site / cols), static_cast<int>(site % cols)) & 1;
+			}
+
+			std::vector<std::uint64_t> frame, expectedFrame;
+			lattices[0]->packOpinions(expectedFrame);
+			for(std::size_t layout = 0; layout < lattices.size(); ++layout)
+			{
+				const VoterArray &lattice = *lattices[layout];
+				lattice.packOpinions(frame);
+				if(!CHECK(matches(lattice, opinions, stubborn) && frame == expectedFrame &&
+				          lattice.orderParameter() == lattices[0]->orderParameter() &&
+				          lattice.activeBondDensity() == lattices[0]->activeBondDensity()))
+				{
+					std::cerr << "  " << layoutNames[layout] << " layout, " << rows << 'x' << cols << " lattice, round " << round << '\n';
+				}
+			}
+		}
+	}
+
+	return checkResult();
+}
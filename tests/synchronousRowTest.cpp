@@ -0,0 +1,109 @@
+#include "synchronousRow.hpp"
+#include "RandomEngine.hpp"
+#include "check.hpp"
+#include <vector>
+#include <cstdint>
+#include <iostream>
+
+/**
+ *\file
+ *\brief Checks every synchronousRow() kernel the processor can run against the rule applied a site at a time.
+ *
+ * Rows of every length up to a few vector widths are updated so the vector loops and their scalar
+ * tails are all covered, with random opinions, directions and stubborn flags.
+ */
+namespace
+{
+	/**
+	 *\brief Reads bit c of a row, c can be -1 or 64*words for the bits beyond it.
+	 */
+	int bit(const std::uint64_t *words, long long c)
+	{
+		long long word = c < 0 ? -1 : c / 64;
+		return static_cast<int>((words[word] >> (c - 64 * word)) & 1);
+	}
+
+	/**
+	 *\brief New opinion of site c by the rule of synchronousRow().
+	 */
+	int expected(const std::uint64_t *row, const std::uint64_t *up, const std::uint64_t *down, const std::uint64_t *stubborn,
+		const std::uint64_t *high, const std::uint64_t *low, long long c)
+	{
+		if(bit(stubborn, c))
+		{
+			return bit(row, c);
+		}
+		switch(2 * bit(high, c) + bit(low, c))
+		{
+			case 0:
+				return bit(row, c + 1);
+			case 1:
+				return bit(down, c);
+			case 2:
+				return bit(row, c - 1);
+			default:
+				return bit(up, c);
+		}
+	}
+}
+
+int main()
+{
+	RandomEngine generator(2);
+	const char *kernels[] = {"scalar", "avx2", "avx512"};
+
+	for(std::size_t words = 1; words <= 40; ++words)
+	{
+		for(int trial = 0; trial < 20; ++trial)
+		{
+			// The row has a word either side for the neighbours of its first and last sites.
+			std::vector<std::uint64_t> padded(words + 2);
+			std::vector<std::uint64_t> up(words), down(words), stubborn(words), high(words), low(words);
+			for(auto &word : padded)
+			{
+				word = generator();
+			}
+			for(std::size_t w = 0; w < words; ++w)
+			{
+				up[w] = generator();
+				down[w] = generator();
+				high[w] = generator();
+				low[w] = generator();
+				// Some rows without stubborn voters, some with a few and some with many.
+				stubborn[w] = trial % 3 == 0 ? 0 : trial % 3 == 1 ? generator() & generator() & generator() : generator();
+			}
+			const std::uint64_t *row = padded.data() + 1;
+
+			std::vector<std::uint64_t> reference(words, 0);
+			for(long long c = 0; c < static_cast<long long>(64 * words); ++c)
+			{
+				reference[c / 64] |= static_cast<std::uint64_t>(expected(row, up.data(), down.data(), stubborn.data(), high.data(), low.data(), c)) << (c % 64);
+			}
+
+			for(const char *kernel : kernels)
+			{
+				std::vector<std::uint64_t> next(words, 0);
+				if(synchronousRowWith(kernel, row, up.data(), down.data(), stubborn.data(), high.data(), low.data(), next.data(), words) &&
+				   !CHECK(next == reference))
+				{
+					std::cerr << "  " << kernel << " kernel on a row of " << words << " words\n";
+				}
+			}
+
+			std::vector<std::uint64_t> next(words, 0);
+			synchronousRow(row, up.data(), down.data(), stubborn.data(), high.data(), low.data(), next.data(), words);
+			CHECK(next == reference);
+		}
+	}
+
+	for(const char *kernel : kernels)
+	{
+		std::uint64_t word = 0;
+		if(!synchronousRowWith(kernel, &word, &word, &word, &word, &word, &word, &word, 0))
+		{
+			std::cout << "  " << kernel << " kernel not supported here, not checked\n";
+		}
+	}
+
+	return checkResult();
+}
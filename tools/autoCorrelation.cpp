@@ -0,0 +1,97 @@
+#include "DataArray.hpp"
+#include "RunningStatistics.hpp"
+#include "ObservableFunctors.hpp"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <cstdlib>
+#include <cmath>
+#include <thread>
+#include <algorithm> // For std::min.
+
+/**
+ *\file
+ *\brief Prints the autocorrelation function and error estimates of an order parameter trace.
+ *
+ * Usage: autoCorrelation <OrderParameter.dat> [discard] [lags] [sites]
+ *
+ * The first discard sweeps (default 0) are left out as equilibration. The summary, the mean with its
+ * naive and blocking errors, the integrated autocorrelation time from the blocking analysis and from
+ * the windowed autocorrelation function, and the susceptibility and Binder cumulant with blocked
+ * jackknife errors, is printed as comment lines followed by the autocorrelation function for the first
+ * lags times (default 100). The susceptibility is per site unless the number of sites is given.
+ */
+int main(int argc, char const *argv[])
+{
+    if(argc < 2 || argc > 5)
+    {
+        std::cerr << "Usage: " << argv[0] << " <OrderParameter.dat> [discard] [lags] [sites]\n";
+        return 1;
+    }
+
+    std::ifstream input(argv[1]);
+    if(!input)
+    {
+        std::cerr << "Cannot open " << argv[1] << '\n';
+        return 1;
+    }
+
+    long long discard = argc > 2 ? std::atoll(argv[2]) : 0;
+    int lags = argc > 3 ? std::atoi(argv[3]) : 100;
+    double sites = argc > 4 ? std::atof(argv[4]) : 1;
+
+    DataArray trace;
+    RunningStatistics statistics;
+
+    // The order parameter is the second column, any further columns (the active bond density) are skipped.
+    std::string line;
+    while(std::getline(input, line))
+    {
+        std::istringstream fields(line);
+        long long sweep;
+        double orderParameter;
+        if(!(fields >> sweep >> orderParameter))
+        {
+            break;
+        }
+        if(sweep >= discard)
+        {
+            trace.push_back(orderParameter);
+            statistics.push(orderParameter);
+        }
+    }
+
+    if(trace.getSize() < 2)
+    {
+        std::cerr << "Too few samples after discarding " << discard << " sweeps\n";
+        return 1;
+    }
+
+    std::cout << "# samples " << statistics.getCount() << '\n';
+    std::cout << "# mean " << statistics.mean() << '\n';
+    std::cout << "# naive-error " << statistics.error() << '\n';
+    std::cout << "# blocking-error " << statistics.blockingError() << '\n';
+    std::cout << "# blocking-tau " << statistics.autoCorrelationTime() << '\n';
+    double tau = trace.integratedAutoCorrelationTime();
+    std::cout << "# windowed-tau " << tau << '\n';
+
+    // Blocks of several autocorrelation times are close enough to independent for the jackknife. The
+    // size is clamped to the trace before the conversion, as a value outside int cannot be converted.
+    double window = std::isfinite(tau) ? std::ceil(10 * tau) : 1;
+    int blockSize = static_cast<int>(std::min(std::max(window, 1.0), static_cast<double>(trace.getSize())));
+    int threadCount = std::max(1u, std::thread::hardware_concurrency());
+    SusceptibilityFunctor susceptibility(sites);
+    BinderCumulantFunctor binderCumulant;
+    std::cout << "# jackknife-block " << blockSize << '\n';
+    std::cout << "# susceptibility " << susceptibility(trace) << ' ' << trace.jackknifeError(susceptibility, blockSize, threadCount) << '\n';
+    std::cout << "# binder-cumulant " << binderCumulant(trace) << ' ' << trace.jackknifeError(binderCumulant, blockSize, threadCount) << '\n';
+
+    std::vector<double> autoCorrelation = trace.autoCorrelation(0, static_cast<int>(std::min<std::size_t>(lags, trace.getSize())));
+    for(std::size_t t = 0; t < autoCorrelation.size(); ++t)
+    {
+        std::cout << t << ' ' << autoCorrelation[t] << '\n';
+    }
+
+    return 0;
+}
@@ -0,0 +1,68 @@
+#include "VoterArray.hpp"
+#include "RandomEngine.hpp"
+#include "Timer.hpp"
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <cstdlib>
+
+/**
+ *\file
+ *\brief Compares the update throughput of the lattice layouts at several lattice sizes.
+ *
+ * Usage: layoutBenchmark [updates] [length...]
+ *
+ * For every square lattice length, 256 1024 4096 and 16384 by default, and every layout a lattice is
+ * built and the given number of random sequential updates, 2^24 by default, are timed through
+ * VoterArray::update(). The sites are spread over the whole lattice so on the large lattices the time
+ * is dominated by the cache and TLB misses of the site and its vertical neighbour.
+ */
+int main(int argc, char const *argv[])
+{
+    long long updates = argc > 1 ? std::atoll(argv[1]) : 1LL << 24;
+    std::vector<int> lengths;
+    for(int arg = 2; arg < argc; ++arg)
+    {
+        lengths.push_back(std::atoi(argv[arg]));
+    }
+    if(lengths.empty())
+    {
+        lengths = {256, 1024, 4096, 16384};
+    }
+
+    if(updates < 1)
+    {
+        std::cerr << "Usage: " << argv[0] << " [updates] [length...]\n";
+        return 1;
+    }
+
+    const VoterArray::Layout layouts[] = {VoterArray::RowMajor, VoterArray::Halo, VoterArray::Tiled, VoterArray::Morton};
+
+    std::cout << "# length layout updates seconds updates-per-second\n";
+    for(int length : lengths)
+    {
+        for(VoterArray::Layout layout : layouts)
+        {
+            RandomEngine generator(12345);
+            VoterArray lattice(generator, length, length, 0.0, layout);
+
+            // Touch the lattice once so the first timed updates do not pay for faulting in the pages.
+            for(long long update = 0; update < updates / 16; ++update)
+            {
+                lattice.update(generator);
+            }
+
+            Timer timer;
+            for(long long update = 0; update < updates; ++update)
+            {
+                lattice.update(generator);
+            }
+            double seconds = timer.elapsed();
+
+            std::cout << length << ' ' << layout << ' ' << updates << ' ' << seconds << ' '
+                      << std::setprecision(4) << updates / seconds << std::setprecision(6) << std::endl;
+        }
+    }
+
+    return 0;
+}
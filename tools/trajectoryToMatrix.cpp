@@ -0,0 +1,58 @@
+#include "Trajectory.hpp"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstdlib>
+
+/**
+ *\file
+ *\brief Converts a frame of a binary trajectory into the text matrix read by animate.gp.
+ *
+ * Usage: trajectoryToMatrix <trajectory> [frame] [output]
+ *
+ * The frame defaults to the last one, negative frames count back from the end. The matrix is written
+ * to the output file if one is given and to standard output otherwise.
+ */
+int main(int argc, char const *argv[])
+{
+    if(argc < 2 || argc > 4)
+    {
+        std::cerr << "Usage: " << argv[0] << " <trajectory> [frame] [output]\n";
+        return 1;
+    }
+
+    try
+    {
+        TrajectoryReader trajectory(argv[1]);
+
+        long long frameCount = static_cast<long long>(trajectory.getFrameCount());
+        long long frame = argc > 2 ? std::atoll(argv[2]) : -1;
+        if(frame < 0)
+        {
+            frame += frameCount;
+        }
+
+        if(frame < 0 || frame >= frameCount)
+        {
+            std::cerr << "Frame out of range, the trajectory has " << frameCount << " frames\n";
+            return 1;
+        }
+
+        if(argc > 3)
+        {
+            std::fstream latticeOutput(argv[3], std::ios::out);
+            trajectory.printMatrix(latticeOutput, static_cast<std::size_t>(frame));
+        }
+        else
+        {
+            trajectory.printMatrix(std::cout, static_cast<std::size_t>(frame));
+        }
+    }
+    catch(const std::exception &error)
+    {
+        std::cerr << error.what() << '\n';
+        return 1;
+    }
+
+    return 0;
+}